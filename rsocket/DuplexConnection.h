@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 
 #include <folly/io/IOBuf.h>
@@ -58,6 +59,16 @@ class DuplexConnection {
   virtual bool isFramed() const {
     return false;
   }
+
+  /// Sets a function told when the connection stops and starts taking more
+  /// writes.  It is called with false once the bytes waiting to be written
+  /// exceed the connection's high-water mark, and with true once they fall to
+  /// its low-water mark.  It is never called from within send(): changes are
+  /// reported from the connection's event loop, so the callback may send or
+  /// close the connection.
+  ///
+  /// Connections without a bounded write buffer never call it.
+  virtual void setWritabilityCallback(std::function<void(bool writable)>) {}
 };
 
 } // namespace rsocket
@@ -0,0 +1,58 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace rsocket {
+
+struct Payload;
+
+/// How a stream's outbound frames compete with those of other streams.
+struct StreamPriority {
+  /// Streams in a lower class are served first.  Streams in a higher class
+  /// only get to write while no stream in a lower class has frames waiting.
+  uint8_t priorityClass{0};
+
+  /// Share of the connection a stream gets relative to the other streams of
+  /// its class.
+  uint32_t weight{1};
+};
+
+/// Scheduling of the frames streams send on a connection.
+///
+/// Frames normally go out in the order streams write them.  With scheduling
+/// enabled, frames that streams write while the connection is not taking
+/// writes wait in per-stream queues, which are served by deficit round-robin
+/// once it does.  A stream sending large or fragmented payloads then can't
+/// starve the others.  Only connections with a bounded write buffer stop
+/// taking writes, see TcpDuplexConnection::Options::writeHighWaterMark.
+///
+/// REQUEST_N, CANCEL and connection-level frames are never queued.  ERROR
+/// frames only wait behind frames of their own stream.
+struct FrameSchedulingPolicy {
+  bool enabled{false};
+
+  /// Bytes a stream of weight 1 may write in each round.
+  size_t quantum{16 * 1024};
+
+  /// Picks the priority of a stream from the payload opening it, typically
+  /// from its metadata.  All streams get the default priority without it.
+  std::function<StreamPriority(const Payload&)> classify;
+};
+
+} // namespace rsocket
@@ -0,0 +1,54 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/LatencyStats.h"
+
+namespace rsocket {
+
+constexpr size_t LatencyStats::kFrameTypes;
+
+void LatencyStats::Snapshot::merge(const Snapshot& other) {
+  requestResponse.merge(other.requestResponse);
+  streamFirstPayload.merge(other.streamFirstPayload);
+  for (size_t i = 0; i < kFrameTypes; ++i) {
+    frameProcessing[i].merge(other.frameProcessing[i]);
+  }
+}
+
+LatencyStats::Snapshot LatencyStats::snapshot() const {
+  Snapshot snapshot;
+  snapshot.requestResponse = requestResponse_.snapshot();
+  snapshot.streamFirstPayload = streamFirstPayload_.snapshot();
+  for (size_t i = 0; i < kFrameTypes; ++i) {
+    snapshot.frameProcessing[i] = frameProcessing_[i].snapshot();
+  }
+  return snapshot;
+}
+
+void LatencyStats::frameProcessed(
+    FrameType frameType,
+    std::chrono::nanoseconds latency) {
+  frameProcessing_[frameTypeIndex(frameType)].record(latency);
+}
+
+void LatencyStats::requestResponseLatency(std::chrono::nanoseconds latency) {
+  requestResponse_.record(latency);
+}
+
+void LatencyStats::streamFirstPayloadLatency(
+    std::chrono::nanoseconds latency) {
+  streamFirstPayload_.record(latency);
+}
+
+} // namespace rsocket
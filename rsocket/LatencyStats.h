@@ -0,0 +1,70 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+
+#include "rsocket/RSocketStats.h"
+#include "rsocket/internal/LatencyHistogram.h"
+
+namespace rsocket {
+
+/// RSocketStats that keep latency histograms of request-response round trips,
+/// of the time to the first payload of streams and channels, and of the time
+/// spent processing each type of received frame.
+///
+/// One instance is meant to be shared by many connections and threads.
+/// Recording takes no locks, and snapshot() can be called at any time.
+class LatencyStats : public RSocketStats {
+ public:
+  /// Frame types up to RESUME_OK have their own histogram, the rest share the
+  /// last one.
+  static constexpr size_t kFrameTypes = 16;
+
+  static size_t frameTypeIndex(FrameType type) {
+    auto const index = static_cast<size_t>(type);
+    return index < kFrameTypes - 1 ? index : kFrameTypes - 1;
+  }
+
+  struct Snapshot {
+    LatencyHistogram::Snapshot requestResponse;
+    LatencyHistogram::Snapshot streamFirstPayload;
+
+    /// Indexed by frameTypeIndex().
+    std::array<LatencyHistogram::Snapshot, kFrameTypes> frameProcessing;
+
+    const LatencyHistogram::Snapshot& frameProcessed(FrameType type) const {
+      return frameProcessing[frameTypeIndex(type)];
+    }
+
+    void merge(const Snapshot&);
+  };
+
+  Snapshot snapshot() const;
+
+  bool latenciesEnabled() const override {
+    return true;
+  }
+  void frameProcessed(FrameType, std::chrono::nanoseconds) override;
+  void requestResponseLatency(std::chrono::nanoseconds) override;
+  void streamFirstPayloadLatency(std::chrono::nanoseconds) override;
+
+ private:
+  LatencyHistogram requestResponse_;
+  LatencyHistogram streamFirstPayload_;
+  std::array<LatencyHistogram, kFrameTypes> frameProcessing_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,66 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace rsocket {
+
+/// A budget of new requests that a responder grants to a requester.  The
+/// requester may start up to `numberOfRequests` new streams within `ttl` of
+/// receiving the lease.
+struct Lease {
+  std::chrono::milliseconds ttl{0};
+  uint32_t numberOfRequests{0};
+};
+
+/// Server-side lease policy.  Used only on connections whose SETUP frame
+/// asked for leases.  Methods are called on the connection's EventBase.
+class LeaseSender {
+ public:
+  virtual ~LeaseSender() = default;
+
+  /// Returns the next lease to grant to the peer.  Called once the connection
+  /// is set up and again every time the previous lease expires, so `ttl` has
+  /// to be positive.  A lease with no requests is not sent, and the peer can't
+  /// start any request until a later one is.
+  virtual Lease nextLease() = 0;
+};
+
+/// Grants the same lease every time, which caps each connection at
+/// `numberOfRequests` new requests per `ttl`.
+class FixedLeaseSender : public LeaseSender {
+ public:
+  explicit FixedLeaseSender(Lease lease) : lease_{lease} {}
+
+  Lease nextLease() override {
+    return lease_;
+  }
+
+ private:
+  const Lease lease_;
+};
+
+/// Client-side observer of the leases granted by the server.  Called on the
+/// connection's EventBase.
+class LeaseReceiver {
+ public:
+  virtual ~LeaseReceiver() = default;
+
+  virtual void onLease(const Lease&) = 0;
+};
+
+} // namespace rsocket
@@ -130,6 +130,11 @@ std::unique_ptr<RSocketClient> RSocket::createClientFromConnection(
   return client;
 }
 
+folly::Future<std::unique_ptr<RSocketClientPool>> RSocket::createClientPool(
+    RSocketClientPool::Options options) {
+  return RSocketClientPool::create(std::move(options));
+}
+
 std::unique_ptr<RSocketServer> RSocket::createServer(
     std::unique_ptr<ConnectionAcceptor> connectionAcceptor,
     std::shared_ptr<RSocketStats> stats) {
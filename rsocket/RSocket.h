@@ -15,6 +15,7 @@
 #pragma once
 
 #include "rsocket/RSocketClient.h"
+#include "rsocket/RSocketClientPool.h"
 #include "rsocket/RSocketServer.h"
 
 namespace rsocket {
@@ -72,6 +73,11 @@ class RSocket {
       std::shared_ptr<ColdResumeHandler> coldResumeHandler = nullptr,
       folly::EventBase* stateMachineEvb = nullptr);
 
+  // Creates a pool of connected clients, see RSocketClientPool.  The future
+  // fails only if none of the pool's connections could be made.
+  static folly::Future<std::unique_ptr<RSocketClientPool>> createClientPool(
+      RSocketClientPool::Options options);
+
   // A convenience function to create RSocketServer
   static std::unique_ptr<RSocketServer> createServer(
       std::unique_ptr<ConnectionAcceptor>,
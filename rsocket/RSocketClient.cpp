@@ -69,6 +69,10 @@ bool RSocketClient::isDisconnected() const {
   return stateMachine_->isDisconnected();
 }
 
+size_t RSocketClient::activeStreams() const {
+  return stateMachine_->activeStreams();
+}
+
 folly::Future<folly::Unit> RSocketClient::resume() {
   CHECK(connectionFactory_)
       << "The client was likely created without ConnectionFactory. Can't "
@@ -185,6 +189,9 @@ void RSocketClient::fromConnection(
     evb_ = &transportEvb;
   }
   createState();
+  stateMachine_->setRequestNPolicy(params.requestNPolicy, *evb_);
+  stateMachine_->setReassemblyLimits(params.reassemblyLimits);
+  stateMachine_->setFrameSchedulingPolicy(params.frameScheduling);
 
   std::unique_ptr<DuplexConnection> framed;
   if (connection->isFramed()) {
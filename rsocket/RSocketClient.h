@@ -51,6 +51,10 @@ class RSocketClient {
   // Returns if this client is currently disconnected
   bool isDisconnected() const;
 
+  // Returns the number of streams open on the client's connection.  Can be
+  // called from any thread.
+  size_t activeStreams() const;
+
   // Resumes the client's connection.  If the client was previously connected
   // this will attempt a warm-resumption.  Otherwise this will attempt a
   // cold-resumption.
@@ -0,0 +1,347 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/RSocketClientPool.h"
+
+#include <atomic>
+
+#include <folly/Random.h>
+#include <folly/Synchronized.h>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/RSocketConnectionEvents.h"
+
+namespace rsocket {
+
+namespace {
+
+/// A copy of the setup parameters for one of the pool's connections.
+SetupParameters copySetupParameters(const SetupParameters& params) {
+  SetupParameters copy{params.metadataMimeType,
+                       params.dataMimeType,
+                       params.payload.clone(),
+                       params.resumable,
+                       ResumeIdentificationToken::generateNew(),
+                       params.protocolVersion};
+  copy.lease = params.lease;
+  copy.leaseReceiver = params.leaseReceiver;
+  copy.requestNPolicy = params.requestNPolicy;
+  copy.reassemblyLimits = params.reassemblyLimits;
+  copy.frameScheduling = params.frameScheduling;
+  return copy;
+}
+
+} // namespace
+
+class RSocketClientPool::State
+    : public std::enable_shared_from_this<RSocketClientPool::State> {
+ public:
+  explicit State(Options options) : options_{std::move(options)} {
+    CHECK(!options_.factories.empty()) << "a client pool needs a factory";
+    CHECK_GT(options_.connections, 0u);
+    for (size_t i = 0; i < options_.connections; ++i) {
+      slots_.push_back(std::make_unique<Slot>(
+          options_.factories[i % options_.factories.size()]));
+    }
+  }
+
+  size_t size() const {
+    return slots_.size();
+  }
+
+  /// Connect the given slot.  Resolves to whether it connected; if it didn't,
+  /// the slot is retried later.
+  folly::Future<bool> connect(size_t index) {
+    auto events = std::make_shared<Events>(shared_from_this(), index);
+    slots_[index]->connection.wlock()->events = events;
+
+    return RSocket::createConnectedClient(
+               slots_[index]->factory,
+               copySetupParameters(options_.setupParameters),
+               options_.responder,
+               options_.keepaliveInterval,
+               options_.stats,
+               events)
+        .thenValue([self = shared_from_this(), index, events](
+                       std::unique_ptr<RSocketClient> client) {
+          std::shared_ptr<RSocketClient> replaced{std::move(client)};
+          {
+            auto connection = self->slots_[index]->connection.wlock();
+            if (connection->events == events && !self->closed_) {
+              std::swap(connection->client, replaced);
+            }
+          }
+          // Destroy the client this one replaces, or this one if the pool
+          // closed or moved on, outside of the lock.
+          replaced.reset();
+          return true;
+        })
+        .onError([self = shared_from_this(), index, events](
+                     folly::exception_wrapper ex) {
+          VLOG(2) << "Pool connection " << index
+                  << " failed to connect: " << ex.what();
+          self->reconnectLater(index, events.get());
+          return false;
+        });
+  }
+
+  /// Replace the given slot's connection after a delay, unless it has been
+  /// replaced already.
+  void reconnectLater(size_t index, const void* events) {
+    if (closed_) {
+      return;
+    }
+    {
+      auto connection = slots_[index]->connection.wlock();
+      if (connection->events.get() != events) {
+        return;
+      }
+      connection->events.reset();
+    }
+
+    std::weak_ptr<State> weak = shared_from_this();
+    folly::futures::sleep(options_.reconnectDelay)
+        .thenValue([weak, index](folly::Unit) {
+          if (auto self = weak.lock()) {
+            if (!self->closed_) {
+              self->connect(index);
+            }
+          }
+        });
+  }
+
+  /// The client to send the next request on, or null if none is up.
+  std::shared_ptr<RSocketClient> pick() {
+    if (options_.balancing == Balancing::POWER_OF_TWO_CHOICES &&
+        slots_.size() > 2) {
+      // Two distinct slots drawn at random from a per-thread generator, so
+      // that threads picking at once don't contend on next_.
+      folly::ThreadLocalPRNG rng;
+      auto const size = static_cast<uint32_t>(slots_.size());
+      auto const i = folly::Random::rand32(size, rng);
+      auto const j = (i + 1 + folly::Random::rand32(size - 1, rng)) % size;
+      auto first = client(i);
+      auto second = client(j);
+      if (first && second) {
+        return second->activeStreams() < first->activeStreams() ? second
+                                                                : first;
+      }
+      if (first || second) {
+        return first ? first : second;
+      }
+      // Both are down, look for any connection that is up.
+    }
+
+    auto const start = next_.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<RSocketClient> best;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      auto candidate = client((start + i) % slots_.size());
+      if (candidate &&
+          (!best || candidate->activeStreams() < best->activeStreams())) {
+        best = std::move(candidate);
+      }
+    }
+    return best;
+  }
+
+  /// All clients that are up.
+  std::vector<std::shared_ptr<RSocketClient>> clients() {
+    std::vector<std::shared_ptr<RSocketClient>> result;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      if (auto up = client(i)) {
+        result.push_back(std::move(up));
+      }
+    }
+    return result;
+  }
+
+  void close() {
+    closed_ = true;
+    std::vector<std::shared_ptr<RSocketClient>> clients;
+    for (auto& slot : slots_) {
+      auto connection = slot->connection.wlock();
+      connection->events.reset();
+      clients.push_back(std::move(connection->client));
+    }
+    // Clients close their connections as they're destroyed.
+    clients.clear();
+  }
+
+ private:
+  /// Follows one connection of a slot.
+  class Events : public RSocketConnectionEvents {
+   public:
+    Events(std::weak_ptr<State> state, size_t index)
+        : state_{std::move(state)}, index_{index} {}
+
+    void onConnected() override {
+      up = true;
+    }
+
+    void onDisconnected(const folly::exception_wrapper&) override {
+      up = false;
+    }
+
+    void onClosed(const folly::exception_wrapper&) override {
+      up = false;
+      if (auto state = state_.lock()) {
+        state->reconnectLater(index_, this);
+      }
+    }
+
+    std::atomic<bool> up{false};
+
+   private:
+    const std::weak_ptr<State> state_;
+    const size_t index_;
+  };
+
+  struct Slot {
+    explicit Slot(std::shared_ptr<ConnectionFactory> f)
+        : factory{std::move(f)} {}
+
+    struct Connection {
+      std::shared_ptr<RSocketClient> client;
+
+      /// Events of the slot's latest connection attempt.  Null while the
+      /// slot waits to reconnect.
+      std::shared_ptr<Events> events;
+    };
+
+    const std::shared_ptr<ConnectionFactory> factory;
+    folly::Synchronized<Connection> connection;
+  };
+
+  /// The given slot's client, if it is up.
+  std::shared_ptr<RSocketClient> client(size_t index) {
+    auto connection = slots_[index]->connection.rlock();
+    if (connection->client && connection->events && connection->events->up) {
+      return connection->client;
+    }
+    return nullptr;
+  }
+
+  const Options options_;
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::atomic<size_t> next_{0};
+  std::atomic<bool> closed_{false};
+};
+
+/// Sends each request on one of the pool's connections.
+class RSocketClientPool::Requester : public RSocketRequester {
+ public:
+  explicit Requester(std::shared_ptr<State> state)
+      : state_{std::move(state)} {}
+
+  using RSocketRequester::requestChannel;
+
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> requestStream(
+      Payload request) override {
+    if (auto client = state_->pick()) {
+      return client->getRequester()->requestStream(std::move(request));
+    }
+    return yarpl::flowable::Flowable<Payload>::error(noConnection());
+  }
+
+  std::shared_ptr<yarpl::single::Single<Payload>> requestResponse(
+      Payload request) override {
+    if (auto client = state_->pick()) {
+      return client->getRequester()->requestResponse(std::move(request));
+    }
+    return yarpl::single::Singles::error<Payload>(noConnection());
+  }
+
+  std::shared_ptr<yarpl::single::Single<void>> fireAndForget(
+      Payload request) override {
+    if (auto client = state_->pick()) {
+      return client->getRequester()->fireAndForget(std::move(request));
+    }
+    return yarpl::single::Singles::error<void>(noConnection());
+  }
+
+  /// Metadata is connection-level, so it is pushed on every connection that
+  /// is up.
+  void metadataPush(std::unique_ptr<folly::IOBuf> metadata) override {
+    for (auto& client : state_->clients()) {
+      client->getRequester()->metadataPush(metadata->clone());
+    }
+  }
+
+  void closeSocket() override {
+    state_->close();
+  }
+
+ protected:
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> requestChannel(
+      Payload request,
+      bool hasInitialRequest,
+      std::shared_ptr<yarpl::flowable::Flowable<Payload>> requests) override {
+    auto client = state_->pick();
+    if (!client) {
+      return yarpl::flowable::Flowable<Payload>::error(noConnection());
+    }
+    auto& requester = *client->getRequester();
+    return hasInitialRequest
+        ? requester.requestChannel(std::move(request), std::move(requests))
+        : requester.requestChannel(std::move(requests));
+  }
+
+ private:
+  static folly::exception_wrapper noConnection() {
+    return std::runtime_error("No connection of the client pool is up");
+  }
+
+  const std::shared_ptr<State> state_;
+};
+
+RSocketClientPool::RSocketClientPool(std::shared_ptr<State> state)
+    : state_{std::move(state)},
+      requester_{std::make_shared<Requester>(state_)} {}
+
+RSocketClientPool::~RSocketClientPool() {
+  VLOG(3) << "~RSocketClientPool ..";
+  state_->close();
+}
+
+const std::shared_ptr<RSocketRequester>& RSocketClientPool::getRequester()
+    const {
+  return requester_;
+}
+
+size_t RSocketClientPool::connected() const {
+  return state_->clients().size();
+}
+
+folly::Future<std::unique_ptr<RSocketClientPool>> RSocketClientPool::create(
+    Options options) {
+  auto state = std::make_shared<State>(std::move(options));
+
+  std::vector<folly::Future<bool>> connections;
+  for (size_t i = 0; i < state->size(); ++i) {
+    connections.push_back(state->connect(i));
+  }
+
+  return folly::collectAll(connections)
+      .thenValue([state](std::vector<folly::Try<bool>> results) {
+        for (auto& result : results) {
+          if (result.hasValue() && result.value()) {
+            return std::unique_ptr<RSocketClientPool>(
+                new RSocketClientPool(state));
+          }
+        }
+        state->close();
+        throw std::runtime_error("No connection of the client pool came up");
+      });
+}
+} // namespace rsocket
@@ -0,0 +1,108 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/futures/Future.h>
+
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/RSocketClient.h"
+#include "rsocket/RSocketParameters.h"
+#include "rsocket/RSocketRequester.h"
+#include "rsocket/RSocketResponder.h"
+#include "rsocket/RSocketStats.h"
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+class RSocket;
+
+/**
+ * A set of client connections used as one.  Created with RSocket class.
+ *
+ * A client's connection is driven by a single EventBase, so it can use at
+ * most one core for its IO.  A pool keeps several connections, possibly to
+ * several servers and on different EventBases, and sends each request on
+ * the connection with the fewest open streams.
+ *
+ * Connections that close are replaced rather than resumed.  Requests made
+ * while no connection is up fail.
+ */
+class RSocketClientPool {
+ public:
+  enum class Balancing {
+    // Look at every connection for the one with the fewest streams.
+    LEAST_LOADED,
+    // Take the less loaded of two connections picked at random, which costs
+    // the same however large the pool is.
+    POWER_OF_TWO_CHOICES,
+  };
+
+  struct Options {
+    // Number of connections to keep open.
+    size_t connections{4};
+
+    // Factories to connect with.  Connections are spread over them
+    // round-robin, e.g. to connect to several servers.
+    std::vector<std::shared_ptr<ConnectionFactory>> factories;
+
+    // Setup sent on every connection.  Each connection gets a resume token
+    // of its own.
+    SetupParameters setupParameters;
+
+    std::shared_ptr<RSocketResponder> responder{
+        std::make_shared<RSocketResponder>()};
+    std::chrono::milliseconds keepaliveInterval{kDefaultKeepaliveInterval};
+    std::shared_ptr<RSocketStats> stats{RSocketStats::noop()};
+
+    Balancing balancing{Balancing::LEAST_LOADED};
+
+    // How long to wait before replacing a connection that closed or failed
+    // to connect.
+    std::chrono::milliseconds reconnectDelay{std::chrono::seconds{1}};
+  };
+
+  ~RSocketClientPool();
+
+  RSocketClientPool(const RSocketClientPool&) = delete;
+  RSocketClientPool& operator=(const RSocketClientPool&) = delete;
+
+  friend class RSocket;
+
+  // Returns a requester that sends each request on one of the pool's
+  // connections.
+  const std::shared_ptr<RSocketRequester>& getRequester() const;
+
+  // Returns the number of connections that are currently up.
+  size_t connected() const;
+
+ private:
+  class State;
+  class Requester;
+
+  explicit RSocketClientPool(std::shared_ptr<State>);
+
+  // Connects all of the pool's connections.  The future completes once each
+  // has connected or failed, and only fails if none connected.  Failed
+  // connections are retried in the background.
+  static folly::Future<std::unique_ptr<RSocketClientPool>> create(Options);
+
+  std::shared_ptr<State> state_;
+  std::shared_ptr<RSocketRequester> requester_;
+};
+} // namespace rsocket
@@ -129,4 +129,20 @@ class ConnectionCloseError : public RSocketError {
     return "CONNECTION_CLOSE";
   }
 };
+
+/**
+ * Error Code: REJECTED 0x00000202
+ */
+class RejectedError : public RSocketError {
+ public:
+  using RSocketError::RSocketError;
+
+  int getErrorCode() const override {
+    return 0x00000202;
+  }
+
+  const char* what() const noexcept override {
+    return "REJECTED";
+  }
+};
 } // namespace rsocket
@@ -24,6 +24,7 @@ std::ostream& operator<<(
             << " dataMimeType: " << setupPayload.dataMimeType
             << " payload: " << setupPayload.payload
             << " token: " << setupPayload.token
-            << " resumable: " << setupPayload.resumable;
+            << " resumable: " << setupPayload.resumable
+            << " lease: " << setupPayload.lease;
 }
 } // namespace rsocket
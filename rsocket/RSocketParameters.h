@@ -16,10 +16,15 @@
 
 #include <functional>
 #include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "rsocket/FrameSchedulingPolicy.h"
+#include "rsocket/Lease.h"
 #include "rsocket/Payload.h"
+#include "rsocket/ReassemblyLimits.h"
+#include "rsocket/RequestNPolicy.h"
 #include "rsocket/framing/Frame.h"
 
 namespace rsocket {
@@ -56,6 +61,25 @@ class SetupParameters : public RSocketParameters {
   std::string dataMimeType;
   Payload payload;
   ResumeIdentificationToken token;
+
+  /// Whether the client honors leases.  A client that sets this can't start
+  /// any request until the server grants it a lease.
+  bool lease{false};
+
+  /// Client only.  Notified of every lease the server grants.
+  std::shared_ptr<LeaseReceiver> leaseReceiver;
+
+  /// Client only.  How streams on this connection grant credits to the
+  /// server.
+  RequestNPolicy requestNPolicy;
+
+  /// Client only.  How much the client may hold of the fragmented payloads
+  /// the server sends.
+  ReassemblyLimits reassemblyLimits;
+
+  /// Client only.  How the client's streams share the connection while it
+  /// is not taking writes.
+  FrameSchedulingPolicy frameScheduling;
 };
 
 std::ostream& operator<<(std::ostream&, const SetupParameters&);
@@ -119,6 +119,11 @@ class RSocketRequester {
   virtual void closeSocket();
 
  protected:
+  /// For requesters that hand requests to other requesters instead of
+  /// sending them on a connection of their own.  Such a requester must
+  /// override every request method, and closeSocket().
+  RSocketRequester() = default;
+
   virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
   requestChannel(
       Payload request,
@@ -126,6 +131,6 @@ class RSocketRequester {
       std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>> requests);
 
   std::shared_ptr<rsocket::RSocketStateMachine> stateMachine_;
-  folly::EventBase* eventBase_;
+  folly::EventBase* eventBase_{nullptr};
 };
 } // namespace rsocket
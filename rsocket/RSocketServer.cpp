@@ -97,6 +97,14 @@ void RSocketServer::setSingleThreadedResponder() {
   useScheduledResponder_ = false;
 }
 
+void RSocketServer::setThreadPerCore() {
+  CHECK(!started) << "setThreadPerCore() must be called before start()";
+  // Threads and their CPUs are the acceptor's, see TcpConnectionAcceptor's
+  // `reusePort` and `workerCpus`.
+  useScheduledResponder_ = false;
+  threadPerCore_ = true;
+}
+
 void RSocketServer::acceptConnection(
     std::unique_ptr<DuplexConnection> connection,
     folly::EventBase&,
@@ -123,7 +131,8 @@ void RSocketServer::acceptConnection(
       std::move(framedConnection),
       [serviceHandler,
        weakConSet = std::weak_ptr<ConnectionSet>(connectionSet_),
-       scheduledResponder = useScheduledResponder_](
+       scheduledResponder = useScheduledResponder_,
+       threadPerCore = threadPerCore_](
           std::unique_ptr<DuplexConnection> conn,
           SetupParameters params) mutable {
         if (auto connectionSet = weakConSet.lock()) {
@@ -131,6 +140,7 @@ void RSocketServer::acceptConnection(
               serviceHandler,
               std::move(connectionSet),
               scheduledResponder,
+              threadPerCore,
               std::move(conn),
               std::move(params));
         }
@@ -147,6 +157,7 @@ void RSocketServer::onRSocketSetup(
     std::shared_ptr<RSocketServiceHandler> serviceHandler,
     std::shared_ptr<ConnectionSet> connectionSet,
     bool scheduledResponder,
+    bool threadPerCore,
     std::unique_ptr<DuplexConnection> connection,
     SetupParameters setupParams) {
   const auto eventBase = folly::EventBaseManager::get()->getExistingEventBase();
@@ -170,6 +181,14 @@ void RSocketServer::onRSocketSetup(
                 "Received invalid Responder from server")));
     return;
   }
+  if (setupParams.lease && !connectionParams.leaseSender) {
+    VLOG(3) << "Terminating SETUP attempt from client. Lease not supported";
+    connection->send(
+        FrameSerializer::createFrameSerializer(setupParams.protocolVersion)
+            ->serializeOut(
+                Frame_ERROR::unsupportedSetup("Lease is not supported")));
+    return;
+  }
   const auto rs = std::make_shared<RSocketStateMachine>(
       scheduledResponder
           ? std::make_shared<ScheduledRSocketResponder>(
@@ -183,6 +202,15 @@ void RSocketServer::onRSocketSetup(
           ? std::make_shared<WarmResumeManager>(connectionParams.stats)
           : ResumeManager::makeEmpty(),
       nullptr /* coldResumeHandler */);
+  if (setupParams.lease) {
+    rs->setLeaseSender(std::move(connectionParams.leaseSender), *eventBase);
+  }
+  rs->setRequestNPolicy(connectionParams.requestNPolicy, *eventBase);
+  rs->setReassemblyLimits(connectionParams.reassemblyLimits);
+  rs->setFrameSchedulingPolicy(std::move(connectionParams.frameScheduling));
+  if (threadPerCore) {
+    rs->setThreadAffinity(*eventBase);
+  }
 
   if (!connectionSet->insert(rs, eventBase)) {
     VLOG(1) << "Server is closed, so ignore the connection";
@@ -220,6 +248,17 @@ void RSocketServer::onRSocketResume(
   CHECK(serverState);
   const auto eventBase = folly::EventBaseManager::get()->getExistingEventBase();
   VLOG(2) << "Resuming client on " << eventBase->getName();
+  if (threadPerCore_ && !serverState->eventBase_.isInEventBaseThread()) {
+    // Moving the connection's IO to this worker would make every frame cross
+    // threads.
+    VLOG(3) << "Terminating RESUME attempt from client.  Connection lives on "
+            << serverState->eventBase_.getName();
+    connection->send(
+        FrameSerializer::createFrameSerializer(resumeParams.protocolVersion)
+            ->serializeOut(Frame_ERROR::rejectedResume(
+                "Connection can't resume on another worker")));
+    return;
+  }
   if (!serverState->eventBase_.isInEventBaseThread()) {
     // If the resumed connection is on a different EventBase, then use
     // ScheduledFrameTransport and ScheduledFrameProcessor to ensure the
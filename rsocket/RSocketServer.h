@@ -103,6 +103,26 @@ class RSocketServer {
    */
   void setSingleThreadedResponder();
 
+  /**
+   * Serve every connection entirely on the EventBase that accepted it, with
+   * no signal crossing to another thread.
+   *
+   * This neither creates nor pins threads; those belong to the acceptor.  A
+   * thread-per-core server composes this with TcpConnectionAcceptor options:
+   * `threads` set to the number of cores, `reusePort` so that every worker
+   * accepts its own connections, and `workerCpus` to pin worker i to core i.
+   *
+   * Implies setSingleThreadedResponder().  The service handler is called on
+   * the connection's worker, and the responder, stats and lease sender it
+   * returns must only be used there, so it can hand out per-worker instances.
+   * A connection can only resume on the worker it started on; resuming on
+   * another one is rejected.  Debug builds check that no signal crosses
+   * threads.
+   *
+   * Must be called before start().
+   */
+  void setThreadPerCore();
+
   /**
    * Number of active connections to this server.
    */
@@ -113,6 +133,7 @@ class RSocketServer {
       std::shared_ptr<RSocketServiceHandler> serviceHandler,
       std::shared_ptr<ConnectionSet> connectionSet,
       bool scheduledResponder,
+      bool threadPerCore,
       std::unique_ptr<DuplexConnection> connection,
       rsocket::SetupParameters setupPayload);
   void onRSocketResume(
@@ -139,5 +160,11 @@ class RSocketServer {
    * be scheduled to another event base.
    */
   bool useScheduledResponder_{true};
+
+  /**
+   * Whether connections are tied to the EventBase that accepted them, see
+   * setThreadPerCore().
+   */
+  bool threadPerCore_{false};
 };
 } // namespace rsocket
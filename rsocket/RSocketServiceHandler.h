@@ -16,12 +16,16 @@
 
 #include <folly/Expected.h>
 
+#include "rsocket/FrameSchedulingPolicy.h"
+#include "rsocket/Lease.h"
 #include "rsocket/RSocketConnectionEvents.h"
 #include "rsocket/RSocketException.h"
 #include "rsocket/RSocketParameters.h"
 #include "rsocket/RSocketResponder.h"
 #include "rsocket/RSocketServerState.h"
 #include "rsocket/RSocketStats.h"
+#include "rsocket/ReassemblyLimits.h"
+#include "rsocket/RequestNPolicy.h"
 #include "rsocket/internal/Common.h"
 
 namespace rsocket {
@@ -44,6 +48,16 @@ struct RSocketConnectionParams {
   std::shared_ptr<RSocketResponder> responder;
   std::shared_ptr<RSocketStats> stats;
   std::shared_ptr<RSocketConnectionEvents> connectionEvents;
+  // Grants leases to clients that ask for them in their SETUP frame.  Clients
+  // asking for leases are rejected with UNSUPPORTED_SETUP if this is null.
+  std::shared_ptr<LeaseSender> leaseSender;
+  // How streams on this connection grant credits to the client.
+  RequestNPolicy requestNPolicy;
+  // How much the server may hold of the fragmented payloads the client sends.
+  ReassemblyLimits reassemblyLimits;
+  // How the server's streams share the connection while it is not taking
+  // writes.
+  FrameSchedulingPolicy frameScheduling;
 };
 
 // This class has to be implemented by the application.  The methods can be
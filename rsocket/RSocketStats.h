@@ -15,6 +15,7 @@
 #pragma once
 
 #include <folly/Optional.h>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -54,6 +55,8 @@ class RSocketStats {
       ResumeOutcome /* outcome */) {}
   virtual void bytesWritten(size_t /* bytes */) {}
   virtual void bytesRead(size_t /* bytes */) {}
+  /// Bytes handed to a connection that have not been written out yet.
+  virtual void writeBufferChanged(int64_t /* dataSizeDelta */) {}
   virtual void frameWritten(FrameType /* frameType */) {}
   virtual void frameRead(FrameType /* frameType */) {}
   virtual void resumeBufferChanged(
@@ -65,6 +68,34 @@ class RSocketStats {
   virtual void resumeFailedNoState() {}
   virtual void keepaliveSent() {}
   virtual void keepaliveReceived() {}
+  virtual void leaseSent(uint32_t /* numberOfRequests */) {}
+  virtual void leaseReceived(uint32_t /* numberOfRequests */) {}
+  /// A request was refused because the requester had no lease for it.
+  virtual void requestRejectedNoLease() {}
+  /// A buffer was taken from an idle slab of the thread's IOBufPool, or the
+  /// pool had none of its size and allocated one.
+  virtual void bufferPoolHit() {}
+  virtual void bufferPoolMiss() {}
+  /// Bytes of idle slabs the thread's IOBufPool holds after an allocation.
+  virtual void bufferPoolFootprint(size_t /* bytes */) {}
+
+  /// Whether to time frame processing and requests for the latency hooks
+  /// below.  Off by default, as timing costs a few clock reads per frame.
+  virtual bool latenciesEnabled() const {
+    return false;
+  }
+  /// Time spent handling one received frame, including the application's
+  /// callbacks that ran inline.
+  virtual void frameProcessed(
+      FrameType /* frameType */,
+      std::chrono::nanoseconds /* latency */) {}
+  /// Time from sending REQUEST_RESPONSE until its response arrives.
+  virtual void requestResponseLatency(
+      std::chrono::nanoseconds /* latency */) {}
+  /// Time from sending REQUEST_STREAM or REQUEST_CHANNEL until the first
+  /// response frame arrives.
+  virtual void streamFirstPayloadLatency(
+      std::chrono::nanoseconds /* latency */) {}
   virtual void unknownFrameReceived() {
   } // TODO(lehecka): add to all implementations
 };
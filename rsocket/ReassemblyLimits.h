@@ -0,0 +1,41 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+
+namespace rsocket {
+
+/// Bounds on the memory a peer can make a connection hold by sending payloads
+/// in fragments.
+///
+/// Fragments are held until the last one of their payload arrives.  A stream
+/// that would hold more than `maxStreamBytes`, or make the connection's
+/// streams hold more than `maxConnectionBytes` in total, drops its fragments
+/// and fails with an error instead.  Payloads that arrive in a single frame
+/// are never held and do not count.
+///
+/// Held fragments are charged the capacity of the buffers they point into,
+/// which is what they keep alive, not just the bytes they use.
+struct ReassemblyLimits {
+  /// The most bytes of fragments one stream may hold, or 0 for no limit.
+  size_t maxStreamBytes{0};
+
+  /// The most bytes of fragments all streams of a connection may hold
+  /// together, or 0 for no limit.
+  size_t maxConnectionBytes{0};
+};
+
+} // namespace rsocket
@@ -0,0 +1,45 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace rsocket {
+
+/// How the streams of a connection grant credits to the remote producer with
+/// REQUEST_N frames.
+///
+/// By default, demand from the local subscriber is forwarded as soon as the
+/// credits the peer already holds cover less than half of it.  A subscriber
+/// that requests one payload at a time then sends one REQUEST_N per payload.
+/// A `window` batches the credits instead: they are granted only once the
+/// peer's outstanding credits drop to `replenishPercent` of the window, and
+/// then topped back up to the window.  Credits are never granted beyond what
+/// the local subscriber has asked for.
+struct RequestNPolicy {
+  /// The most credits to keep outstanding at the peer, or 0 to forward demand
+  /// as it arrives.
+  uint32_t window{0};
+
+  /// With a window, the share of it, in percent, that the outstanding credits
+  /// must drop to before more are granted.
+  uint32_t replenishPercent{25};
+
+  /// Merge all REQUEST_N frames a stream sends during one iteration of the
+  /// connection's EventBase loop into a single frame.
+  bool coalesce{false};
+};
+
+} // namespace rsocket
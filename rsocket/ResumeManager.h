@@ -55,7 +55,8 @@ using StreamResumeInfos = std::unordered_map<StreamId, StreamResumeInfo>;
 
 // Applications desiring to have cold-resumption should implement a
 // ResumeManager interface.  By default, an in-memory implementation of this
-// interface (WarmResumeManager) will be used by RSocket.
+// interface (WarmResumeManager) will be used by RSocket.  MmapResumeManager
+// keeps the state in files, so it survives a restart of the process.
 //
 // The API refers to the stored frames by "position".  "position" is the byte
 // count at frame boundaries.  For example, if the ResumeManager has stored 3
@@ -0,0 +1,117 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Latch.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "yarpl/Single.h"
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 32;
+
+DEFINE_int32(server_threads, 8, "number of server threads to run");
+DEFINE_int32(
+    items,
+    1000000,
+    "number of request-response requests to send, in total");
+
+namespace {
+
+class Observer : public yarpl::single::SingleObserverBase<Payload> {
+ public:
+  explicit Observer(Latch& latch) : latch_{latch} {}
+
+  void onSuccess(Payload) override {
+    latch_.post();
+    yarpl::single::SingleObserverBase<Payload>::onSuccess({});
+  }
+
+  void onError(folly::exception_wrapper) override {
+    latch_.post();
+    yarpl::single::SingleObserverBase<Payload>::onError({});
+  }
+
+ private:
+  Latch& latch_;
+};
+
+/// Sends requests through a pool of the given number of connections, each
+/// driven by a thread of its own.
+void poolThroughput(size_t n, size_t connections) {
+  (void)n;
+
+  Latch latch{static_cast<size_t>(FLAGS_items)};
+
+  std::unique_ptr<RSocketServer> server;
+  std::vector<std::unique_ptr<folly::ScopedEventBaseThread>> workers;
+  std::unique_ptr<RSocketClientPool> pool;
+
+  BENCHMARK_SUSPEND {
+    TcpConnectionAcceptor::Options serverOpts;
+    serverOpts.address = folly::SocketAddress{"0.0.0.0", 0};
+    serverOpts.threads = FLAGS_server_threads;
+    server = RSocket::createServer(
+        std::make_unique<TcpConnectionAcceptor>(std::move(serverOpts)));
+    auto responder =
+        std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+    server->start([responder](const SetupParameters&) { return responder; });
+
+    RSocketClientPool::Options opts;
+    opts.connections = connections;
+    for (size_t i = 0; i < connections; ++i) {
+      workers.push_back(std::make_unique<folly::ScopedEventBaseThread>(
+          "rsocket-client-thread"));
+      opts.factories.push_back(std::make_shared<TcpConnectionFactory>(
+          *workers.back()->getEventBase(),
+          folly::SocketAddress{"127.0.0.1", *server->listeningPort()}));
+    }
+    pool = RSocket::createClientPool(std::move(opts)).get();
+
+    LOG(INFO) << "Running:";
+    LOG(INFO) << "  Server with " << FLAGS_server_threads << " threads.";
+    LOG(INFO) << "  Pool of " << connections << " connections.";
+    LOG(INFO) << "  Running " << FLAGS_items << " requests in total";
+  }
+
+  auto const& requester = pool->getRequester();
+  for (int i = 0; i < FLAGS_items; ++i) {
+    requester->requestResponse(Payload("ClientPool"))
+        ->subscribe(std::make_shared<Observer>(latch));
+  }
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    pool.reset();
+    workers.clear();
+    server.reset();
+  }
+}
+} // namespace
+
+BENCHMARK_PARAM(poolThroughput, 1)
+BENCHMARK_RELATIVE_PARAM(poolThroughput, 2)
+BENCHMARK_RELATIVE_PARAM(poolThroughput, 4)
+BENCHMARK_RELATIVE_PARAM(poolThroughput, 8)
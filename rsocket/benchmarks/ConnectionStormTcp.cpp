@@ -0,0 +1,117 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Latch.h"
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+
+using namespace rsocket;
+
+DEFINE_int32(server_threads, 8, "number of server threads to run");
+DEFINE_int32(client_threads, 8, "number of threads opening connections");
+DEFINE_int32(connections, 2000, "number of connections opened per run");
+DEFINE_int32(backlog, 1024, "listen backlog of each listening socket");
+
+namespace {
+
+/// Opens one connection and closes it again as soon as it is established.
+class Connector : public folly::AsyncSocket::ConnectCallback {
+ public:
+  Connector(
+      folly::EventBase& eventBase,
+      const folly::SocketAddress& address,
+      Latch& latch)
+      : socket_(new folly::AsyncSocket(&eventBase)), latch_(latch) {
+    socket_->connect(this, address);
+  }
+
+  void connectSuccess() noexcept override {
+    delete this;
+  }
+
+  void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+    LOG(ERROR) << "Connect failed: " << ex.what();
+    // The server won't see this connection, so count it here.
+    latch_.post();
+    delete this;
+  }
+
+ private:
+  folly::AsyncSocket::UniquePtr socket_;
+  Latch& latch_;
+};
+
+void connectionStorm(bool reusePort) {
+  Latch latch{static_cast<size_t>(FLAGS_connections)};
+
+  std::unique_ptr<TcpConnectionAcceptor> acceptor;
+  std::vector<std::unique_ptr<folly::ScopedEventBaseThread>> clients;
+  folly::SocketAddress address;
+
+  BENCHMARK_SUSPEND {
+    TcpConnectionAcceptor::Options options;
+    options.address = folly::SocketAddress{"0.0.0.0", 0};
+    options.threads = FLAGS_server_threads;
+    options.backlog = FLAGS_backlog;
+    options.reusePort = reusePort;
+    acceptor = std::make_unique<TcpConnectionAcceptor>(std::move(options));
+    acceptor->start(
+        [&latch](std::unique_ptr<DuplexConnection>, folly::EventBase&) {
+          latch.post();
+        });
+    address = folly::SocketAddress{"127.0.0.1", *acceptor->listeningPort()};
+
+    for (int i = 0; i < FLAGS_client_threads; ++i) {
+      clients.push_back(
+          std::make_unique<folly::ScopedEventBaseThread>("rsbench-connect"));
+    }
+  }
+
+  // Every client thread opens its share of the connections at once.
+  for (size_t i = 0; i < clients.size(); ++i) {
+    auto const eventBase = clients[i]->getEventBase();
+    eventBase->runInEventBaseThread([&, i, eventBase] {
+      for (size_t c = i; c < static_cast<size_t>(FLAGS_connections);
+           c += clients.size()) {
+        new Connector(*eventBase, address, latch);
+      }
+    });
+  }
+
+  constexpr std::chrono::minutes timeout{1};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    clients.clear();
+    acceptor.reset();
+  }
+}
+} // namespace
+
+BENCHMARK(ConnectionStormSharedListener, n) {
+  (void)n;
+  connectionStorm(false);
+}
+
+BENCHMARK_RELATIVE(ConnectionStormReusePort, n) {
+  (void)n;
+  connectionStorm(true);
+}
@@ -0,0 +1,151 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Latch.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/internal/LatencyHistogram.h"
+#include "yarpl/Single.h"
+
+using namespace rsocket;
+
+DEFINE_int32(bulk_streams, 4, "number of bulk streams sharing the connection");
+DEFINE_int32(bulk_items, 2000, "number of items in each bulk stream");
+DEFINE_int32(bulk_size, 64 * 1024, "size of the bulk stream items");
+DEFINE_int32(requests, 1000, "number of latency-sensitive requests to send");
+DEFINE_int32(
+    write_high_water_mark,
+    256 * 1024,
+    "bytes the server may queue on a connection before it stops taking writes");
+
+namespace {
+
+/// Streams large items and answers requests with small ones.
+class MixedResponder : public RSocketResponder {
+ public:
+  MixedResponder()
+      : bulk_{folly::IOBuf::copyBuffer(std::string(FLAGS_bulk_size, 'b'))} {}
+
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestStream(
+      Payload,
+      StreamId) override {
+    return yarpl::flowable::Flowable<Payload>::fromGenerator(
+        [msg = bulk_->clone()] { return Payload(msg->clone()); });
+  }
+
+  std::shared_ptr<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    return yarpl::single::Singles::fromGenerator<Payload>(
+        [] { return Payload("pong"); });
+  }
+
+ private:
+  std::unique_ptr<folly::IOBuf> bulk_;
+};
+
+/// Records how long a request took to be answered.
+class TimedObserver : public yarpl::single::SingleObserverBase<Payload> {
+ public:
+  TimedObserver(LatencyHistogram& latencies, folly::Baton<>& done)
+      : latencies_{latencies}, done_{done} {}
+
+  void onSuccess(Payload) override {
+    latencies_.record(std::chrono::steady_clock::now() - start_);
+    done_.post();
+    yarpl::single::SingleObserverBase<Payload>::onSuccess({});
+  }
+
+  void onError(folly::exception_wrapper) override {
+    done_.post();
+    yarpl::single::SingleObserverBase<Payload>::onError({});
+  }
+
+ private:
+  LatencyHistogram& latencies_;
+  folly::Baton<>& done_;
+  const std::chrono::steady_clock::time_point start_{
+      std::chrono::steady_clock::now()};
+};
+
+void mixedWorkload(bool fair) {
+  Latch latch{static_cast<size_t>(FLAGS_bulk_streams)};
+  LatencyHistogram latencies;
+
+  std::unique_ptr<Fixture> fixture;
+  Fixture::Options opts;
+
+  BENCHMARK_SUSPEND {
+    opts.serverThreads = 1;
+    opts.clients = 1;
+    opts.serverConnection.writeHighWaterMark = FLAGS_write_high_water_mark;
+    opts.serverConnection.writeLowWaterMark = FLAGS_write_high_water_mark / 4;
+    opts.frameScheduling.enabled = fair;
+
+    fixture =
+        std::make_unique<Fixture>(opts, std::make_shared<MixedResponder>());
+
+    LOG(INFO) << "Running:";
+    LOG(INFO) << "  " << FLAGS_bulk_streams << " streams of "
+              << FLAGS_bulk_items << " items of " << FLAGS_bulk_size
+              << " bytes each.";
+    LOG(INFO) << "  " << FLAGS_requests << " requests, one at a time.";
+    LOG(INFO) << "  Frame scheduling " << (fair ? "on" : "off") << ".";
+  }
+
+  auto requester = fixture->clients.front()->getRequester();
+  for (int i = 0; i < FLAGS_bulk_streams; ++i) {
+    requester->requestStream(Payload("bulk"))->subscribe(
+        std::make_shared<BoundedSubscriber>(latch, FLAGS_bulk_items));
+  }
+
+  constexpr std::chrono::minutes timeout{5};
+  for (int i = 0; i < FLAGS_requests; ++i) {
+    folly::Baton<> done;
+    requester->requestResponse(Payload("ping"))
+        ->subscribe(std::make_shared<TimedObserver>(latencies, done));
+    if (!done.try_wait_for(timeout)) {
+      LOG(ERROR) << "Timed out!";
+      return;
+    }
+  }
+
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    auto const snapshot = latencies.snapshot();
+    LOG(INFO) << "  Request latency p50 "
+              << snapshot.percentile(50).count() / 1000 << "us, p99 "
+              << snapshot.percentile(99).count() / 1000 << "us.";
+  }
+}
+} // namespace
+
+BENCHMARK(MixedWorkloadFifo, n) {
+  (void)n;
+  mixedWorkload(false);
+}
+
+BENCHMARK(MixedWorkloadFair, n) {
+  (void)n;
+  mixedWorkload(true);
+}
@@ -14,14 +14,57 @@
 
 #include "rsocket/benchmarks/Fixture.h"
 
+#include <atomic>
+
+#include <folly/Format.h>
+#include <folly/portability/GFlags.h>
+
 #include "rsocket/RSocket.h"
+#include "rsocket/transports/inprocess/InProcessConnectionAcceptor.h"
+#include "rsocket/transports/inprocess/InProcessConnectionFactory.h"
 #include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
 #include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "rsocket/transports/unix/UnixConnectionAcceptor.h"
+#include "rsocket/transports/unix/UnixConnectionFactory.h"
+
+DEFINE_bool(
+    in_process,
+    false,
+    "connect fixture clients and servers in-process instead of over TCP");
 
 namespace rsocket {
 
 namespace {
 
+/// Hands every connection the fixture's responder and frame scheduling.
+class ServiceHandler : public RSocketServiceHandler {
+ public:
+  ServiceHandler(
+      std::shared_ptr<RSocketResponder> responder,
+      FrameSchedulingPolicy frameScheduling)
+      : responder_{std::move(responder)},
+        frameScheduling_{std::move(frameScheduling)} {}
+
+  folly::Expected<RSocketConnectionParams, RSocketException> onNewSetup(
+      const SetupParameters&) override {
+    RSocketConnectionParams params{responder_};
+    params.frameScheduling = frameScheduling_;
+    return params;
+  }
+
+ private:
+  std::shared_ptr<RSocketResponder> responder_;
+  FrameSchedulingPolicy frameScheduling_;
+};
+
+Fixture::Options applyFlags(Fixture::Options options) {
+  static std::atomic<size_t> counter{0};
+  if (FLAGS_in_process && !options.unixSocketPath && !options.inProcessName) {
+    options.inProcessName = folly::sformat("rsocket-bench-{}", counter++);
+  }
+  return options;
+}
+
 std::shared_ptr<RSocketClient> makeClient(
     folly::EventBase* eventBase,
     folly::SocketAddress address) {
@@ -29,19 +72,61 @@ std::shared_ptr<RSocketClient> makeClient(
       std::make_unique<TcpConnectionFactory>(*eventBase, std::move(address));
   return RSocket::createConnectedClient(std::move(factory)).get();
 }
-} // namespace
 
-Fixture::Fixture(
-    Fixture::Options fixtureOpts,
-    std::shared_ptr<RSocketResponder> responder)
-    : options{std::move(fixtureOpts)} {
+std::shared_ptr<RSocketClient> makeUnixClient(
+    folly::EventBase* eventBase,
+    const std::string& path) {
+  auto factory = std::make_unique<UnixConnectionFactory>(*eventBase, path);
+  return RSocket::createConnectedClient(std::move(factory)).get();
+}
+
+std::shared_ptr<RSocketClient> makeInProcessClient(
+    folly::EventBase* eventBase,
+    const std::string& name) {
+  auto factory = std::make_unique<InProcessConnectionFactory>(*eventBase, name);
+  return RSocket::createConnectedClient(std::move(factory)).get();
+}
+
+std::unique_ptr<ConnectionAcceptor> makeAcceptor(
+    const Fixture::Options& options) {
+  if (options.inProcessName) {
+    InProcessConnectionAcceptor::Options opts;
+    opts.name = *options.inProcessName;
+    opts.threads = options.serverThreads;
+    opts.stats = options.serverStats;
+    return std::make_unique<InProcessConnectionAcceptor>(std::move(opts));
+  }
+
+  if (options.unixSocketPath) {
+    UnixConnectionAcceptor::Options opts;
+    opts.path = *options.unixSocketPath;
+    opts.threads = options.serverThreads;
+    opts.connection = options.serverConnection;
+    opts.stats = options.serverStats;
+    return std::make_unique<UnixConnectionAcceptor>(std::move(opts));
+  }
+
   TcpConnectionAcceptor::Options opts;
   opts.address = folly::SocketAddress{"0.0.0.0", 0};
   opts.threads = options.serverThreads;
+  opts.reusePort = options.threadPerCore;
+  opts.connection = options.serverConnection;
+  opts.stats = options.serverStats;
+  return std::make_unique<TcpConnectionAcceptor>(std::move(opts));
+}
+} // namespace
 
-  auto acceptor = std::make_unique<TcpConnectionAcceptor>(std::move(opts));
-  server = std::make_unique<RSocketServer>(std::move(acceptor));
-  server->start([responder](const SetupParameters&) { return responder; });
+Fixture::Fixture(
+    Fixture::Options fixtureOpts,
+    std::shared_ptr<RSocketResponder> responder)
+    : options{applyFlags(std::move(fixtureOpts))} {
+  server = std::make_unique<RSocketServer>(
+      makeAcceptor(options), options.serverStats);
+  if (options.threadPerCore) {
+    server->setThreadPerCore();
+  }
+  server->start(std::make_shared<ServiceHandler>(
+      std::move(responder), options.frameScheduling));
 
   auto const numWorkers =
       options.clientThreads ? *options.clientThreads : options.clients;
@@ -50,12 +135,23 @@ Fixture::Fixture(
         "rsocket-client-thread"));
   }
 
-  const folly::SocketAddress actual{"127.0.0.1", *server->listeningPort()};
+  folly::SocketAddress actual;
+  if (!options.unixSocketPath && !options.inProcessName) {
+    actual = folly::SocketAddress{"127.0.0.1", *server->listeningPort()};
+  }
 
   for (size_t i = 0; i < options.clients; ++i) {
     auto worker = std::move(workers.front());
     workers.pop_front();
-    clients.push_back(makeClient(worker->getEventBase(), actual));
+    if (options.inProcessName) {
+      clients.push_back(
+          makeInProcessClient(worker->getEventBase(), *options.inProcessName));
+    } else if (options.unixSocketPath) {
+      clients.push_back(
+          makeUnixClient(worker->getEventBase(), *options.unixSocketPath));
+    } else {
+      clients.push_back(makeClient(worker->getEventBase(), actual));
+    }
     workers.push_back(std::move(worker));
   }
 }
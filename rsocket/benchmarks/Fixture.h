@@ -14,13 +14,16 @@
 
 #pragma once
 
+#include "rsocket/FrameSchedulingPolicy.h"
 #include "rsocket/RSocketClient.h"
 #include "rsocket/RSocketServer.h"
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
 
 #include <folly/Optional.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 
 #include <deque>
+#include <string>
 #include <vector>
 
 namespace rsocket {
@@ -28,7 +31,9 @@ namespace rsocket {
 /// Benchmarks fixture object that contains a server, along with a list of
 /// clients and their worker threads.
 ///
-/// Uses TCP as the transport.
+/// Uses TCP as the transport, or a Unix domain socket or the in-process
+/// transport when one is configured.  Passing --in_process switches every
+/// fixture that would otherwise use TCP to the in-process transport.
 struct Fixture {
   struct Options {
     /// Number of threads the server will run.
@@ -40,6 +45,28 @@ struct Fixture {
     /// Number of worker threads driving the clients.  A default value means to
     /// use one thread per client.
     folly::Optional<size_t> clientThreads;
+
+    /// Serve each connection entirely on the server thread that accepted it,
+    /// see RSocketServer::setThreadPerCore().  Over TCP every server thread
+    /// then accepts on a socket of its own.
+    bool threadPerCore{false};
+
+    /// Options for the TCP connections accepted by the server.
+    TcpDuplexConnection::Options serverConnection;
+
+    /// How the streams the server sends on each connection share it.
+    FrameSchedulingPolicy frameScheduling;
+
+    /// Stats reported by the server and its connections.
+    std::shared_ptr<RSocketStats> serverStats{RSocketStats::noop()};
+
+    /// Serve and connect over a Unix domain socket at this path instead of TCP
+    /// loopback.
+    folly::Optional<std::string> unixSocketPath;
+
+    /// Serve and connect in-process under this name instead of over a socket,
+    /// to measure the library without the kernel.
+    folly::Optional<std::string> inProcessName;
   };
 
   Fixture(Options, std::shared_ptr<RSocketResponder>);
@@ -0,0 +1,121 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+#include <vector>
+
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameHeaderView.h"
+#include "rsocket/framing/FrameSerializer.h"
+
+using namespace rsocket;
+
+constexpr size_t kCorpusSize = 1024;
+
+namespace {
+
+/// A mix of the frames a busy connection reads: mostly PAYLOADs, with and
+/// without metadata, plus requests, REQUEST_Ns, CANCELs and KEEPALIVEs.
+std::vector<std::unique_ptr<folly::IOBuf>> makeCorpus() {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  std::vector<std::unique_ptr<folly::IOBuf>> corpus;
+  for (size_t i = 0; i < kCorpusSize; ++i) {
+    auto const streamId = static_cast<StreamId>(2 * i + 1);
+    switch (i % 8) {
+      case 0:
+        corpus.push_back(serializer->serializeOut(Frame_REQUEST_STREAM(
+            streamId,
+            FrameFlags::METADATA,
+            16,
+            Payload("data", "metadata"))));
+        break;
+      case 1:
+        corpus.push_back(
+            serializer->serializeOut(Frame_REQUEST_N(streamId, 16)));
+        break;
+      case 2:
+        corpus.push_back(serializer->serializeOut(Frame_CANCEL(streamId)));
+        break;
+      case 3:
+        corpus.push_back(serializer->serializeOut(Frame_KEEPALIVE(
+            FrameFlags::KEEPALIVE_RESPOND, i, folly::IOBuf::create(0))));
+        break;
+      case 4:
+      case 5:
+        corpus.push_back(serializer->serializeOut(Frame_PAYLOAD(
+            streamId,
+            FrameFlags::METADATA | FrameFlags::NEXT,
+            Payload("data", "metadata"))));
+        break;
+      default:
+        corpus.push_back(serializer->serializeOut(
+            Frame_PAYLOAD(streamId, FrameFlags::NEXT, Payload("data"))));
+        break;
+    }
+  }
+  return corpus;
+}
+
+/// How the header was read before FrameHeaderView: the type, the stream ID
+/// and the frame length each in their own pass, with a Cursor.
+size_t peekWithCursor(const folly::IOBuf& frame) {
+  FrameType type;
+  StreamId streamId;
+  try {
+    folly::io::Cursor cur{&frame};
+    auto const rawStreamId = cur.readBE<int32_t>();
+    streamId = rawStreamId < 0 ? 0 : static_cast<StreamId>(rawStreamId);
+    type = static_cast<FrameType>(cur.readBE<uint8_t>() >> 2);
+  } catch (...) {
+    return 0;
+  }
+  return static_cast<size_t>(type) + streamId +
+      frame.computeChainDataLength();
+}
+
+size_t peekWithView(const folly::IOBuf& frame) {
+  FrameHeaderView header{frame};
+  if (!header.valid()) {
+    return 0;
+  }
+  return static_cast<size_t>(header.type()) + header.streamId() +
+      header.frameLength() + header.metadataLength();
+}
+
+template <typename Peek>
+void peekCorpus(size_t n, Peek peek) {
+  std::vector<std::unique_ptr<folly::IOBuf>> corpus;
+  BENCHMARK_SUSPEND {
+    corpus = makeCorpus();
+  }
+
+  size_t sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sum += peek(*corpus[i % kCorpusSize]);
+  }
+  folly::doNotOptimizeAway(sum);
+}
+} // namespace
+
+BENCHMARK(PeekHeaderCursor, n) {
+  peekCorpus(n, peekWithCursor);
+}
+
+BENCHMARK_RELATIVE(PeekHeaderView, n) {
+  peekCorpus(n, peekWithView);
+}
@@ -0,0 +1,101 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+
+#include <cstring>
+
+#include "rsocket/framing/FramedReader.h"
+
+using namespace rsocket;
+
+constexpr size_t kReadBufferLength = 64 * 1024;
+constexpr size_t kFrameLength = 32; // including the frame length field
+constexpr size_t kFrameLengthFieldLength = 3;
+constexpr size_t kFramesPerBuffer = kReadBufferLength / kFrameLength;
+
+namespace {
+
+class CountingSubscriber : public DuplexConnection::Subscriber {
+ public:
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    subscription->request(std::numeric_limits<int64_t>::max());
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf>) override {
+    ++frames;
+  }
+
+  void onComplete() override {}
+  void onError(folly::exception_wrapper) override {}
+
+  size_t frames{0};
+};
+
+/// A read buffer packed with back-to-back frames.
+std::unique_ptr<folly::IOBuf> makeReadBuffer() {
+  auto buf = folly::IOBuf::create(kReadBufferLength);
+  auto const frameSize = kFrameLength - kFrameLengthFieldLength;
+  for (size_t i = 0; i < kFramesPerBuffer; ++i) {
+    auto frame = buf->writableTail();
+    frame[0] = static_cast<uint8_t>(frameSize >> 16);
+    frame[1] = static_cast<uint8_t>(frameSize >> 8);
+    frame[2] = static_cast<uint8_t>(frameSize);
+    memset(frame + kFrameLengthFieldLength, 'a', frameSize);
+    buf->append(kFrameLength);
+  }
+  return buf;
+}
+
+/// Feeds `n` read buffers to a FramedReader, `readLength` bytes at a time.
+void parseFrames(size_t n, size_t readLength) {
+  auto reader = std::make_shared<FramedReader>(
+      std::make_shared<ProtocolVersion>(ProtocolVersion::Latest));
+  auto subscriber = std::make_shared<CountingSubscriber>();
+  std::unique_ptr<folly::IOBuf> readBuffer;
+
+  BENCHMARK_SUSPEND {
+    reader->onSubscribe(yarpl::flowable::Subscription::create());
+    reader->setInput(subscriber);
+    readBuffer = makeReadBuffer();
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t offset = 0; offset < kReadBufferLength; offset += readLength) {
+      auto const length = std::min(readLength, kReadBufferLength - offset);
+      auto read = readBuffer->cloneOne();
+      read->trimStart(offset);
+      read->trimEnd(kReadBufferLength - offset - length);
+      reader->onNext(std::move(read));
+    }
+  }
+
+  BENCHMARK_SUSPEND {
+    CHECK_EQ(subscriber->frames, n * kFramesPerBuffer);
+    reader->onComplete();
+  }
+}
+} // namespace
+
+BENCHMARK(ParseFramesSingleRead, n) {
+  parseFrames(n, kReadBufferLength);
+}
+
+BENCHMARK(ParseFramesUnalignedReads, n) {
+  // Reads that don't line up with frame boundaries split frames across
+  // buffers.
+  parseFrames(n, 4000);
+}
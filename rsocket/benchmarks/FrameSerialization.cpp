@@ -0,0 +1,86 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+
+#include <vector>
+
+#include "rsocket/framing/FrameSerializer_v1_0.h"
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 32;
+constexpr size_t kBatchSize = 1024;
+
+// Enough headroom for the frame header and the frame length field.
+constexpr size_t kHeadroom = 16;
+
+namespace {
+
+/// Serializes `n` PAYLOAD frames whose data comes from `makeData`.  Returns
+/// the number of buffers in the last serialized frame.
+template <typename MakeData>
+size_t serializePayloads(size_t n, MakeData&& makeData) {
+  FrameSerializerV1_0 serializer;
+  serializer.preallocateFrameSizeField() = true;
+
+  std::vector<std::unique_ptr<folly::IOBuf>> buffers;
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  size_t chainElements = 0;
+
+  while (n > 0) {
+    auto const batch = std::min(n, kBatchSize);
+
+    BENCHMARK_SUSPEND {
+      if (!frames.empty()) {
+        chainElements = frames.back()->countChainElements();
+      }
+      buffers.clear();
+      frames.clear();
+      frames.reserve(batch);
+      for (size_t i = 0; i < batch; ++i) {
+        buffers.push_back(makeData());
+      }
+    }
+
+    for (auto& buf : buffers) {
+      frames.push_back(serializer.serializeOut(
+          Frame_PAYLOAD(1, FrameFlags::NEXT, Payload(std::move(buf)))));
+    }
+
+    n -= batch;
+  }
+
+  return frames.empty() ? chainElements : frames.back()->countChainElements();
+}
+} // namespace
+
+BENCHMARK(SerializePayloadWithoutHeadroom, n) {
+  auto const chainElements = serializePayloads(
+      n, [] { return folly::IOBuf::copyBuffer(std::string(kMessageLen, 'a')); });
+
+  // The header went into a separately allocated buffer.
+  CHECK(n == 0 || chainElements == 2);
+}
+
+BENCHMARK_RELATIVE(SerializePayloadWithHeadroom, n) {
+  auto const chainElements = serializePayloads(n, [] {
+    return folly::IOBuf::copyBuffer(std::string(kMessageLen, 'a'), kHeadroom);
+  });
+
+  // The header was written into the payload's headroom, so serializing the
+  // frame allocated neither an IOBuf nor a data buffer.
+  CHECK(n == 0 || chainElements == 1);
+}
@@ -20,6 +20,10 @@
 #include <folly/init/Init.h>
 #include <folly/portability/GFlags.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
 #include "rsocket/RSocket.h"
 #include "yarpl/Single.h"
 
@@ -40,6 +44,10 @@ DEFINE_int32(
 
 namespace {
 
+/// Number of calls to the global operator new, to see how much of request
+/// setup and teardown still goes through malloc.
+std::atomic<size_t> allocations{0};
+
 class Observer : public yarpl::single::SingleObserverBase<Payload> {
  public:
   explicit Observer(Latch& latch) : latch_{latch} {}
@@ -65,6 +73,22 @@ class Observer : public yarpl::single::SingleObserverBase<Payload> {
 };
 } // namespace
 
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
 BENCHMARK(RequestResponseThroughput, n) {
   (void)n;
 
@@ -90,6 +114,7 @@ BENCHMARK(RequestResponseThroughput, n) {
     LOG(INFO) << "  " << opts.clients << " clients across "
               << fixture->workers.size() << " threads.";
     LOG(INFO) << "  Running " << FLAGS_items << " requests in total";
+    allocations = 0;
   }
 
   for (int i = 0; i < FLAGS_items; ++i) {
@@ -103,4 +128,9 @@ BENCHMARK(RequestResponseThroughput, n) {
   if (!latch.timed_wait(timeout)) {
     LOG(ERROR) << "Timed out!";
   }
+
+  BENCHMARK_SUSPEND {
+    LOG(INFO) << "  " << static_cast<double>(allocations) / FLAGS_items
+              << " allocations per request";
+  }
 }
@@ -0,0 +1,60 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+
+#include "rsocket/framing/FrameSerializer_v1_0.h"
+#include "rsocket/internal/WarmResumeManager.h"
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 256;
+
+namespace {
+
+/// Serializes `n` PAYLOAD frames and hands each one to `manager`, the way the
+/// state machine does for every frame it sends.
+void sendFrames(size_t n, ResumeManager& manager, const folly::IOBuf& data) {
+  FrameSerializerV1_0 serializer;
+  for (size_t i = 0; i < n; ++i) {
+    auto frame = serializer.serializeOut(
+        Frame_PAYLOAD(1, FrameFlags::NEXT, Payload(data.clone())));
+    manager.trackSentFrame(*frame, FrameType::PAYLOAD, 1, 0);
+  }
+}
+} // namespace
+
+BENCHMARK(SendFramesResumptionOff, n) {
+  std::shared_ptr<ResumeManager> manager;
+  std::unique_ptr<folly::IOBuf> data;
+  BENCHMARK_SUSPEND {
+    manager = ResumeManager::makeEmpty();
+    data = folly::IOBuf::copyBuffer(std::string(kMessageLen, 'a'));
+  }
+  sendFrames(n, *manager, *data);
+}
+
+BENCHMARK_RELATIVE(SendFramesResumptionOn, n) {
+  std::shared_ptr<ResumeManager> manager;
+  std::unique_ptr<folly::IOBuf> data;
+  BENCHMARK_SUSPEND {
+    manager = std::make_shared<WarmResumeManager>(RSocketStats::noop());
+    data = folly::IOBuf::copyBuffer(std::string(kMessageLen, 'a'));
+
+    // Fill the buffer, so that every frame sent evicts an old one.
+    sendFrames(1024 * 1024 / kMessageLen, *manager, *data);
+  }
+  sendFrames(n, *manager, *data);
+}
@@ -0,0 +1,97 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "rsocket/internal/StreamMap.h"
+
+using namespace rsocket;
+
+namespace {
+
+// Stand-in for the stream state machines; dispatch only touches the pointer.
+using StreamPtr = std::shared_ptr<size_t>;
+
+/// Looks up `n` frames' streams, in random order, among `streams` live
+/// client streams.
+template <typename Map, typename Find>
+void dispatch(size_t n, size_t streams, Find find) {
+  Map map;
+  std::vector<StreamId> frames;
+
+  BENCHMARK_SUSPEND {
+    for (size_t i = 0; i < streams; ++i) {
+      auto const streamId = static_cast<StreamId>(2 * i + 1);
+      map.insert({streamId, std::make_shared<size_t>(i)});
+      frames.push_back(streamId);
+    }
+    std::shuffle(frames.begin(), frames.end(), std::mt19937{});
+  }
+
+  size_t sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    // Copy the pointer, like RSocketStateMachine::getStreamStateMachine().
+    if (StreamPtr stream = find(map, frames[i % frames.size()])) {
+      sum += *stream;
+    }
+  }
+  folly::doNotOptimizeAway(sum);
+
+  BENCHMARK_SUSPEND {
+    map.clear();
+  }
+}
+
+class FlatStreams : public StreamMap<StreamPtr> {
+ public:
+  void insert(std::pair<StreamId, StreamPtr> entry) {
+    StreamMap<StreamPtr>::insert(entry.first, std::move(entry.second));
+  }
+
+  void clear() {
+    takeAll();
+  }
+};
+
+void unorderedMap(size_t n, size_t streams) {
+  using Map = std::unordered_map<StreamId, StreamPtr>;
+  dispatch<Map>(n, streams, [](const Map& map, StreamId streamId) {
+    auto const it = map.find(streamId);
+    return it == map.end() ? nullptr : it->second;
+  });
+}
+
+void streamMap(size_t n, size_t streams) {
+  dispatch<FlatStreams>(
+      n, streams, [](const FlatStreams& map, StreamId streamId) {
+        auto const stream = map.find(streamId);
+        return stream ? *stream : nullptr;
+      });
+}
+} // namespace
+
+BENCHMARK_PARAM(unorderedMap, 1000)
+BENCHMARK_RELATIVE_PARAM(streamMap, 1000)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(unorderedMap, 100000)
+BENCHMARK_RELATIVE_PARAM(streamMap, 100000)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(unorderedMap, 1000000)
+BENCHMARK_RELATIVE_PARAM(streamMap, 1000000)
@@ -14,14 +14,19 @@
 
 #include "rsocket/benchmarks/Throughput.h"
 
+#include <atomic>
+
 #include <folly/Benchmark.h>
-#include <folly/Synchronized.h>
+#include <folly/Format.h>
 #include <folly/init/Init.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/portability/GFlags.h>
 #include <folly/synchronization/Baton.h>
 
 #include "rsocket/RSocket.h"
+#include "rsocket/transports/inprocess/InProcessConnectionAcceptor.h"
+#include "rsocket/transports/inprocess/InProcessConnectionFactory.h"
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
 #include "yarpl/Flowable.h"
 
 using namespace rsocket;
@@ -32,74 +37,54 @@ DEFINE_int32(items, 1000000, "number of items in stream");
 
 namespace {
 
-/// State shared across the client and server DirectDuplexConnections.
-struct State {
-  /// Whether one of the two connections has been destroyed.
-  folly::Synchronized<bool> destroyed;
-};
-
-/// DuplexConnection that talks to another DuplexConnection via memory.
-class DirectDuplexConnection : public DuplexConnection {
+/// Connects the client and server with the in-process transport, the ceiling
+/// for any transport.
+class Factory : public ConnectionFactory {
  public:
-  DirectDuplexConnection(std::shared_ptr<State> state, folly::EventBase& evb)
-      : state_{std::move(state)}, evb_{evb} {}
+  Factory() {
+    static std::atomic<size_t> counter{0};
+    InProcessConnectionAcceptor::Options options;
+    options.name = folly::sformat("stream-throughput-mem-{}", counter++);
+    options.threads = 1;
 
-  ~DirectDuplexConnection() {
-    *state_->destroyed.wlock() = true;
-  }
+    auto responder =
+        std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
 
-  // Tie two DirectDuplexConnections together so they can talk to each other.
-  void tie(DirectDuplexConnection* other) {
-    other_ = other;
-    other_->other_ = this;
-  }
+    server_ = std::make_unique<RSocketServer>(
+        std::make_unique<InProcessConnectionAcceptor>(options));
+    server_->start([responder](const SetupParameters&) { return responder; });
 
-  void setInput(std::shared_ptr<DuplexConnection::Subscriber> input) override {
-    input_ = std::move(input);
+    factory_ = std::make_unique<InProcessConnectionFactory>(
+        *worker_.getEventBase(), options.name);
   }
 
-  void send(std::unique_ptr<folly::IOBuf> buf) override {
-    auto destroyed = state_->destroyed.rlock();
-    if (*destroyed || !other_) {
-      return;
-    }
-
-    other_->evb_.runInEventBaseThread(
-        [state = state_, other = other_, b = std::move(buf)]() mutable {
-          auto destroyed = state->destroyed.rlock();
-          if (*destroyed) {
-            return;
-          }
-
-          other->input_->onNext(std::move(b));
-        });
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion version,
+      ResumeStatus resume) override {
+    return factory_->connect(version, resume);
   }
 
  private:
-  std::shared_ptr<State> state_;
-  folly::EventBase& evb_;
+  folly::ScopedEventBaseThread worker_;
 
-  DirectDuplexConnection* other_{nullptr};
+  std::unique_ptr<rsocket::RSocketServer> server_;
 
-  std::shared_ptr<DuplexConnection::Subscriber> input_;
+  std::unique_ptr<InProcessConnectionFactory> factory_;
 };
 
-class Acceptor : public ConnectionAcceptor {
+/// Acceptor handing the server its end of a shared-memory channel.
+class ShmAcceptor : public ConnectionAcceptor {
  public:
-  explicit Acceptor(std::shared_ptr<State> state) : state_{std::move(state)} {}
-
-  void setClientConnection(DirectDuplexConnection* connection) {
-    client_ = connection;
-  }
+  explicit ShmAcceptor(ShmDuplexConnection::Endpoint endpoint)
+      : endpoint_{std::move(endpoint)} {}
 
   void start(OnDuplexConnectionAccept onAccept) override {
-    worker_.getEventBase()->runInEventBaseThread(
-        [this, onAccept = std::move(onAccept)]() mutable {
-          auto server = std::make_unique<DirectDuplexConnection>(
-              std::move(state_), *worker_.getEventBase());
-          server->tie(client_);
-          onAccept(std::move(server), *worker_.getEventBase());
-        });
+    auto evb = worker_.getEventBase();
+    evb->runInEventBaseThreadAndWait([&] {
+      onAccept(
+          std::make_unique<ShmDuplexConnection>(std::move(endpoint_), *evb),
+          *evb);
+    });
   }
 
   void stop() override {}
@@ -109,30 +94,24 @@ class Acceptor : public ConnectionAcceptor {
   }
 
  private:
-  std::shared_ptr<State> state_;
-
-  DirectDuplexConnection* client_{nullptr};
+  ShmDuplexConnection::Endpoint endpoint_;
 
   folly::ScopedEventBaseThread worker_;
 };
 
-class Factory : public ConnectionFactory {
+/// Connects the client and server through shared memory rather than in-process,
+/// showing how close ShmDuplexConnection gets to the in-process ceiling.
+class ShmFactory : public ConnectionFactory {
  public:
-  Factory() {
-    auto state = std::make_shared<State>();
-
-    connection_ = std::make_unique<DirectDuplexConnection>(
-        state, *worker_.getEventBase());
-
-    auto acceptor = std::make_unique<Acceptor>(state);
-    acceptor_ = acceptor.get();
-
-    acceptor_->setClientConnection(connection_.get());
+  ShmFactory() {
+    auto endpoints = ShmDuplexConnection::createChannel();
+    endpoint_ = std::move(endpoints.first);
 
     auto responder =
         std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
 
-    server_ = std::make_unique<RSocketServer>(std::move(acceptor));
+    server_ = std::make_unique<RSocketServer>(
+        std::make_unique<ShmAcceptor>(std::move(endpoints.second)));
     server_->start([responder](const SetupParameters&) { return responder; });
   }
 
@@ -140,29 +119,29 @@ class Factory : public ConnectionFactory {
       ProtocolVersion,
       ResumeStatus /* unused */) override {
     return folly::via(worker_.getEventBase(), [this] {
-      return ConnectedDuplexConnection{std::move(connection_),
-                                       *worker_.getEventBase()};
+      auto evb = worker_.getEventBase();
+      return ConnectedDuplexConnection{
+          std::make_unique<ShmDuplexConnection>(std::move(endpoint_), *evb),
+          *evb};
     });
   }
 
  private:
-  std::unique_ptr<DirectDuplexConnection> connection_;
+  ShmDuplexConnection::Endpoint endpoint_;
 
   std::unique_ptr<rsocket::RSocketServer> server_;
-  Acceptor* acceptor_{nullptr};
 
   folly::ScopedEventBaseThread worker_;
 };
 
+template <typename ConnectionFactoryT>
 std::shared_ptr<RSocketClient> makeClient() {
-  auto factory = std::make_unique<Factory>();
+  auto factory = std::make_unique<ConnectionFactoryT>();
   return RSocket::createConnectedClient(std::move(factory)).get();
 }
-} // namespace
-
-BENCHMARK(StreamThroughput, n) {
-  (void)n;
 
+template <typename ConnectionFactoryT>
+void streamThroughput() {
   std::shared_ptr<RSocketClient> client;
   std::shared_ptr<BoundedSubscriber> subscriber;
 
@@ -173,7 +152,7 @@ BENCHMARK(StreamThroughput, n) {
   BENCHMARK_SUSPEND {
     LOG(INFO) << "  Running with " << FLAGS_items << " items";
 
-    client = makeClient();
+    client = makeClient<ConnectionFactoryT>();
   }
 
   client->getRequester()
@@ -185,3 +164,14 @@ BENCHMARK(StreamThroughput, n) {
     LOG(ERROR) << "Timed out!";
   }
 }
+} // namespace
+
+BENCHMARK(StreamThroughput, n) {
+  (void)n;
+  streamThroughput<Factory>();
+}
+
+BENCHMARK_RELATIVE(StreamThroughputShm, n) {
+  (void)n;
+  streamThroughput<ShmFactory>();
+}
@@ -15,11 +15,14 @@
 #include "rsocket/benchmarks/Fixture.h"
 #include "rsocket/benchmarks/Throughput.h"
 
+#include <atomic>
+
 #include <folly/Benchmark.h>
 #include <folly/portability/GFlags.h>
 #include <folly/synchronization/Baton.h>
 
 #include "rsocket/RSocket.h"
+#include "rsocket/RSocketStats.h"
 
 using namespace rsocket;
 
@@ -34,13 +37,24 @@ DEFINE_int32(clients, 10, "number of clients to run");
 DEFINE_int32(items, 1000000, "number of items in stream, per client");
 DEFINE_int32(streams, 1, "number of streams, per client");
 
-BENCHMARK(StreamThroughput, n) {
-  (void)n;
+namespace {
+
+/// Counts the writes the server issues on its sockets.
+class SocketWriteStats : public RSocketStats {
+ public:
+  void bytesWritten(size_t) override {
+    ++writes;
+  }
+
+  std::atomic<size_t> writes{0};
+};
 
+void streamThroughput(bool batchWrites) {
   Latch latch{static_cast<size_t>(FLAGS_streams)};
 
   std::unique_ptr<Fixture> fixture;
   Fixture::Options opts;
+  auto stats = std::make_shared<SocketWriteStats>();
 
   BENCHMARK_SUSPEND {
     auto responder =
@@ -51,6 +65,8 @@ BENCHMARK(StreamThroughput, n) {
     if (FLAGS_override_client_threads > 0) {
       opts.clientThreads = FLAGS_override_client_threads;
     }
+    opts.serverConnection.batchWrites = batchWrites;
+    opts.serverStats = stats;
 
     fixture = std::make_unique<Fixture>(opts, std::move(responder));
 
@@ -60,6 +76,7 @@ BENCHMARK(StreamThroughput, n) {
               << fixture->workers.size() << " threads.";
     LOG(INFO) << "  Running " << FLAGS_streams << " streams of " << FLAGS_items
               << " items each.";
+    LOG(INFO) << "  Write batching " << (batchWrites ? "on" : "off") << ".";
   }
 
   for (size_t i = 0; i < FLAGS_streams; ++i) {
@@ -74,4 +91,23 @@ BENCHMARK(StreamThroughput, n) {
   if (!latch.timed_wait(timeout)) {
     LOG(ERROR) << "Timed out!";
   }
+
+  BENCHMARK_SUSPEND {
+    auto const writes = stats->writes.load();
+    auto const frames = static_cast<double>(FLAGS_items) * FLAGS_streams *
+        fixture->clients.size();
+    LOG(INFO) << "  Server issued " << writes << " socket writes, "
+              << writes / frames << " per frame.";
+  }
+}
+} // namespace
+
+BENCHMARK(StreamThroughput, n) {
+  (void)n;
+  streamThroughput(false);
+}
+
+BENCHMARK(StreamThroughputBatchedWrites, n) {
+  (void)n;
+  streamThroughput(true);
 }
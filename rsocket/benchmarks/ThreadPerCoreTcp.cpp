@@ -0,0 +1,88 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/RSocket.h"
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 32;
+
+DEFINE_int32(items, 100000, "number of items in stream, per client");
+
+namespace {
+
+/// Streams to one client per server thread, with the server's responders
+/// either scheduled onto their connection's thread or tied to it.
+void streamThroughput(size_t threads, bool threadPerCore) {
+  Latch latch{threads};
+
+  std::unique_ptr<Fixture> fixture;
+  Fixture::Options opts;
+
+  BENCHMARK_SUSPEND {
+    auto responder =
+        std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+
+    opts.serverThreads = threads;
+    opts.clients = threads;
+    opts.threadPerCore = threadPerCore;
+
+    fixture = std::make_unique<Fixture>(opts, std::move(responder));
+
+    LOG(INFO) << "Running:";
+    LOG(INFO) << "  Server with " << opts.serverThreads << " threads, "
+              << (threadPerCore ? "thread-per-core" : "scheduled") << ".";
+    LOG(INFO) << "  " << opts.clients << " clients across "
+              << fixture->workers.size() << " threads.";
+    LOG(INFO) << "  Running one stream of " << FLAGS_items
+              << " items per client.";
+  }
+
+  for (auto& client : fixture->clients) {
+    client->getRequester()
+        ->requestStream(Payload("ThreadPerCore"))
+        ->subscribe(std::make_shared<BoundedSubscriber>(latch, FLAGS_items));
+  }
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+}
+
+void scheduled(size_t n, size_t threads) {
+  (void)n;
+  streamThroughput(threads, false);
+}
+
+void threadPerCore(size_t n, size_t threads) {
+  (void)n;
+  streamThroughput(threads, true);
+}
+} // namespace
+
+BENCHMARK_PARAM(scheduled, 1)
+BENCHMARK_RELATIVE_PARAM(threadPerCore, 1)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(scheduled, 8)
+BENCHMARK_RELATIVE_PARAM(threadPerCore, 8)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(scheduled, 32)
+BENCHMARK_RELATIVE_PARAM(threadPerCore, 32)
@@ -164,6 +164,7 @@ void Frame_SETUP::moveToSetupPayload(SetupParameters& setupPayload) {
   setupPayload.payload = std::move(payload_);
   setupPayload.token = std::move(token_);
   setupPayload.resumable = !!(header_.flags & FrameFlags::RESUME_ENABLE);
+  setupPayload.lease = !!(header_.flags & FrameFlags::LEASE);
   setupPayload.protocolVersion = ProtocolVersion(versionMajor_, versionMinor_);
 }
 
@@ -0,0 +1,144 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
+
+#include "rsocket/framing/FrameFlags.h"
+#include "rsocket/framing/FrameType.h"
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+/// The header of a serialized protocol 1.0 frame, decoded in one pass.
+///
+/// Copies the first kPeekSize bytes of the frame with one load when they are
+/// contiguous, and takes the stream ID, type, flags and, for frames that
+/// carry it at a fixed offset, the metadata length out of them.  Checking
+/// the header uses masks rather than branches.
+class FrameHeaderView {
+ public:
+  static constexpr size_t kHeaderSize = 6;
+  static constexpr size_t kPeekSize = 16;
+
+  explicit FrameHeaderView(const folly::IOBuf& frame) {
+    uint8_t bytes[kPeekSize];
+    if (frame.length() >= kPeekSize) {
+      std::memcpy(bytes, frame.data(), kPeekSize);
+      length_ =
+          frame.isChained() ? frame.computeChainDataLength() : frame.length();
+    } else {
+      std::memset(bytes, 0, kPeekSize);
+      folly::io::Cursor cur{&frame};
+      cur.pullAtMost(bytes, kPeekSize);
+      length_ = frame.computeChainDataLength();
+    }
+    decode(bytes);
+  }
+
+  /// Whether the frame holds a whole header, the reserved bit of its stream
+  /// ID is clear, and its metadata, if it has a metadata length, fits in the
+  /// frame.  Flags a frame type doesn't define are ignored, as the protocol
+  /// asks.
+  bool valid() const {
+    return valid_;
+  }
+
+  StreamId streamId() const {
+    return streamId_;
+  }
+
+  /// Frame types this version doesn't know decode as RESERVED.
+  FrameType type() const {
+    return type_;
+  }
+
+  FrameFlags flags() const {
+    return flags_;
+  }
+
+  /// Whether the frame has the METADATA flag and a metadata length at a
+  /// fixed offset, i.e. is a request or PAYLOAD frame with metadata.
+  bool hasMetadataLength() const {
+    return metadataOffset_ != 0;
+  }
+
+  uint32_t metadataLength() const {
+    return metadataLength_;
+  }
+
+  /// Length of the whole frame.
+  size_t frameLength() const {
+    return length_;
+  }
+
+ private:
+  /// Types up to RESUME_OK, and EXT.
+  static constexpr uint64_t kKnownTypes = 0x7FFF | (uint64_t{1} << 0x3F);
+
+  /// Types whose metadata length follows the header, or the header and the
+  /// initial REQUEST_N.
+  static constexpr uint64_t kMetadataAfterHeader = (1 << 0x04) |
+      (1 << 0x05) | (1 << 0x0A); // REQUEST_RESPONSE, REQUEST_FNF, PAYLOAD
+  static constexpr uint64_t kMetadataAfterRequestN =
+      (1 << 0x06) | (1 << 0x07); // REQUEST_STREAM, REQUEST_CHANNEL
+
+  void decode(const uint8_t* bytes) {
+    uint64_t head;
+    uint64_t tail;
+    std::memcpy(&head, bytes, sizeof(head));
+    std::memcpy(&tail, bytes + sizeof(head), sizeof(tail));
+    head = folly::Endian::big(head);
+    tail = folly::Endian::big(tail);
+
+    // |R|Stream ID (31)|Frame Type (6)|I|M|Flags (8)|
+    auto const rawStreamId = static_cast<uint32_t>(head >> 32);
+    auto const typeAndFlags = static_cast<uint32_t>((head >> 16) & 0xFFFF);
+    auto const rawType = typeAndFlags >> 10;
+    auto const hasMetadata = (typeAndFlags >> 8) & 1;
+
+    streamId_ = rawStreamId & 0x7FFFFFFF;
+    flags_ = static_cast<FrameFlags>(typeAndFlags & 0x3FF);
+    type_ = static_cast<FrameType>(rawType * ((kKnownTypes >> rawType) & 1));
+
+    auto const afterHeader = (kMetadataAfterHeader >> rawType) & hasMetadata;
+    auto const afterRequestN =
+        (kMetadataAfterRequestN >> rawType) & hasMetadata;
+    metadataOffset_ = static_cast<uint32_t>(
+        afterHeader * kHeaderSize + afterRequestN * (kHeaderSize + 4));
+    metadataLength_ = static_cast<uint32_t>(
+        afterHeader * (((head & 0xFFFF) << 8) | (tail >> 56)) +
+        afterRequestN * ((tail >> 24) & 0xFFFFFF));
+
+    auto const metadataEnd = metadataOffset_ + 3 + uint64_t{metadataLength_};
+    valid_ = (length_ >= kHeaderSize) & ((rawStreamId >> 31) == 0) &
+        ((metadataOffset_ == 0) | (length_ >= metadataEnd));
+  }
+
+  size_t length_;
+  StreamId streamId_;
+  FrameType type_;
+  FrameFlags flags_;
+  uint32_t metadataOffset_;
+  uint32_t metadataLength_;
+  bool valid_;
+};
+
+} // namespace rsocket
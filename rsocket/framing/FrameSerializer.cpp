@@ -49,6 +49,17 @@ folly::IOBufQueue FrameSerializer::createBufferQueue(size_t bufferSize) const {
   return queue;
 }
 
+bool FrameSerializer::prependHeaderRoom(folly::IOBuf& buf, size_t headerSize)
+    const {
+  const auto prependSize =
+      preallocateFrameSizeField_ ? frameLengthFieldSize() : 0;
+  if (buf.isSharedOne() || buf.headroom() < headerSize + prependSize) {
+    return false;
+  }
+  buf.prepend(headerSize);
+  return true;
+}
+
 folly::Optional<StreamId> FrameSerializer::peekStreamId(
     const ProtocolVersion& protocolVersion,
     const folly::IOBuf& frame,
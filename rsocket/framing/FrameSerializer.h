@@ -19,6 +19,7 @@
 #include <memory>
 
 #include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameHeaderView.h"
 
 namespace rsocket {
 
@@ -40,6 +41,9 @@ class FrameSerializer {
       const folly::IOBuf& frame,
       bool skipFrameLengthBytes);
 
+  /// Decode the header of a frame without the frame length field.
+  virtual FrameHeaderView peekHeader(const folly::IOBuf& in) const = 0;
+
   virtual FrameType peekFrameType(const folly::IOBuf& in) const = 0;
   virtual folly::Optional<StreamId> peekStreamId(
       const folly::IOBuf& in,
@@ -106,8 +110,19 @@ class FrameSerializer {
   bool& preallocateFrameSizeField();
 
  protected:
+  // A queue holding one buffer of `bufferSize` bytes for a frame's header,
+  // after room for the frame length field when it is preallocated.  The
+  // buffer is a single combined allocation per frame.  It isn't pooled:
+  // IOBufPool only recycles the data, while a pooled buffer would cost a
+  // separate IOBuf and shared info, two allocations instead of one.  Frames
+  // that avoid the allocation do so through prependHeaderRoom().
   folly::IOBufQueue createBufferQueue(size_t bufferSize) const;
 
+  // Extends `buf` into its headroom by `headerSize` bytes, leaving room for
+  // the frame length field when it is preallocated.  Returns false, leaving
+  // `buf` untouched, if it is shared or lacks the headroom.
+  bool prependHeaderRoom(folly::IOBuf& buf, size_t headerSize) const;
+
  private:
   bool preallocateFrameSizeField_{false};
 };
@@ -39,10 +39,9 @@ static FrameType deserializeFrameType(uint16_t frameType) {
   return static_cast<FrameType>(frameType);
 }
 
-static void serializeHeaderInto(
-    folly::io::QueueAppender& appender,
-    const FrameHeader& header) {
-  appender.writeBE<int32_t>(static_cast<int32_t>(header.streamId));
+template <typename TWriter>
+static void serializeHeaderInto(TWriter& appender, const FrameHeader& header) {
+  appender.writeBE(static_cast<int32_t>(header.streamId));
 
   auto type = static_cast<uint8_t>(header.type); // 6 bit
   auto flags = static_cast<uint16_t>(header.flags); // 10 bit
@@ -62,16 +61,10 @@ static void deserializeHeaderFrom(folly::io::Cursor& cur, FrameHeader& header) {
       static_cast<FrameFlags>(((type & 0x3) << 8) | cur.readBE<uint8_t>());
 }
 
-static void serializeMetadataInto(
-    folly::io::QueueAppender& appender,
-    std::unique_ptr<folly::IOBuf> metadata) {
-  if (metadata == nullptr) {
-    return;
-  }
-
-  // metadata length field not included in the medatadata length
-  uint32_t metadataLength =
-      static_cast<uint32_t>(metadata->computeChainDataLength());
+template <typename TWriter>
+static void serializeMetadataLengthInto(
+    TWriter& appender,
+    uint32_t metadataLength) {
   CHECK_LT(metadataLength, kMaxMetadataLength)
       << "Metadata is too big to serialize";
 
@@ -79,7 +72,18 @@ static void serializeMetadataInto(
   appender.write(
       static_cast<uint8_t>((metadataLength >> 8) & 0xFF)); // second byte
   appender.write(static_cast<uint8_t>(metadataLength & 0xFF)); // third byte
+}
+
+static void serializeMetadataInto(
+    folly::io::QueueAppender& appender,
+    std::unique_ptr<folly::IOBuf> metadata) {
+  if (metadata == nullptr) {
+    return;
+  }
 
+  // metadata length field not included in the medatadata length
+  serializeMetadataLengthInto(
+      appender, static_cast<uint32_t>(metadata->computeChainDataLength()));
   appender.insert(std::move(metadata));
 }
 
@@ -103,22 +107,35 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::deserializeMetadataFrom(
   return metadata;
 }
 
+// Returns the rest of the frame `in`, from where `cur` stands, without
+// cloning it: the buffers the cursor has read past are freed and the frame's
+// own IOBuf is trimmed to become the data.  `cur` must be a cursor over `in`
+// and can't be used afterwards.
 static std::unique_ptr<folly::IOBuf> deserializeDataFrom(
-    folly::io::Cursor& cur) {
-  std::unique_ptr<folly::IOBuf> data;
-  auto totalLength = cur.totalLength();
+    folly::io::Cursor& cur,
+    std::unique_ptr<folly::IOBuf> in) {
+  const auto totalLength = cur.totalLength();
+  if (totalLength == 0) {
+    return nullptr;
+  }
 
-  if (totalLength > 0) {
-    cur.clone(data, totalLength);
+  auto consumed = in->computeChainDataLength() - totalLength;
+  while (consumed >= in->length()) {
+    consumed -= in->length();
+    in = in->pop();
   }
-  return data;
+  in->trimStart(consumed);
+  return in;
 }
 
+// Metadata is cloned out of the frame, which costs one IOBuf when it sits in
+// a single buffer, and the data takes over the frame itself.
 static Payload deserializePayloadFrom(
     folly::io::Cursor& cur,
+    std::unique_ptr<folly::IOBuf> in,
     FrameFlags flags) {
   auto metadata = FrameSerializerV1_0::deserializeMetadataFrom(cur, flags);
-  auto data = deserializeDataFrom(cur);
+  auto data = deserializeDataFrom(cur, std::move(in));
   return Payload(std::move(data), std::move(metadata));
 }
 
@@ -135,8 +152,47 @@ static uint32_t payloadFramingSize(const Payload& payload) {
   return (payload.metadata != nullptr ? kMedatadaLengthSize : 0);
 }
 
+std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInPlace(
+    const FrameHeader& header,
+    Payload& payload,
+    folly::Optional<uint32_t> requestN) const {
+  auto& first = payload.metadata ? payload.metadata : payload.data;
+  if (!first) {
+    return nullptr;
+  }
+
+  // The metadata length has to be computed before the header is prepended.
+  const auto metadataLength = payload.metadata
+      ? static_cast<uint32_t>(payload.metadata->computeChainDataLength())
+      : 0;
+  const auto headerSize = kFrameHeaderSize +
+      (requestN ? sizeof(uint32_t) : 0) + payloadFramingSize(payload);
+  if (!prependHeaderRoom(*first, headerSize)) {
+    return nullptr;
+  }
+
+  folly::io::RWPrivateCursor cur(first.get());
+  serializeHeaderInto(cur, header);
+  if (requestN) {
+    cur.writeBE<int32_t>(static_cast<int32_t>(*requestN));
+  }
+  if (payload.metadata) {
+    serializeMetadataLengthInto(cur, metadataLength);
+  }
+
+  auto out = std::move(first);
+  if (payload.data) {
+    out->prependChain(std::move(payload.data));
+  }
+  return out;
+}
+
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInternal(
     Frame_REQUEST_Base&& frame) const {
+  if (auto buf = serializeOutInPlace(
+          frame.header_, frame.payload_, frame.requestN_)) {
+    return buf;
+  }
   auto queue = createBufferQueue(
       FrameSerializerV1_0::kFrameHeaderSize + sizeof(uint32_t) +
       payloadFramingSize(frame.payload_));
@@ -162,7 +218,8 @@ static bool deserializeFromInternal(
       throw std::runtime_error("invalid request N");
     }
     frame.requestN_ = static_cast<uint32_t>(requestN);
-    frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    frame.payload_ =
+        deserializePayloadFrom(cur, std::move(in), frame.header_.flags);
   } catch (...) {
     return false;
   }
@@ -177,15 +234,13 @@ static size_t getResumeIdTokenFramingLength(
       : 0;
 }
 
+FrameHeaderView FrameSerializerV1_0::peekHeader(const folly::IOBuf& in) const {
+  return FrameHeaderView{in};
+}
+
 FrameType FrameSerializerV1_0::peekFrameType(const folly::IOBuf& in) const {
-  folly::io::Cursor cur(&in);
-  try {
-    cur.skip(sizeof(int32_t)); // streamId
-    uint8_t type = cur.readBE<uint8_t>(); // |Frame Type |I|M|
-    return deserializeFrameType(type >> 2);
-  } catch (...) {
-    return FrameType::RESERVED;
-  }
+  // Frames too short to hold a type decode as RESERVED.
+  return FrameHeaderView{in}.type();
 }
 
 folly::Optional<StreamId> FrameSerializerV1_0::peekStreamId(
@@ -218,6 +273,9 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_RESPONSE&& frame) const {
+  if (auto buf = serializeOutInPlace(frame.header_, frame.payload_)) {
+    return buf;
+  }
   auto queue =
       createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
   folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
@@ -228,6 +286,9 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_FNF&& frame) const {
+  if (auto buf = serializeOutInPlace(frame.header_, frame.payload_)) {
+    return buf;
+  }
   auto queue =
       createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
   folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
@@ -266,6 +327,9 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_PAYLOAD&& frame) const {
+  if (auto buf = serializeOutInPlace(frame.header_, frame.payload_)) {
+    return buf;
+  }
   auto queue =
       createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
   folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
@@ -403,7 +467,8 @@ bool FrameSerializerV1_0::deserializeFrom(
   folly::io::Cursor cur(in.get());
   try {
     deserializeHeaderFrom(cur, frame.header_);
-    frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    frame.payload_ =
+        deserializePayloadFrom(cur, std::move(in), frame.header_.flags);
   } catch (...) {
     return false;
   }
@@ -416,7 +481,8 @@ bool FrameSerializerV1_0::deserializeFrom(
   folly::io::Cursor cur(in.get());
   try {
     deserializeHeaderFrom(cur, frame.header_);
-    frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    frame.payload_ =
+        deserializePayloadFrom(cur, std::move(in), frame.header_.flags);
   } catch (...) {
     return false;
   }
@@ -448,7 +514,7 @@ bool FrameSerializerV1_0::deserializeFrom(
     deserializeHeaderFrom(cur, frame.header_);
     // metadata takes the rest of the frame, just like data in other frames
     // that's why we use deserializeDataFrom
-    frame.metadata_ = deserializeDataFrom(cur);
+    frame.metadata_ = deserializeDataFrom(cur, std::move(in));
   } catch (...) {
     return false;
   }
@@ -473,7 +539,8 @@ bool FrameSerializerV1_0::deserializeFrom(
   folly::io::Cursor cur(in.get());
   try {
     deserializeHeaderFrom(cur, frame.header_);
-    frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    frame.payload_ =
+        deserializePayloadFrom(cur, std::move(in), frame.header_.flags);
   } catch (...) {
     return false;
   }
@@ -487,7 +554,8 @@ bool FrameSerializerV1_0::deserializeFrom(
   try {
     deserializeHeaderFrom(cur, frame.header_);
     frame.errorCode_ = static_cast<ErrorCode>(cur.readBE<uint32_t>());
-    frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    frame.payload_ =
+        deserializePayloadFrom(cur, std::move(in), frame.header_.flags);
   } catch (...) {
     return false;
   }
@@ -505,7 +573,7 @@ bool FrameSerializerV1_0::deserializeFrom(
       throw std::runtime_error("invalid value for position");
     }
     frame.position_ = static_cast<ResumePosition>(position);
-    frame.data_ = deserializeDataFrom(cur);
+    frame.data_ = deserializeDataFrom(cur, std::move(in));
   } catch (...) {
     return false;
   }
@@ -548,7 +616,8 @@ bool FrameSerializerV1_0::deserializeFrom(
 
     auto dmtLen = cur.readBE<uint8_t>();
     frame.dataMimeType_ = cur.readFixedString(dmtLen);
-    frame.payload_ = deserializePayloadFrom(cur, frame.header_.flags);
+    frame.payload_ =
+        deserializePayloadFrom(cur, std::move(in), frame.header_.flags);
   } catch (...) {
     return false;
   }
@@ -573,7 +642,7 @@ bool FrameSerializerV1_0::deserializeFrom(
       throw std::runtime_error("invalid numberOfRequests value");
     }
     frame.numberOfRequests_ = static_cast<uint32_t>(numberOfRequests);
-    frame.metadata_ = deserializeDataFrom(cur);
+    frame.metadata_ = deserializeDataFrom(cur, std::move(in));
   } catch (...) {
     return false;
   }
@@ -30,6 +30,7 @@ class FrameSerializerV1_0 : public FrameSerializer {
       const folly::IOBuf& firstFrame,
       size_t skipBytes = 0);
 
+  FrameHeaderView peekHeader(const folly::IOBuf& in) const override;
   FrameType peekFrameType(const folly::IOBuf& in) const override;
   folly::Optional<StreamId> peekStreamId(
       const folly::IOBuf& in,
@@ -92,6 +93,15 @@ class FrameSerializerV1_0 : public FrameSerializer {
   std::unique_ptr<folly::IOBuf> serializeOutInternal(
       Frame_REQUEST_Base&& frame) const;
 
+  // Serializes a frame made of a header, an optional initial request N and a
+  // payload by writing the header, request N and metadata length into the
+  // headroom of the payload's first buffer.  Returns nullptr, leaving the
+  // payload untouched, if there is no room.
+  std::unique_ptr<folly::IOBuf> serializeOutInPlace(
+      const FrameHeader& header,
+      Payload& payload,
+      folly::Optional<uint32_t> requestN = folly::none) const;
+
   size_t frameLengthFieldSize() const override;
 };
 } // namespace rsocket
@@ -48,6 +48,14 @@ void FrameTransportImpl::connect() {
     // will create a hard reference for that case and keep the object alive
     // until setInput method returns
     auto connectionCopy = connection_;
+    connectionCopy->setWritabilityCallback(
+        [weakThis = std::weak_ptr<FrameTransportImpl>(shared_from_this())](
+            bool writable) {
+          auto self = weakThis.lock();
+          if (auto const processor = self ? self->frameProcessor_ : nullptr) {
+            processor->onWritabilityChanged(writable);
+          }
+        });
     connectionCopy->setInput(shared_from_this());
   }
 }
@@ -68,6 +76,7 @@ void FrameTransportImpl::close() {
   if (!connection_) {
     return;
   }
+  connection_->setWritabilityCallback(nullptr);
   connection_.reset();
 
   if (auto subscription = std::move(connectionInputSub_)) {
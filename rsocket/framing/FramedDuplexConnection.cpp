@@ -65,7 +65,8 @@ std::unique_ptr<folly::IOBuf> prependSize(
       << "payloadLength: " << payloadLength
       << " kMaxFrameLength: " << kMaxFrameLength;
 
-  if (payload->headroom() >= frameSizeFieldLength) {
+  if (!payload->isSharedOne() &&
+      payload->headroom() >= frameSizeFieldLength) {
     // move the data pointer back and write value to the payload
     payload->prepend(frameSizeFieldLength);
     folly::io::RWPrivateCursor cur(payload.get());
@@ -112,4 +113,9 @@ void FramedDuplexConnection::setInput(
   }
   inputReader_->setInput(std::move(framesSink));
 }
+
+void FramedDuplexConnection::setWritabilityCallback(
+    std::function<void(bool)> callback) {
+  inner_->setWritabilityCallback(std::move(callback));
+}
 } // namespace rsocket
@@ -34,6 +34,8 @@ class FramedDuplexConnection : public virtual DuplexConnection {
 
   void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
 
+  void setWritabilityCallback(std::function<void(bool)>) override;
+
   bool isFramed() const override {
     return true;
   }
@@ -56,23 +56,22 @@ size_t frameSizeWithoutLengthField(ProtocolVersion version, size_t frameSize) {
       ? frameSize - frameSizeFieldLength(version)
       : frameSize;
 }
-} // namespace
-
-size_t FramedReader::readFrameLength() const {
-  const auto fieldLength = frameSizeFieldLength(*version_);
-  DCHECK_GT(fieldLength, 0);
-
-  folly::io::Cursor cur{payloadQueue_.front()};
-  size_t frameLength = 0;
 
-  // Reading of arbitrary-sized big-endian integer.
-  for (size_t i = 0; i < fieldLength; ++i) {
-    frameLength <<= 8;
-    frameLength |= cur.read<uint8_t>();
+/// Cut the next `length` bytes out of the cursor as a frame.  Frames lying
+/// within one buffer share it, frames spanning buffers are copied into a
+/// contiguous one.
+std::unique_ptr<folly::IOBuf> cutFrame(folly::io::Cursor& cur, size_t length) {
+  std::unique_ptr<folly::IOBuf> frame;
+  if (cur.peekBytes().size() >= length) {
+    cur.clone(frame, length);
+  } else {
+    frame = folly::IOBuf::create(length);
+    cur.pull(frame->writableData(), length);
+    frame->append(length);
   }
-
-  return frameLength;
+  return frame;
 }
+} // namespace
 
 void FramedReader::onSubscribe(std::shared_ptr<Subscription> subscription) {
   subscription_ = std::move(subscription);
@@ -97,49 +96,76 @@ void FramedReader::parseFrames() {
   dispatchingFrames_ = true;
 
   while (allowance_.canConsume(1) && inner_) {
-    if (!ensureOrAutodetectProtocolVersion()) {
-      // At this point we dont have enough bytes on the wire or we errored out.
+    if (parsedFrames_.empty() && !cutFrames()) {
       break;
     }
 
-    auto const frameSizeFieldLen = frameSizeFieldLength(*version_);
-    if (payloadQueue_.chainLength() < frameSizeFieldLen) {
-      // We don't even have the next frame size value.
-      break;
+    auto nextFrame = std::move(parsedFrames_.front());
+    parsedFrames_.pop_front();
+
+    CHECK(allowance_.tryConsume(1));
+
+    VLOG(4) << "parsed frame length=" << nextFrame->length() << '\n'
+            << hexDump(nextFrame->clone()->moveToFbString());
+    inner_->onNext(std::move(nextFrame));
+  }
+
+  dispatchingFrames_ = false;
+}
+
+bool FramedReader::cutFrames() {
+  if (!ensureOrAutodetectProtocolVersion()) {
+    // At this point we dont have enough bytes on the wire or we errored out.
+    return false;
+  }
+
+  auto const frameSizeFieldLen = frameSizeFieldLength(*version_);
+  auto const minFrameLen = minimalFrameLength(*version_);
+
+  auto available = payloadQueue_.chainLength();
+  size_t consumed = 0;
+  folly::io::Cursor cur{payloadQueue_.front()};
+
+  // We need at least the next frame size value.
+  while (available >= frameSizeFieldLen) {
+    // Reading of arbitrary-sized big-endian integer.
+    size_t nextFrameSize = 0;
+    for (size_t i = 0; i < frameSizeFieldLen; ++i) {
+      nextFrameSize <<= 8;
+      nextFrameSize |= cur.read<uint8_t>();
     }
 
-    auto const nextFrameSize = readFrameLength();
-    if (nextFrameSize < minimalFrameLength(*version_)) {
-      error("Invalid frame - Frame size smaller than minimum");
+    if (nextFrameSize < minFrameLen) {
+      // Deliver the frames preceding the invalid one first.
+      if (parsedFrames_.empty()) {
+        error("Invalid frame - Frame size smaller than minimum");
+        return false;
+      }
       break;
     }
 
-    if (payloadQueue_.chainLength() <
-        frameSizeWithLengthField(*version_, nextFrameSize)) {
+    auto const frameSize = frameSizeWithLengthField(*version_, nextFrameSize);
+    if (available < frameSize) {
       // Need to accumulate more data.
       break;
     }
 
-    payloadQueue_.trimStart(frameSizeFieldLen);
     const auto payloadSize =
         frameSizeWithoutLengthField(*version_, nextFrameSize);
+    DCHECK_GT(payloadSize, 0);
+    parsedFrames_.push_back(cutFrame(cur, payloadSize));
 
-    DCHECK_GT(payloadSize, 0)
-        << "folly::IOBufQueue::split(0) returns a nullptr, can't have that";
-    auto nextFrame = payloadQueue_.split(payloadSize);
-
-    CHECK(allowance_.tryConsume(1));
-
-    VLOG(4) << "parsed frame length=" << nextFrame->length() << '\n'
-            << hexDump(nextFrame->clone()->moveToFbString());
-    inner_->onNext(std::move(nextFrame));
+    consumed += frameSize;
+    available -= frameSize;
   }
 
-  dispatchingFrames_ = false;
+  payloadQueue_.trimStart(consumed);
+  return !parsedFrames_.empty();
 }
 
 void FramedReader::onComplete() {
   payloadQueue_.move();
+  parsedFrames_.clear();
   auto subscription = std::move(subscription_);
   if (auto subscriber = std::move(inner_)) {
     // After this call the instance can be destroyed!
@@ -149,6 +175,7 @@ void FramedReader::onComplete() {
 
 void FramedReader::onError(folly::exception_wrapper ex) {
   payloadQueue_.move();
+  parsedFrames_.clear();
   auto subscription = std::move(subscription_);
   if (auto subscriber = std::move(inner_)) {
     // After this call the instance can be destroyed!
@@ -205,6 +232,7 @@ void FramedReader::error(std::string errorMsg) {
   VLOG(1) << "error: " << errorMsg;
 
   payloadQueue_.move();
+  parsedFrames_.clear();
   if (auto subscription = std::move(subscription_)) {
     subscription->cancel();
   }
@@ -16,6 +16,8 @@
 
 #include <folly/io/IOBufQueue.h>
 
+#include <deque>
+
 #include "rsocket/DuplexConnection.h"
 #include "rsocket/framing/ProtocolVersion.h"
 #include "rsocket/internal/Allowance.h"
@@ -52,7 +54,9 @@ class FramedReader : public DuplexConnection::Subscriber,
   void parseFrames();
   bool ensureOrAutodetectProtocolVersion();
 
-  size_t readFrameLength() const;
+  /// Cut every complete frame out of the payload queue in a single pass and
+  /// append them to the parsed frames.  Returns false if no frame was cut.
+  bool cutFrames();
 
   std::shared_ptr<yarpl::flowable::Subscription> subscription_;
   std::shared_ptr<DuplexConnection::Subscriber> inner_;
@@ -61,6 +65,10 @@ class FramedReader : public DuplexConnection::Subscriber,
   bool dispatchingFrames_{false};
 
   folly::IOBufQueue payloadQueue_{folly::IOBufQueue::cacheChainLength()};
+
+  /// Frames already cut from the payload queue but not yet delivered.
+  std::deque<std::unique_ptr<folly::IOBuf>> parsedFrames_;
+
   const std::shared_ptr<ProtocolVersion> version_;
 };
 
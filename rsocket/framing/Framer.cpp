@@ -174,7 +174,8 @@ std::unique_ptr<folly::IOBuf> Framer::prependSize(
       << "payloadLength: " << payloadLength
       << " kMaxFrameLength: " << kMaxFrameLength;
 
-  if (payload->headroom() >= frameSizeFieldLengthValue) {
+  if (!payload->isSharedOne() &&
+      payload->headroom() >= frameSizeFieldLengthValue) {
     // move the data pointer back and write value to the payload
     payload->prepend(frameSizeFieldLengthValue);
     folly::io::RWPrivateCursor cur(payload.get());
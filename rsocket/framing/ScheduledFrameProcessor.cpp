@@ -40,4 +40,12 @@ void ScheduledFrameProcessor::onTerminal(folly::exception_wrapper ew) {
       });
 }
 
+void ScheduledFrameProcessor::onWritabilityChanged(bool writable) {
+  CHECK(processor_) << "Calling onWritabilityChanged() after onTerminal()";
+
+  evb_->runInEventBaseThread([processor = processor_, writable] {
+    processor->onWritabilityChanged(writable);
+  });
+}
+
 } // namespace rsocket
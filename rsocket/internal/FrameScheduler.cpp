@@ -0,0 +1,104 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/FrameScheduler.h"
+
+#include <glog/logging.h>
+
+namespace rsocket {
+
+FrameScheduler::FrameScheduler(size_t quantum) : quantum_(quantum) {
+  CHECK_GT(quantum_, 0u);
+}
+
+void FrameScheduler::setQuantum(size_t quantum) {
+  CHECK_GT(quantum, 0u);
+  quantum_ = quantum;
+}
+
+void FrameScheduler::setPriority(StreamId streamId, StreamPriority priority) {
+  CHECK_GT(priority.weight, 0u);
+  priorities_.erase(streamId);
+  priorities_.insert(streamId, priority);
+}
+
+void FrameScheduler::forgetPriority(StreamId streamId) {
+  priorities_.erase(streamId);
+}
+
+void FrameScheduler::enqueue(
+    StreamId streamId,
+    std::unique_ptr<folly::IOBuf> frame) {
+  auto const length = frame->computeChainDataLength();
+  ++frames_;
+  bytes_ += length;
+
+  auto queue = queues_.find(streamId);
+  if (!queue) {
+    Queue fresh;
+    if (auto const priority = priorities_.find(streamId)) {
+      fresh.priority = *priority;
+    }
+    rounds_[fresh.priority.priorityClass].push_back(streamId);
+    queues_.insert(streamId, std::move(fresh));
+    queue = queues_.find(streamId);
+  }
+  queue->frames.emplace_back(length, std::move(frame));
+}
+
+std::unique_ptr<folly::IOBuf> FrameScheduler::dequeue() {
+  if (rounds_.empty()) {
+    return nullptr;
+  }
+
+  auto const round = rounds_.begin();
+  auto& turns = round->second;
+  while (true) {
+    auto const streamId = turns.front();
+    auto const queue = queues_.find(streamId);
+    DCHECK(queue);
+
+    if (!queue->credited) {
+      queue->credited = true;
+      queue->deficit += quantum_ * queue->priority.weight;
+    }
+
+    auto& next = queue->frames.front();
+    if (next.first > queue->deficit) {
+      // The turn is over, the credit carries over to the next one.
+      queue->credited = false;
+      turns.pop_front();
+      turns.push_back(streamId);
+      continue;
+    }
+
+    queue->deficit -= next.first;
+    --frames_;
+    bytes_ -= next.first;
+    auto frame = std::move(next.second);
+    queue->frames.pop_front();
+
+    if (queue->frames.empty()) {
+      // An idle stream keeps no credit.
+      queues_.erase(streamId);
+      turns.pop_front();
+      if (turns.empty()) {
+        rounds_.erase(round);
+      }
+    }
+    return frame;
+  }
+}
+
+} // namespace rsocket
@@ -0,0 +1,91 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+
+#include <folly/io/IOBuf.h>
+
+#include "rsocket/FrameSchedulingPolicy.h"
+#include "rsocket/internal/Common.h"
+#include "rsocket/internal/StreamMap.h"
+
+namespace rsocket {
+
+/// Per-stream queues of outbound frames, served by deficit round-robin.
+///
+/// Streams with frames waiting take turns within their priority class.  On
+/// each turn a stream is credited `quantum * weight` bytes and writes frames
+/// for as long as its credit covers them; credit that a turn leaves unused
+/// carries over while the stream stays busy.  A stream therefore gets its
+/// share of bytes no matter how large its frames are.
+class FrameScheduler {
+ public:
+  explicit FrameScheduler(size_t quantum = FrameSchedulingPolicy().quantum);
+
+  void setQuantum(size_t quantum);
+
+  /// Priority of the frames a stream enqueues from now on.  Streams without
+  /// one get the default priority.
+  void setPriority(StreamId, StreamPriority);
+  void forgetPriority(StreamId);
+
+  void enqueue(StreamId, std::unique_ptr<folly::IOBuf>);
+
+  /// The next frame to write, or null if none is waiting.
+  std::unique_ptr<folly::IOBuf> dequeue();
+
+  /// Whether frames of the given stream are waiting.
+  bool contains(StreamId streamId) const {
+    return queues_.contains(streamId);
+  }
+
+  bool empty() const {
+    return queues_.empty();
+  }
+
+  /// Number and total size of the frames waiting.
+  size_t frames() const {
+    return frames_;
+  }
+  size_t bytes() const {
+    return bytes_;
+  }
+
+ private:
+  struct Queue {
+    std::deque<std::pair<size_t, std::unique_ptr<folly::IOBuf>>> frames;
+    StreamPriority priority;
+    size_t deficit{0};
+
+    /// Whether the stream has been credited for its current turn.
+    bool credited{false};
+  };
+
+  size_t quantum_;
+
+  StreamMap<Queue> queues_;
+  StreamMap<StreamPriority> priorities_;
+
+  /// Streams with frames waiting, in turn order, by priority class.
+  std::map<uint8_t, std::deque<StreamId>> rounds_;
+
+  size_t frames_{0};
+  size_t bytes_{0};
+};
+
+} // namespace rsocket
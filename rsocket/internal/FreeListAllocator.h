@@ -0,0 +1,170 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace rsocket {
+
+namespace detail {
+
+/// Per-thread cache of freed blocks of one size.  Blocks are individually
+/// allocated with operator new, so a block may be freed on a different thread
+/// from the one that allocated it.
+template <size_t Size>
+class FreeList {
+ public:
+  /// Upper bound on the number of idle blocks cached by each thread.
+  static constexpr size_t kMaxCachedBlocks = 1024;
+
+  /// The calling thread's list, or null once it has been destroyed at thread
+  /// exit.
+  static FreeList* get() {
+    if (!current_ && !destroyed_) {
+      static thread_local FreeList list;
+    }
+    return current_;
+  }
+
+  FreeList() {
+    current_ = this;
+  }
+
+  ~FreeList() {
+    // Objects freed by later thread-local destructors bypass the cache.
+    current_ = nullptr;
+    destroyed_ = true;
+    while (head_) {
+      auto block = head_;
+      head_ = block->next;
+      ::operator delete(block);
+    }
+  }
+
+  void* allocate() {
+    if (auto block = head_) {
+      head_ = block->next;
+      --cached_;
+      return block;
+    }
+    return ::operator new(Size);
+  }
+
+  void deallocate(void* p) {
+    if (cached_ >= kMaxCachedBlocks) {
+      ::operator delete(p);
+      return;
+    }
+    auto block = static_cast<Block*>(p);
+    block->next = head_;
+    head_ = block;
+    ++cached_;
+  }
+
+  size_t cached() const {
+    return cached_;
+  }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  Block* head_{nullptr};
+  size_t cached_{0};
+
+  // Trivially destructible, so they can still be read from other thread-local
+  // destructors.
+  static thread_local FreeList* current_;
+  static thread_local bool destroyed_;
+};
+
+template <size_t Size>
+constexpr size_t FreeList<Size>::kMaxCachedBlocks;
+
+template <size_t Size>
+thread_local FreeList<Size>* FreeList<Size>::current_ = nullptr;
+
+template <size_t Size>
+thread_local bool FreeList<Size>::destroyed_ = false;
+
+/// Round up to 16 bytes so that similarly sized types share a free list.
+constexpr size_t freeListBlockSize(size_t size) {
+  return (size + 15) & ~size_t{15};
+}
+
+} // namespace detail
+
+/// Allocator that recycles single-object allocations through a thread-local
+/// free list, so hot allocate/free cycles do not reach malloc.  Meant for
+/// std::allocate_shared, which allocates the object and its control block as
+/// one block.
+template <typename T>
+class FreeListAllocator {
+ public:
+  using value_type = T;
+
+  FreeListAllocator() = default;
+
+  template <typename U>
+  /* implicit */ FreeListAllocator(const FreeListAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    auto list = n == 1 ? freeList() : nullptr;
+    if (!list) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(list->allocate());
+  }
+
+  void deallocate(T* p, size_t n) {
+    auto list = n == 1 ? freeList() : nullptr;
+    if (!list) {
+      ::operator delete(p);
+      return;
+    }
+    list->deallocate(p);
+  }
+
+  /// The calling thread's free list for T, or null during thread teardown.
+  static detail::FreeList<detail::freeListBlockSize(sizeof(T))>* freeList() {
+    static_assert(
+        alignof(T) <= alignof(std::max_align_t),
+        "Over-aligned types are not supported");
+    return detail::FreeList<detail::freeListBlockSize(sizeof(T))>::get();
+  }
+
+  template <typename U>
+  bool operator==(const FreeListAllocator<U>&) const {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const FreeListAllocator<U>&) const {
+    return false;
+  }
+};
+
+/// Like std::make_shared, but recycles the memory through FreeListAllocator.
+template <typename T, typename... Args>
+std::shared_ptr<T> makeFreeListShared(Args&&... args) {
+  return std::allocate_shared<T>(
+      FreeListAllocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace rsocket
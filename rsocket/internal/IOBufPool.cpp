@@ -0,0 +1,124 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/IOBufPool.h"
+
+#include <new>
+
+#include "rsocket/RSocketStats.h"
+
+namespace rsocket {
+
+constexpr std::array<size_t, 3> IOBufPool::kSizeClasses;
+constexpr size_t IOBufPool::kMaxIdleBytes;
+
+namespace {
+
+/// The calling thread's pool while it is alive.  Trivially destructible, so
+/// it can still be read from other thread-local destructors.
+thread_local IOBufPool* currentPool = nullptr;
+
+constexpr uintptr_t kSizeClassMask = 3;
+
+} // namespace
+
+IOBufPool& IOBufPool::get() {
+  static thread_local IOBufPool pool;
+  return pool;
+}
+
+IOBufPool::IOBufPool() {
+  static_assert(
+      kSizeClasses.size() <= kSizeClassMask + 1 &&
+          alignof(IOBufPool) > kSizeClassMask,
+      "Size classes must fit in the low bits of a pool pointer");
+  currentPool = this;
+}
+
+IOBufPool::~IOBufPool() {
+  // Buffers freed by later thread-local destructors bypass the pool.
+  currentPool = nullptr;
+  for (auto& head : idle_) {
+    while (head) {
+      auto slab = head;
+      head = slab->next;
+      ::operator delete(slab);
+    }
+  }
+}
+
+std::unique_ptr<folly::IOBuf> IOBufPool::allocate(
+    size_t size,
+    RSocketStats* stats) {
+  size_t sizeClass = 0;
+  while (sizeClass < kSizeClasses.size() && kSizeClasses[sizeClass] < size) {
+    ++sizeClass;
+  }
+  if (sizeClass == kSizeClasses.size()) {
+    return folly::IOBuf::create(size);
+  }
+
+  auto const capacity = kSizeClasses[sizeClass];
+  void* slab = idle_[sizeClass];
+  auto const hit = slab != nullptr;
+  if (hit) {
+    idle_[sizeClass] = idle_[sizeClass]->next;
+    counters_.footprint -= capacity;
+    ++counters_.hits;
+  } else {
+    slab = ::operator new(capacity);
+    ++counters_.misses;
+  }
+
+  if (stats) {
+    if (hit) {
+      stats->bufferPoolHit();
+    } else {
+      stats->bufferPoolMiss();
+    }
+    stats->bufferPoolFootprint(counters_.footprint);
+  }
+
+  return folly::IOBuf::takeOwnership(
+      slab,
+      capacity,
+      0,
+      &IOBufPool::release,
+      reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(this) | sizeClass));
+}
+
+void IOBufPool::release(void* slab, void* owner) {
+  auto const tagged = reinterpret_cast<uintptr_t>(owner);
+  // Only compared, never dereferenced: the owning pool may be gone.
+  if (currentPool &&
+      reinterpret_cast<uintptr_t>(currentPool) == (tagged & ~kSizeClassMask)) {
+    currentPool->recycle(slab, tagged & kSizeClassMask);
+  } else {
+    ::operator delete(slab);
+  }
+}
+
+void IOBufPool::recycle(void* slab, size_t sizeClass) {
+  auto const capacity = kSizeClasses[sizeClass];
+  if (counters_.footprint + capacity > kMaxIdleBytes) {
+    ::operator delete(slab);
+    return;
+  }
+  auto const idle = static_cast<Slab*>(slab);
+  idle->next = idle_[sizeClass];
+  idle_[sizeClass] = idle;
+  counters_.footprint += capacity;
+}
+
+} // namespace rsocket
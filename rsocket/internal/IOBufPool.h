@@ -0,0 +1,88 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <folly/io/IOBuf.h>
+
+namespace rsocket {
+
+class RSocketStats;
+
+/// Per-thread pool of fixed-size buffers for IOBufs, in a few size classes.
+///
+/// Each thread gets its own pool, so every EventBase has one.  Buffers are
+/// handed out as IOBufs owning a slab of the smallest class that fits.  When
+/// the IOBuf is freed on the thread that allocated it, the slab goes back to
+/// that thread's pool; freed anywhere else, or after the pool is gone, it goes
+/// back to the allocator.  Pools never touch each other, and slabs do not pile
+/// up on threads that only consume buffers.  Sizes above the largest class are
+/// not pooled.
+///
+/// Only the data buffer is recycled; the IOBuf itself and its shared info are
+/// still allocated, so the pool pays off for buffers of a few KB and up, such
+/// as socket read buffers, not for small frame headers.
+class IOBufPool {
+ public:
+  static constexpr std::array<size_t, 3> kSizeClasses{{4096, 16384, 65536}};
+
+  /// Upper bound on the bytes of idle slabs each thread keeps.
+  static constexpr size_t kMaxIdleBytes = 1024 * 1024;
+
+  struct Counters {
+    /// Buffers handed out from an idle slab.
+    size_t hits{0};
+    /// Buffers that needed a new slab.
+    size_t misses{0};
+    /// Bytes of idle slabs held by the pool.
+    size_t footprint{0};
+  };
+
+  static IOBufPool& get();
+
+  ~IOBufPool();
+
+  /// An empty IOBuf with at least `size` bytes of tailroom.  Reports the hit
+  /// or miss and the new footprint to `stats`, if given.
+  std::unique_ptr<folly::IOBuf> allocate(
+      size_t size,
+      RSocketStats* stats = nullptr);
+
+  const Counters& counters() const {
+    return counters_;
+  }
+
+ private:
+  struct Slab {
+    Slab* next;
+  };
+
+  IOBufPool();
+
+  /// Free function of the IOBufs handed out.  `owner` is the allocating pool
+  /// with the size class in its low bits.
+  static void release(void* slab, void* owner);
+
+  void recycle(void* slab, size_t sizeClass);
+
+  std::array<Slab*, kSizeClasses.size()> idle_{};
+  Counters counters_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,148 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace rsocket {
+
+constexpr size_t LatencyHistogram::kSubBucketBits;
+constexpr size_t LatencyHistogram::kSubBuckets;
+constexpr size_t LatencyHistogram::kMaxValueBits;
+constexpr size_t LatencyHistogram::kBuckets;
+constexpr size_t LatencyHistogram::kShards;
+
+namespace {
+
+/// Spreads threads over the shards round-robin, the first time they record.
+size_t shardIndex(size_t shards) {
+  static std::atomic<size_t> nextShard{0};
+  static thread_local const size_t shard =
+      nextShard.fetch_add(1, std::memory_order_relaxed);
+  return shard % shards;
+}
+
+size_t log2Floor(uint64_t value) {
+  size_t log = 0;
+  while (value >>= 1) {
+    ++log;
+  }
+  return log;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() {
+  for (auto& shard : shards_) {
+    shard.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+LatencyHistogram::~LatencyHistogram() {
+  for (auto& shard : shards_) {
+    delete shard.load(std::memory_order_relaxed);
+  }
+}
+
+LatencyHistogram::Shard& LatencyHistogram::shard() {
+  auto& slot = shards_[shardIndex(kShards)];
+  if (auto existing = slot.load(std::memory_order_acquire)) {
+    return *existing;
+  }
+
+  auto created = std::make_unique<Shard>();
+  for (auto& count : created->counts) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  // Another thread on the same shard may have got there first.
+  Shard* expected = nullptr;
+  if (slot.compare_exchange_strong(
+          expected,
+          created.get(),
+          std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+    return *created.release();
+  }
+  return *expected;
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t nanos) {
+  if (nanos < kSubBuckets) {
+    return nanos;
+  }
+  auto const shift = log2Floor(nanos) - kSubBucketBits;
+  auto const subBucket = (nanos >> shift) & (kSubBuckets - 1);
+  return std::min((shift + 1) * kSubBuckets + subBucket, kBuckets - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  auto const shift = bucket / kSubBuckets - 1;
+  auto const subBucket = bucket % kSubBuckets;
+  return ((kSubBuckets + subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  auto const nanos =
+      static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  shard().counts[bucketFor(nanos)].fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  Snapshot snapshot;
+  for (auto const& slot : shards_) {
+    auto const shard = slot.load(std::memory_order_acquire);
+    if (!shard) {
+      continue;
+    }
+    for (size_t i = 0; i < kBuckets; ++i) {
+      auto const count = shard->counts[i].load(std::memory_order_relaxed);
+      snapshot.counts_[i] += count;
+      snapshot.count_ += count;
+    }
+  }
+  return snapshot;
+}
+
+std::chrono::nanoseconds LatencyHistogram::Snapshot::percentile(
+    double percentile) const {
+  if (count_ == 0) {
+    return std::chrono::nanoseconds{0};
+  }
+  auto const clamped = std::min(std::max(percentile, 0.0), 100.0);
+  auto const rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(clamped / 100 * count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::chrono::nanoseconds{bucketUpperBound(i)};
+    }
+  }
+  return std::chrono::nanoseconds{bucketUpperBound(kBuckets - 1)};
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+  for (size_t i = 0; i < kBuckets; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+}
+
+} // namespace rsocket
@@ -0,0 +1,92 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace rsocket {
+
+/// Log-linear (HDR-style) histogram of durations, recorded without locks.
+///
+/// Each power of two of nanoseconds is split into kSubBuckets linear buckets,
+/// so a recorded value is known to within about 6%.  Writers are spread over a
+/// few shards by thread, so threads rarely contend on the same counters.  A
+/// shard is only allocated when a thread first records into it, so a
+/// histogram that is never recorded into, e.g. because
+/// RSocketStats::latenciesEnabled() is off, holds no counters.
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 4;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+
+  /// Durations of 2^kMaxValueBits ns (about 68 seconds) and longer all fall
+  /// into the last bucket.
+  static constexpr size_t kMaxValueBits = 36;
+
+  static constexpr size_t kBuckets =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+  /// A point-in-time copy of a histogram.  Snapshots of different histograms
+  /// can be merged, e.g. to aggregate several servers.
+  class Snapshot {
+   public:
+    uint64_t count() const {
+      return count_;
+    }
+
+    /// Upper bound of the bucket holding the given percentile (0 to 100).
+    /// Zero if nothing was recorded.
+    std::chrono::nanoseconds percentile(double percentile) const;
+
+    void merge(const Snapshot&);
+
+   private:
+    friend class LatencyHistogram;
+
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t count_{0};
+  };
+
+  LatencyHistogram();
+  ~LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(std::chrono::nanoseconds);
+
+  Snapshot snapshot() const;
+
+  static size_t bucketFor(uint64_t nanos);
+  static uint64_t bucketUpperBound(size_t bucket);
+
+ private:
+  static constexpr size_t kShards = 4;
+
+  struct Shard {
+    std::array<std::atomic<uint64_t>, kBuckets> counts;
+  };
+
+  /// The calling thread's shard, allocated if it is the first to record.
+  Shard& shard();
+
+  std::array<std::atomic<Shard*>, kShards> shards_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,53 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+
+#include "rsocket/Lease.h"
+
+namespace rsocket {
+
+/// Tracks how many requests are left under the current lease.  Used by the
+/// server for the lease it granted and by the client for the lease it holds.
+class LeaseBudget {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Replace the current lease with `lease`, received or sent at `now`.
+  void reset(const Lease& lease, Clock::time_point now) {
+    expiry_ = now + lease.ttl;
+    remaining_ = lease.numberOfRequests;
+  }
+
+  /// Take one request from the lease, if it has any left and hasn't expired.
+  bool tryConsume(Clock::time_point now) {
+    if (remaining_ == 0 || now >= expiry_) {
+      return false;
+    }
+    --remaining_;
+    return true;
+  }
+
+  uint32_t remaining(Clock::time_point now) const {
+    return now < expiry_ ? remaining_ : 0;
+  }
+
+ private:
+  Clock::time_point expiry_;
+  uint32_t remaining_{0};
+};
+
+} // namespace rsocket
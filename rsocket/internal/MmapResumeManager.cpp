@@ -0,0 +1,649 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/MmapResumeManager.h"
+
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/io/IOBuf.h>
+#include <folly/json.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace rsocket {
+
+namespace {
+
+constexpr uint64_t kFramesMagic = 0x31534d4152464b53; // "SKFRAMS1"
+constexpr uint64_t kJournalMagic = 0x314c4e524e4a4b53; // "SKJNRNL1"
+
+/// The header at the start of the frames file, followed by the ring.
+struct FramesHeader {
+  struct Positions {
+    int64_t firstSent;
+    int64_t lastSent;
+    int64_t implied;
+    uint64_t head;
+    uint32_t largestUsedStreamId;
+  };
+
+  uint64_t magic;
+  uint64_t capacity;
+  /// Which of `positions` is current.
+  uint64_t current;
+  Positions positions[2];
+};
+
+/// The header at the start of the journal, followed by its records.
+struct JournalHeader {
+  uint64_t magic;
+  /// Bytes of complete records in the journal.
+  uint64_t length;
+  /// Counts the journals the store has switched to.  A checkpoint covers the
+  /// journals before the epoch it records.
+  uint64_t epoch;
+};
+
+constexpr size_t kFramesHeaderSize = 4096;
+constexpr size_t kJournalHeaderSize = sizeof(JournalHeader);
+static_assert(sizeof(FramesHeader) <= kFramesHeaderSize, "");
+static_assert(std::is_trivially_copyable<FramesHeader>::value, "");
+
+using FrameLength = uint32_t;
+
+enum class JournalRecord : uint8_t {
+  OPEN = 1,
+  CLOSE = 2,
+  ALLOWANCE = 3,
+};
+
+constexpr folly::StringPiece kCheckpoint = "checkpoint";
+constexpr folly::StringPiece kEpoch = "Epoch";
+constexpr folly::StringPiece kStreams = "Streams";
+constexpr folly::StringPiece kStreamType = "StreamType";
+constexpr folly::StringPiece kRequester = "Requester";
+constexpr folly::StringPiece kStreamToken = "StreamToken";
+constexpr folly::StringPiece kProducerAllowance = "ProducerAllowance";
+constexpr folly::StringPiece kConsumerAllowance = "ConsumerAllowance";
+
+/// Opens `directory` and takes an exclusive flock on it, so that no other
+/// manager, in this process or another, maps the same store.
+folly::File lockDirectory(const std::string& directory) {
+  folly::File file(directory, O_RDONLY | O_DIRECTORY);
+  if (!file.try_lock()) {
+    throw std::runtime_error(
+        "Resume store in " + directory + " is open in another manager");
+  }
+  return file;
+}
+
+/// Maps all `length` bytes of the file at `path`, sizing it first if it is
+/// new.  MemoryMapping never maps past the end of the file, so an existing
+/// file of another size belongs to a store with another capacity.
+folly::MemoryMapping mapFile(const std::string& path, size_t length) {
+  folly::File file(path, O_RDWR | O_CREAT);
+  struct stat st;
+  folly::checkUnixError(fstat(file.fd(), &st), "fstat ", path);
+  if (st.st_size == 0) {
+    folly::checkUnixError(
+        ftruncate(file.fd(), static_cast<off_t>(length)), "ftruncate ", path);
+  } else if (static_cast<size_t>(st.st_size) != length) {
+    throw std::runtime_error(folly::sformat(
+        "{} holds {} bytes, not the {} the resume store is configured for",
+        path,
+        st.st_size,
+        length));
+  }
+  return folly::MemoryMapping(
+      std::move(file),
+      0,
+      static_cast<off_t>(length),
+      folly::MemoryMapping::writable());
+}
+
+FramesHeader& framesHeader(folly::MemoryMapping& mapping) {
+  return *reinterpret_cast<FramesHeader*>(mapping.writableRange().data());
+}
+
+JournalHeader& journalHeader(folly::MemoryMapping& mapping) {
+  return *reinterpret_cast<JournalHeader*>(mapping.writableRange().data());
+}
+
+const JournalHeader& journalHeader(const folly::MemoryMapping& mapping) {
+  return *reinterpret_cast<const JournalHeader*>(mapping.range().data());
+}
+
+template <typename T>
+void appendValue(std::string& record, T value) {
+  record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T readValue(folly::ByteRange& range) {
+  if (range.size() < sizeof(T)) {
+    throw std::runtime_error("Truncated resume journal record");
+  }
+  T value;
+  std::memcpy(&value, range.data(), sizeof(T));
+  range.advance(sizeof(T));
+  return value;
+}
+
+} // namespace
+
+MmapResumeManager::MmapResumeManager(
+    std::shared_ptr<RSocketStats> stats,
+    std::string directory)
+    : MmapResumeManager(std::move(stats), std::move(directory), Options()) {}
+
+MmapResumeManager::MmapResumeManager(
+    std::shared_ptr<RSocketStats> stats,
+    std::string directory,
+    Options options)
+    : stats_(std::move(stats)),
+      directory_(std::move(directory)),
+      options_(options),
+      lock_(lockDirectory(directory_)),
+      frames_(mapFile(
+          directory_ + "/frames",
+          kFramesHeaderSize + options.capacity)),
+      journals_{{mapFile(
+                     directory_ + "/journal.0",
+                     kJournalHeaderSize + options.journalCapacity),
+                 mapFile(
+                     directory_ + "/journal.1",
+                     kJournalHeaderSize + options.journalCapacity)}} {
+  CHECK_GT(options_.capacity, sizeof(FrameLength));
+  recoverFrames();
+  recoverStreams();
+}
+
+MmapResumeManager::~MmapResumeManager() {
+  try {
+    waitForCheckpoint();
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Failed to checkpoint resume store in " << directory_ << ": "
+               << ex.what();
+  }
+  stats_->resumeBufferChanged(
+      -static_cast<int>(index_.size()),
+      -static_cast<int>(lastSentPosition_ - firstSentPosition_));
+}
+
+void MmapResumeManager::recoverFrames() {
+  auto& header = framesHeader(frames_);
+  if (header.magic == 0) {
+    // A new store.
+    header.capacity = options_.capacity;
+    header.current = 0;
+    header.positions[0] = FramesHeader::Positions();
+    std::atomic_thread_fence(std::memory_order_release);
+    header.magic = kFramesMagic;
+    return;
+  }
+  if (header.magic != kFramesMagic) {
+    throw std::runtime_error("Not a resume frames file in " + directory_);
+  }
+  if (header.capacity != options_.capacity) {
+    throw std::runtime_error(folly::sformat(
+        "Resume frames in {} have a capacity of {} bytes, not {}",
+        directory_,
+        header.capacity,
+        options_.capacity));
+  }
+
+  const auto& positions = header.positions[header.current & 1];
+  firstSentPosition_ = positions.firstSent;
+  lastSentPosition_ = positions.lastSent;
+  impliedPosition_ = positions.implied;
+  largestUsedStreamId_ = positions.largestUsedStreamId;
+
+  // Rebuild the index from the frame lengths.
+  auto position = firstSentPosition_;
+  auto offset = static_cast<size_t>(positions.head);
+  while (position < lastSentPosition_) {
+    if (offset >= options_.capacity) {
+      throw std::runtime_error("Corrupt resume frames in " + directory_);
+    }
+    FrameLength length;
+    readRing(offset, sizeof(length), &length);
+    const auto recordSize = sizeof(length) + length;
+    if (used_ + recordSize > options_.capacity) {
+      throw std::runtime_error("Corrupt resume frames in " + directory_);
+    }
+    index_.push_back(Frame{position, offset});
+    used_ += recordSize;
+    offset = (offset + recordSize) % options_.capacity;
+    position += length;
+  }
+  if (position != lastSentPosition_) {
+    throw std::runtime_error("Corrupt resume frames in " + directory_);
+  }
+  tail_ = offset;
+
+  stats_->resumeBufferChanged(
+      static_cast<int>(index_.size()),
+      static_cast<int>(lastSentPosition_ - firstSentPosition_));
+}
+
+void MmapResumeManager::recoverStreams() {
+  std::string checkpointJson;
+  uint64_t checkpointEpoch = 0;
+  const auto checkpointPath = directory_ + "/" + kCheckpoint.str();
+  if (folly::readFile(checkpointPath.c_str(), checkpointJson)) {
+    auto state = folly::parseJson(checkpointJson);
+    checkpointEpoch = static_cast<uint64_t>(state[kEpoch].asInt());
+    for (const auto& item : state[kStreams].items()) {
+      const auto& info = item.second;
+      StreamResumeInfo streamResumeInfo(
+          static_cast<StreamType>(info[kStreamType].asInt()),
+          static_cast<RequestOriginator>(info[kRequester].asInt()),
+          info[kStreamToken].asString());
+      streamResumeInfo.producerAllowance = info[kProducerAllowance].asInt();
+      streamResumeInfo.consumerAllowance = info[kConsumerAllowance].asInt();
+      streamResumeInfos_.emplace(
+          folly::to<StreamId>(item.first.asString()),
+          std::move(streamResumeInfo));
+    }
+  }
+
+  // Replay the journals the checkpoint doesn't cover, oldest first.
+  std::array<size_t, 2> order{{0, 1}};
+  for (auto i : order) {
+    const auto magic = journalHeader(journals_[i]).magic;
+    if (magic != kJournalMagic && magic != 0) {
+      throw std::runtime_error("Not a resume journal in " + directory_);
+    }
+  }
+  if (journalHeader(journals_[1]).epoch < journalHeader(journals_[0]).epoch) {
+    std::swap(order[0], order[1]);
+  }
+  for (auto i : order) {
+    const auto& header = journalHeader(journals_[i]);
+    if (header.magic == kJournalMagic && header.epoch >= checkpointEpoch) {
+      replayJournal(journals_[i]);
+    }
+  }
+  activeJournal_ = order[1];
+
+  // Start over with an empty journal.
+  checkpoint();
+}
+
+void MmapResumeManager::replayJournal(const folly::MemoryMapping& journal) {
+  const auto& header = journalHeader(journal);
+  if (header.length > options_.journalCapacity) {
+    throw std::runtime_error("Corrupt resume journal in " + directory_);
+  }
+  auto records = journal.range().subpiece(
+      kJournalHeaderSize, static_cast<size_t>(header.length));
+
+  while (!records.empty()) {
+    const auto type = readValue<JournalRecord>(records);
+    const auto streamId = readValue<StreamId>(records);
+    switch (type) {
+      case JournalRecord::OPEN: {
+        const auto streamType = readValue<uint8_t>(records);
+        const auto requester = readValue<uint8_t>(records);
+        const auto tokenLength = readValue<uint32_t>(records);
+        if (records.size() < tokenLength) {
+          throw std::runtime_error("Truncated resume journal record");
+        }
+        std::string token(
+            reinterpret_cast<const char*>(records.data()), tokenLength);
+        records.advance(tokenLength);
+        streamResumeInfos_.erase(streamId);
+        streamResumeInfos_.emplace(
+            streamId,
+            StreamResumeInfo(
+                static_cast<StreamType>(streamType),
+                static_cast<RequestOriginator>(requester),
+                std::move(token)));
+        break;
+      }
+      case JournalRecord::CLOSE:
+        streamResumeInfos_.erase(streamId);
+        break;
+      case JournalRecord::ALLOWANCE: {
+        const auto allowance = readValue<uint64_t>(records);
+        auto it = streamResumeInfos_.find(streamId);
+        if (it != streamResumeInfos_.end()) {
+          it->second.consumerAllowance = allowance;
+        }
+        break;
+      }
+      default:
+        throw std::runtime_error("Corrupt resume journal in " + directory_);
+    }
+  }
+}
+
+void MmapResumeManager::checkpoint() {
+  rotateJournal();
+  waitForCheckpoint();
+}
+
+void MmapResumeManager::rotateJournal() {
+  // The other journal is only reused once the checkpoint that covers its
+  // records is in place.
+  waitForCheckpoint();
+
+  const auto epoch = journalHeader(journals_[activeJournal_]).epoch + 1;
+  activeJournal_ ^= 1;
+  auto& header = journalHeader(journals_[activeJournal_]);
+  // Emptied before it is numbered, so that a crash in between never replays
+  // the old records on top of a newer checkpoint.
+  header.length = 0;
+  std::atomic_thread_fence(std::memory_order_release);
+  header.epoch = epoch;
+  std::atomic_thread_fence(std::memory_order_release);
+  header.magic = kJournalMagic;
+
+  folly::dynamic streams = folly::dynamic::object();
+  for (const auto& it : streamResumeInfos_) {
+    const auto& info = it.second;
+    streams.insert(
+        folly::to<std::string>(it.first),
+        folly::dynamic::object(kStreamType, static_cast<int>(info.streamType))(
+            kRequester, static_cast<int>(info.requester))(
+            kStreamToken, info.streamToken)(
+            kProducerAllowance, info.producerAllowance)(
+            kConsumerAllowance, info.consumerAllowance));
+  }
+  auto json = folly::toJson(
+      folly::dynamic::object(kEpoch, static_cast<int64_t>(epoch))(
+          kStreams, std::move(streams)));
+  auto path = directory_ + "/" + kCheckpoint.str();
+
+  if (!options_.checkpointExecutor) {
+    folly::writeFileAtomic(path, json);
+    return;
+  }
+  pendingCheckpoint_ = folly::via(
+      options_.checkpointExecutor,
+      [path = std::move(path), json = std::move(json)] {
+        folly::writeFileAtomic(path, json);
+      });
+}
+
+void MmapResumeManager::waitForCheckpoint() {
+  std::exchange(pendingCheckpoint_, folly::makeFuture()).get();
+}
+
+void MmapResumeManager::sync() {
+  for (auto* mapping : {&frames_, &journals_[0], &journals_[1]}) {
+    auto range = mapping->writableRange();
+    if (::msync(range.data(), range.size(), MS_SYNC) != 0) {
+      folly::throwSystemError("msync failed for resume store in ", directory_);
+    }
+  }
+}
+
+void MmapResumeManager::commitPositions() {
+  auto& header = framesHeader(frames_);
+  const auto spare = (header.current + 1) & 1;
+  auto& positions = header.positions[spare];
+  positions.firstSent = firstSentPosition_;
+  positions.lastSent = lastSentPosition_;
+  positions.implied = impliedPosition_;
+  positions.head = index_.empty() ? tail_ : index_.front().offset;
+  positions.largestUsedStreamId = largestUsedStreamId_;
+
+  // Switching copies is a single store, so a crash leaves one of them intact.
+  std::atomic_thread_fence(std::memory_order_release);
+  header.current = spare;
+}
+
+void MmapResumeManager::trackReceivedFrame(
+    size_t frameLength,
+    FrameType frameType,
+    StreamId streamId,
+    size_t consumerAllowance) {
+  if (!shouldTrackFrame(frameType)) {
+    return;
+  }
+  updateAllowance(streamId, consumerAllowance);
+  impliedPosition_ += frameLength;
+  commitPositions();
+}
+
+void MmapResumeManager::trackSentFrame(
+    const folly::IOBuf& serializedFrame,
+    FrameType frameType,
+    StreamId streamId,
+    size_t consumerAllowance) {
+  if (!shouldTrackFrame(frameType)) {
+    return;
+  }
+  updateAllowance(streamId, consumerAllowance);
+
+  const auto frameDataLength = serializedFrame.computeChainDataLength();
+  const auto recordSize = sizeof(FrameLength) + frameDataLength;
+
+  // If the frame is too huge, we don't cache it.  We empty the entire cache
+  // instead.
+  if (recordSize > options_.capacity) {
+    resetUpToPosition(lastSentPosition_);
+    lastSentPosition_ += frameDataLength;
+    firstSentPosition_ = lastSentPosition_;
+    commitPositions();
+    return;
+  }
+
+  while (used_ + recordSize > options_.capacity) {
+    evictFrame();
+  }
+
+  const auto length = static_cast<FrameLength>(frameDataLength);
+  writeRing(tail_, &length, sizeof(length));
+  auto offset = (tail_ + sizeof(length)) % options_.capacity;
+  for (const auto range : serializedFrame) {
+    writeRing(offset, range.data(), range.size());
+    offset = (offset + range.size()) % options_.capacity;
+  }
+
+  index_.push_back(Frame{lastSentPosition_, tail_});
+  tail_ = offset;
+  used_ += recordSize;
+  lastSentPosition_ += frameDataLength;
+  commitPositions();
+  stats_->resumeBufferChanged(1, static_cast<int>(frameDataLength));
+}
+
+void MmapResumeManager::resetUpToPosition(ResumePosition position) {
+  if (position <= firstSentPosition_) {
+    return;
+  }
+  if (position > lastSentPosition_) {
+    position = lastSentPosition_;
+  }
+
+  clearFrames(position);
+  // Positions are frame boundaries, but keep the ring consistent even if the
+  // peer acknowledges part of a frame.
+  firstSentPosition_ =
+      index_.empty() ? lastSentPosition_ : index_.front().position;
+  commitPositions();
+}
+
+void MmapResumeManager::evictFrame() {
+  DCHECK(!index_.empty());
+  resetUpToPosition(
+      index_.size() > 1 ? index_[1].position : lastSentPosition_);
+}
+
+void MmapResumeManager::clearFrames(ResumePosition position) {
+  size_t frames = 0;
+  while (!index_.empty() && index_.front().position < position) {
+    const auto next =
+        index_.size() > 1 ? index_[1].position : lastSentPosition_;
+    used_ -= sizeof(FrameLength) +
+        static_cast<size_t>(next - index_.front().position);
+    index_.pop_front();
+    ++frames;
+  }
+  const auto pos = index_.empty() ? position : index_.front().position;
+  stats_->resumeBufferChanged(
+      -static_cast<int>(frames), -static_cast<int>(pos - firstSentPosition_));
+}
+
+bool MmapResumeManager::isPositionAvailable(ResumePosition position) const {
+  return position == lastSentPosition_ ||
+      std::binary_search(
+             index_.begin(),
+             index_.end(),
+             Frame{position, 0},
+             [](const Frame& a, const Frame& b) {
+               return a.position < b.position;
+             });
+}
+
+void MmapResumeManager::sendFramesFromPosition(
+    ResumePosition position,
+    FrameTransport& transport) const {
+  DCHECK(isPositionAvailable(position));
+
+  auto found = std::lower_bound(
+      index_.begin(),
+      index_.end(),
+      position,
+      [](const Frame& frame, ResumePosition pos) {
+        return frame.position < pos;
+      });
+
+  for (; found != index_.end(); ++found) {
+    const auto next = std::next(found);
+    const auto end = next == index_.end() ? lastSentPosition_ : next->position;
+    const auto length = static_cast<size_t>(end - found->position);
+    auto frame = folly::IOBuf::create(length);
+    readRing(
+        (found->offset + sizeof(FrameLength)) % options_.capacity,
+        length,
+        frame->writableData());
+    frame->append(length);
+    transport.outputFrameOrDrop(std::move(frame));
+  }
+}
+
+void MmapResumeManager::onStreamOpen(
+    StreamId streamId,
+    RequestOriginator requester,
+    std::string streamToken,
+    StreamType streamType) {
+  CHECK(streamType != StreamType::FNF);
+  CHECK(streamResumeInfos_.find(streamId) == streamResumeInfos_.end());
+  if (requester == RequestOriginator::LOCAL &&
+      streamId > largestUsedStreamId_) {
+    largestUsedStreamId_ = streamId;
+    commitPositions();
+  }
+
+  std::string record;
+  appendValue(record, JournalRecord::OPEN);
+  appendValue(record, streamId);
+  appendValue(record, static_cast<uint8_t>(streamType));
+  appendValue(record, static_cast<uint8_t>(requester));
+  appendValue(record, static_cast<uint32_t>(streamToken.size()));
+  record += streamToken;
+
+  streamResumeInfos_.emplace(
+      streamId,
+      StreamResumeInfo(streamType, requester, std::move(streamToken)));
+  appendJournal(record);
+}
+
+void MmapResumeManager::onStreamClosed(StreamId streamId) {
+  if (streamResumeInfos_.erase(streamId) == 0) {
+    return;
+  }
+  std::string record;
+  appendValue(record, JournalRecord::CLOSE);
+  appendValue(record, streamId);
+  appendJournal(record);
+}
+
+void MmapResumeManager::updateAllowance(
+    StreamId streamId,
+    size_t consumerAllowance) {
+  auto it = streamResumeInfos_.find(streamId);
+  // The stream may already be closed, if this frame was the one that closed
+  // it.
+  if (it == streamResumeInfos_.end() ||
+      it->second.consumerAllowance == consumerAllowance) {
+    return;
+  }
+  it->second.consumerAllowance = consumerAllowance;
+
+  std::string record;
+  appendValue(record, JournalRecord::ALLOWANCE);
+  appendValue(record, streamId);
+  appendValue(record, static_cast<uint64_t>(consumerAllowance));
+  appendJournal(record);
+}
+
+void MmapResumeManager::appendJournal(const std::string& record) {
+  auto* journal = &journals_[activeJournal_];
+  if (record.size() >
+      options_.journalCapacity - journalHeader(*journal).length) {
+    // The change was already applied to the StreamResumeInfos, so the
+    // checkpoint covers it.  It still goes to the new journal, which stands
+    // in for the checkpoint until that is in place; replaying it on top of
+    // the checkpoint is harmless.
+    rotateJournal();
+    if (record.size() > options_.journalCapacity) {
+      waitForCheckpoint();
+      return;
+    }
+    journal = &journals_[activeJournal_];
+  }
+  auto& header = journalHeader(*journal);
+  std::memcpy(
+      journal->writableRange().data() + kJournalHeaderSize + header.length,
+      record.data(),
+      record.size());
+
+  // The record only counts once it is complete.
+  std::atomic_thread_fence(std::memory_order_release);
+  header.length += record.size();
+}
+
+void MmapResumeManager::writeRing(
+    size_t offset,
+    const void* data,
+    size_t length) {
+  auto ring = frames_.writableRange().data() + kFramesHeaderSize;
+  const auto head = std::min(length, options_.capacity - offset);
+  std::memcpy(ring + offset, data, head);
+  std::memcpy(ring, static_cast<const uint8_t*>(data) + head, length - head);
+}
+
+void MmapResumeManager::readRing(size_t offset, size_t length, void* out)
+    const {
+  auto ring = frames_.range().data() + kFramesHeaderSize;
+  const auto head = std::min(length, options_.capacity - offset);
+  std::memcpy(out, ring + offset, head);
+  std::memcpy(static_cast<uint8_t*>(out) + head, ring, length - head);
+}
+
+} // namespace rsocket
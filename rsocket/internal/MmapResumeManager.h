@@ -0,0 +1,206 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/File.h>
+#include <folly/futures/Future.h>
+#include <folly/system/MemoryMapping.h>
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "rsocket/RSocketStats.h"
+#include "rsocket/ResumeManager.h"
+
+namespace rsocket {
+
+/// A ResumeManager for cold resumption that keeps its state in files, so
+/// that a process can resume its connections after it crashes or restarts.
+///
+/// The store lives in a directory, which only one MmapResumeManager at a time
+/// may open, in four files:
+///
+/// - `frames`: the sent frames, in a ring of `capacity` bytes mapped into
+///   memory, each prefixed with its length.  The positions are kept in a
+///   header at the start of the file, in two copies, and a single store
+///   switches to the updated copy once a change is complete.  Tracking a frame
+///   is a copy into the ring and a header update, and acknowledged frames are
+///   compacted away by moving the start of the ring.
+///
+/// - `journal.0` and `journal.1`: append-only logs, mapped into memory, of
+///   the changes to the StreamResumeInfos: streams opened and closed, and
+///   allowances updated.  Changes go to one journal until it fills up, and
+///   then to the other, while the StreamResumeInfos are checkpointed.
+///
+/// - `checkpoint`: all the StreamResumeInfos, rewritten atomically whenever
+///   a journal fills up.  The rewrite runs on `Options::checkpointExecutor`
+///   if there is one, and the manager only waits for it when the journal it
+///   switched to fills up in turn.
+///
+/// Opening an existing store recovers its state: the frame index is rebuilt
+/// from the lengths in the ring, and the journals the checkpoint doesn't
+/// cover yet are replayed on top of it.  Everything written before a process
+/// crash survives it.  Surviving a power loss as well needs sync().
+///
+/// The files are in the native byte order, and are not meant to be moved
+/// between machines.
+class MmapResumeManager : public ResumeManager {
+ public:
+  struct Options {
+    /// Bytes in the ring of sent frames, including a 4-byte length per frame.
+    size_t capacity{1024 * 1024};
+
+    /// Bytes in each journal.
+    size_t journalCapacity{256 * 1024};
+
+    /// Where checkpoints are written, off the thread using the manager.  They
+    /// are written inline if this is null.  Must outlive the manager.
+    folly::Executor* checkpointExecutor{nullptr};
+  };
+
+  /// Opens the store in `directory`, which must exist, recovering the state
+  /// already in it.  Throws if another manager has the store open, if the
+  /// files can't be created or mapped, or if they are corrupt or were created
+  /// with a different capacity.
+  MmapResumeManager(
+      std::shared_ptr<RSocketStats> stats,
+      std::string directory,
+      Options options);
+  MmapResumeManager(
+      std::shared_ptr<RSocketStats> stats,
+      std::string directory);
+  ~MmapResumeManager();
+
+  void trackReceivedFrame(
+      size_t frameLength,
+      FrameType frameType,
+      StreamId streamId,
+      size_t consumerAllowance) override;
+
+  void trackSentFrame(
+      const folly::IOBuf& serializedFrame,
+      FrameType frameType,
+      StreamId streamId,
+      size_t consumerAllowance) override;
+
+  void resetUpToPosition(ResumePosition position) override;
+
+  bool isPositionAvailable(ResumePosition position) const override;
+
+  void sendFramesFromPosition(
+      ResumePosition position,
+      FrameTransport& transport) const override;
+
+  ResumePosition firstSentPosition() const override {
+    return firstSentPosition_;
+  }
+
+  ResumePosition lastSentPosition() const override {
+    return lastSentPosition_;
+  }
+
+  ResumePosition impliedPosition() const override {
+    return impliedPosition_;
+  }
+
+  void onStreamOpen(
+      StreamId,
+      RequestOriginator,
+      std::string streamToken,
+      StreamType) override;
+
+  void onStreamClosed(StreamId streamId) override;
+
+  const StreamResumeInfos& getStreamResumeInfos() const override {
+    return streamResumeInfos_;
+  }
+
+  StreamId getLargestUsedStreamId() const override {
+    return largestUsedStreamId_;
+  }
+
+  /// Writes the StreamResumeInfos to the checkpoint and switches journals,
+  /// returning once the checkpoint is in place.
+  void checkpoint();
+
+  /// Flushes the mapped files to disk.
+  void sync();
+
+  /// Bytes of the ring in use, including the length prefixes.
+  size_t size() const {
+    return used_;
+  }
+
+ private:
+  struct Frame {
+    ResumePosition position;
+    size_t offset;
+  };
+
+  void recoverFrames();
+  void recoverStreams();
+
+  /// Writes the positions to the spare copy of the header and makes it the
+  /// current one.
+  void commitPositions();
+
+  void evictFrame();
+  void clearFrames(ResumePosition position);
+
+  void writeRing(size_t offset, const void* data, size_t length);
+  void readRing(size_t offset, size_t length, void* out) const;
+
+  void updateAllowance(StreamId streamId, size_t consumerAllowance);
+  void appendJournal(const std::string& record);
+  void replayJournal(const folly::MemoryMapping& journal);
+
+  /// Switches to the other journal and starts a checkpoint of the
+  /// StreamResumeInfos.
+  void rotateJournal();
+  /// Waits for the last checkpoint, throwing if it failed.
+  void waitForCheckpoint();
+
+  const std::shared_ptr<RSocketStats> stats_;
+  const std::string directory_;
+  const Options options_;
+
+  // Holds an exclusive flock on the directory.
+  folly::File lock_;
+
+  folly::MemoryMapping frames_;
+  std::array<folly::MemoryMapping, 2> journals_;
+  // The journal changes are appended to
+  size_t activeJournal_{0};
+  // Done once the last checkpoint is in place
+  folly::Future<folly::Unit> pendingCheckpoint_{folly::makeFuture()};
+
+  ResumePosition firstSentPosition_{0};
+  ResumePosition lastSentPosition_{0};
+  ResumePosition impliedPosition_{0};
+  StreamId largestUsedStreamId_{0};
+
+  // The position and ring offset of every frame in the ring
+  std::deque<Frame> index_;
+  // Where the next frame goes in the ring
+  size_t tail_{0};
+  size_t used_{0};
+
+  StreamResumeInfos streamResumeInfos_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,85 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/ReadBufferSizer.h"
+
+#include <algorithm>
+
+namespace rsocket {
+
+constexpr size_t ReadBufferSizer::kFrameLengthFieldSize;
+constexpr size_t ReadBufferSizer::kSmallReadsBeforeShrink;
+
+ReadBufferSizer::ReadBufferSizer(
+    size_t minSize,
+    size_t maxSize,
+    bool trackFrames)
+    : minSize_(std::max<size_t>(minSize, 1)),
+      maxSize_(std::max(maxSize, minSize_)),
+      trackFrames_(trackFrames),
+      size_(minSize_) {}
+
+size_t ReadBufferSizer::nextReadSize() const {
+  if (auto const frameSize = incompleteFrameSize()) {
+    // The rest of a frame larger than the largest read takes several reads,
+    // so a peer can't make us allocate more by announcing a large frame.
+    return std::max(size_, std::min(frameSize - frameBytesRead_, maxSize_));
+  }
+  return size_;
+}
+
+void ReadBufferSizer::onRead(const uint8_t* data, size_t len, size_t offered) {
+  if (trackFrames_) {
+    trackFrames(data, len);
+  }
+
+  if (len >= offered) {
+    size_ = std::min(size_ * 2, maxSize_);
+    smallReads_ = 0;
+  } else if (len < size_ / 4) {
+    if (++smallReads_ >= kSmallReadsBeforeShrink) {
+      size_ = std::max(size_ / 2, minSize_);
+      smallReads_ = 0;
+    }
+  } else {
+    smallReads_ = 0;
+  }
+}
+
+void ReadBufferSizer::trackFrames(const uint8_t* data, size_t len) {
+  while (len > 0) {
+    if (lengthBytesRead_ < kFrameLengthFieldSize) {
+      frameLength_ = (frameLength_ << 8) | *data;
+      ++data;
+      --len;
+      ++lengthBytesRead_;
+      ++frameBytesRead_;
+    } else {
+      auto const frameSize = kFrameLengthFieldSize + frameLength_;
+      auto const n = std::min(len, frameSize - frameBytesRead_);
+      data += n;
+      len -= n;
+      frameBytesRead_ += n;
+    }
+
+    if (lengthBytesRead_ == kFrameLengthFieldSize &&
+        frameBytesRead_ == kFrameLengthFieldSize + frameLength_) {
+      lengthBytesRead_ = 0;
+      frameLength_ = 0;
+      frameBytesRead_ = 0;
+    }
+  }
+}
+
+} // namespace rsocket
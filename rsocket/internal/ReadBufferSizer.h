@@ -0,0 +1,80 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rsocket {
+
+/// Picks the size of the buffer offered to each read from a byte-stream
+/// transport.
+///
+/// The size starts at the minimum.  It doubles every time a read fills its
+/// buffer, so bulk transfers quickly move to large reads.  It halves after a
+/// run of reads that use less than a quarter of it, so idle and chatty
+/// connections go back to small buffers.
+///
+/// With frame tracking, the sizer also follows the RSocket 1.0 frames in the
+/// stream, each prefixed with a 24-bit big-endian length.  Once the length of
+/// a frame is known, the next read is made large enough for the rest of it,
+/// up to the maximum size.
+class ReadBufferSizer {
+ public:
+  static constexpr size_t kFrameLengthFieldSize = 3;
+
+  /// Reads that use less than a quarter of the buffer this many times in a
+  /// row halve the read size.
+  static constexpr size_t kSmallReadsBeforeShrink = 2;
+
+  ReadBufferSizer(size_t minSize, size_t maxSize, bool trackFrames);
+
+  /// The number of bytes to offer to the next read.
+  size_t nextReadSize() const;
+
+  /// Record that a read into a buffer of `offered` bytes returned the `len`
+  /// bytes at `data`.
+  void onRead(const uint8_t* data, size_t len, size_t offered);
+
+  /// The bytes read so far of the frame that is not complete yet, including
+  /// its length field.
+  size_t incompleteFrameBytes() const {
+    return frameBytesRead_;
+  }
+
+  /// The full size of the incomplete frame, including its length field, or 0
+  /// if its length field is not complete yet.
+  size_t incompleteFrameSize() const {
+    return lengthBytesRead_ == kFrameLengthFieldSize
+        ? kFrameLengthFieldSize + frameLength_
+        : 0;
+  }
+
+ private:
+  void trackFrames(const uint8_t* data, size_t len);
+
+  const size_t minSize_;
+  const size_t maxSize_;
+  const bool trackFrames_;
+
+  size_t size_;
+  size_t smallReads_{0};
+
+  size_t lengthBytesRead_{0};
+  size_t frameLength_{0};
+  size_t frameBytesRead_{0};
+};
+
+} // namespace rsocket
@@ -0,0 +1,43 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/ReassemblyBudget.h"
+
+#include <glog/logging.h>
+
+namespace rsocket {
+
+bool ReassemblyBudget::tryReserve(size_t bytes) {
+  auto const limit = limits_.maxConnectionBytes;
+  if (limit == 0) {
+    reserved_.fetch_add(bytes, std::memory_order_relaxed);
+    return true;
+  }
+
+  auto current = reserved_.load(std::memory_order_relaxed);
+  do {
+    if (bytes > limit || current > limit - bytes) {
+      return false;
+    }
+  } while (!reserved_.compare_exchange_weak(
+      current, current + bytes, std::memory_order_relaxed));
+  return true;
+}
+
+void ReassemblyBudget::release(size_t bytes) {
+  auto const previous = reserved_.fetch_sub(bytes, std::memory_order_relaxed);
+  DCHECK_GE(previous, bytes);
+}
+
+} // namespace rsocket
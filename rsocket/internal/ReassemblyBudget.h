@@ -0,0 +1,54 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "rsocket/ReassemblyLimits.h"
+
+namespace rsocket {
+
+/// Counts the bytes of fragments held by the streams of a connection against
+/// its ReassemblyLimits.
+///
+/// Streams release their bytes when they are destroyed, which may happen on a
+/// different thread than the connection's, so the count is atomic.
+class ReassemblyBudget {
+ public:
+  explicit ReassemblyBudget(ReassemblyLimits limits) : limits_(limits) {}
+
+  const ReassemblyLimits& limits() const {
+    return limits_;
+  }
+
+  /// Counts `bytes` more held bytes, unless that would exceed the connection
+  /// limit.  Returns whether they were counted.
+  bool tryReserve(size_t bytes);
+
+  /// Stops counting `bytes` previously reserved.
+  void release(size_t bytes);
+
+  /// The bytes held by all streams of the connection.
+  size_t reserved() const {
+    return reserved_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const ReassemblyLimits limits_;
+  std::atomic<size_t> reserved_{0};
+};
+
+} // namespace rsocket
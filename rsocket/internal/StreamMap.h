@@ -0,0 +1,213 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+/// Flat open-addressing map from stream IDs to values.
+///
+/// Stream IDs are allocated densely (odd ones by clients, even ones by
+/// servers), so a slot is picked directly by `streamId >> 1`, which keeps live
+/// streams in neighbouring slots without collisions.  Collisions are resolved
+/// by linear probing.  Erased slots become tombstones which later insertions
+/// reuse, and lookups never probe further than the longest probe sequence an
+/// insertion has needed.
+template <typename T>
+class StreamMap {
+ public:
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /// Returns a pointer to the value stored for the stream, or nullptr.  The
+  /// pointer is invalidated by any insertion.
+  T* find(StreamId streamId) {
+    auto const index = findIndex(streamId);
+    return index == kNotFound ? nullptr : &slots_[index].value;
+  }
+
+  const T* find(StreamId streamId) const {
+    auto const index = findIndex(streamId);
+    return index == kNotFound ? nullptr : &slots_[index].value;
+  }
+
+  bool contains(StreamId streamId) const {
+    return findIndex(streamId) != kNotFound;
+  }
+
+  /// Inserts a value for the stream.  Returns false, dropping the value, if
+  /// the stream is already present.
+  bool insert(StreamId streamId, T value) {
+    DCHECK(streamId != kEmpty && streamId != kTombstone);
+    if (contains(streamId)) {
+      return false;
+    }
+
+    if ((size_ + tombstones_ + 1) * 4 > slots_.size() * 3) {
+      // Grow so that the table ends up at most half full, or just drop the
+      // tombstones if they are what fills it.
+      auto capacity = std::max(slots_.size(), kMinCapacity);
+      while ((size_ + 1) * 2 > capacity) {
+        capacity *= 2;
+      }
+      rehash(capacity);
+    }
+
+    insertUnique(streamId, std::move(value));
+    return true;
+  }
+
+  /// Erases the stream.  Returns false if it was not present.
+  bool erase(StreamId streamId) {
+    auto index = findIndex(streamId);
+    if (index == kNotFound) {
+      return false;
+    }
+
+    slots_[index].value = T();
+    --size_;
+
+    if (slots_[(index + 1) & mask()].streamId != kEmpty) {
+      // Some probe sequence may run through this slot.
+      slots_[index].streamId = kTombstone;
+      ++tombstones_;
+      return true;
+    }
+
+    // No probe sequence runs past this slot, so it and the tombstones right
+    // before it can be emptied.
+    slots_[index].streamId = kEmpty;
+    index = (index - 1) & mask();
+    while (slots_[index].streamId == kTombstone) {
+      slots_[index].streamId = kEmpty;
+      --tombstones_;
+      index = (index - 1) & mask();
+    }
+    return true;
+  }
+
+  /// Moves all values out of the map, leaving it empty.
+  std::vector<T> takeAll() {
+    std::vector<T> values;
+    values.reserve(size_);
+    for (auto& slot : slots_) {
+      if (slot.streamId != kEmpty && slot.streamId != kTombstone) {
+        values.push_back(std::move(slot.value));
+      }
+    }
+    slots_.clear();
+    size_ = 0;
+    tombstones_ = 0;
+    maxProbe_ = 0;
+    return values;
+  }
+
+ private:
+  static constexpr StreamId kEmpty = 0;
+  static constexpr StreamId kTombstone = std::numeric_limits<StreamId>::max();
+  static constexpr size_t kNotFound = std::numeric_limits<size_t>::max();
+  static constexpr size_t kMinCapacity = 16;
+
+  struct Slot {
+    StreamId streamId{kEmpty};
+    T value;
+  };
+
+  size_t mask() const {
+    return slots_.size() - 1;
+  }
+
+  size_t homeIndex(StreamId streamId) const {
+    return (streamId >> 1) & mask();
+  }
+
+  size_t findIndex(StreamId streamId) const {
+    if (slots_.empty()) {
+      return kNotFound;
+    }
+    auto index = homeIndex(streamId);
+    for (size_t probe = 0; probe <= maxProbe_; ++probe) {
+      auto const id = slots_[index].streamId;
+      if (id == streamId) {
+        return index;
+      }
+      if (id == kEmpty) {
+        break;
+      }
+      index = (index + 1) & mask();
+    }
+    return kNotFound;
+  }
+
+  void insertUnique(StreamId streamId, T value) {
+    auto index = homeIndex(streamId);
+    size_t probe = 0;
+    while (slots_[index].streamId != kEmpty &&
+           slots_[index].streamId != kTombstone) {
+      index = (index + 1) & mask();
+      ++probe;
+    }
+    if (slots_[index].streamId == kTombstone) {
+      --tombstones_;
+    }
+    slots_[index].streamId = streamId;
+    slots_[index].value = std::move(value);
+    maxProbe_ = std::max(maxProbe_, probe);
+    ++size_;
+  }
+
+  void rehash(size_t capacity) {
+    auto old = std::move(slots_);
+    slots_ = std::vector<Slot>(capacity);
+    size_ = 0;
+    tombstones_ = 0;
+    maxProbe_ = 0;
+    for (auto& slot : old) {
+      if (slot.streamId != kEmpty && slot.streamId != kTombstone) {
+        insertUnique(slot.streamId, std::move(slot.value));
+      }
+    }
+  }
+
+  /// Capacity is always zero or a power of two.
+  std::vector<Slot> slots_;
+  size_t size_{0};
+  size_t tombstones_{0};
+  size_t maxProbe_{0};
+};
+
+template <typename T>
+constexpr StreamId StreamMap<T>::kEmpty;
+template <typename T>
+constexpr StreamId StreamMap<T>::kTombstone;
+template <typename T>
+constexpr size_t StreamMap<T>::kNotFound;
+template <typename T>
+constexpr size_t StreamMap<T>::kMinCapacity;
+
+} // namespace rsocket
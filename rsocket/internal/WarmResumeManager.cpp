@@ -14,7 +14,10 @@
 
 #include "rsocket/internal/WarmResumeManager.h"
 
+#include <folly/io/IOBuf.h>
+
 #include <algorithm>
+#include <cstring>
 
 namespace rsocket {
 
@@ -73,37 +76,36 @@ void WarmResumeManager::resetUpToPosition(ResumePosition position) {
   clearFrames(position);
 
   firstSentPosition_ = position;
-  DCHECK(frames_.empty() || frames_.front().first == firstSentPosition_);
+  DCHECK(frames_.empty() || frames_.front() == firstSentPosition_);
 }
 
 bool WarmResumeManager::isPositionAvailable(ResumePosition position) const {
   return (lastSentPosition_ == position) ||
-      std::binary_search(
-             frames_.begin(),
-             frames_.end(),
-             std::make_pair(position, std::unique_ptr<folly::IOBuf>()),
-             [](decltype(frames_.back()) pairA,
-                decltype(frames_.back()) pairB) {
-               return pairA.first < pairB.first;
-             });
+      std::binary_search(frames_.begin(), frames_.end(), position);
 }
 
 void WarmResumeManager::addFrame(
     const folly::IOBuf& frame,
     size_t frameDataLength) {
-  size_ += frameDataLength;
-  while (size_ > capacity_) {
+  while (size_ + frameDataLength > capacity_) {
     evictFrame();
   }
-  frames_.emplace_back(lastSentPosition_, frame.clone());
+  reserveRing(size_ + frameDataLength);
+
+  auto position = lastSentPosition_;
+  for (const auto range : frame) {
+    copyToRing(position, range.data(), range.size());
+    position += range.size();
+  }
+  frames_.push_back(lastSentPosition_);
+  size_ += frameDataLength;
   stats_->resumeBufferChanged(1, static_cast<int>(frameDataLength));
 }
 
 void WarmResumeManager::evictFrame() {
   DCHECK(!frames_.empty());
 
-  const auto position = frames_.size() > 1 ? std::next(frames_.begin())->first
-                                           : lastSentPosition_;
+  const auto position = frames_.size() > 1 ? frames_[1] : lastSentPosition_;
   resetUpToPosition(position);
 }
 
@@ -114,15 +116,9 @@ void WarmResumeManager::clearFrames(ResumePosition position) {
   DCHECK(position <= lastSentPosition_);
   DCHECK(position >= firstSentPosition_);
 
-  const auto end = std::lower_bound(
-      frames_.begin(),
-      frames_.end(),
-      position,
-      [](decltype(frames_.back()) pair, ResumePosition pos) {
-        return pair.first < pos;
-      });
-  DCHECK(end == frames_.end() || end->first >= firstSentPosition_);
-  const auto pos = end == frames_.end() ? position : end->first;
+  const auto end = std::lower_bound(frames_.begin(), frames_.end(), position);
+  DCHECK(end == frames_.end() || *end >= firstSentPosition_);
+  const auto pos = end == frames_.end() ? position : *end;
   stats_->resumeBufferChanged(
       -static_cast<int>(std::distance(frames_.begin(), end)),
       -static_cast<int>(pos - firstSentPosition_));
@@ -131,6 +127,35 @@ void WarmResumeManager::clearFrames(ResumePosition position) {
   size_ -= static_cast<decltype(size_)>(pos - firstSentPosition_);
 }
 
+std::vector<std::pair<ResumePosition, std::unique_ptr<folly::IOBuf>>>
+WarmResumeManager::copyFrames(ResumePosition position) const {
+  std::vector<std::pair<ResumePosition, std::unique_ptr<folly::IOBuf>>>
+      frames;
+  auto found = std::lower_bound(frames_.begin(), frames_.end(), position);
+  if (found == frames_.end()) {
+    return frames;
+  }
+  position = *found;
+
+  // One copy out of the ring, which later frames will overwrite, into a
+  // buffer that the copied frames share.
+  const auto length = static_cast<size_t>(lastSentPosition_ - position);
+  auto buffer = folly::IOBuf::create(length);
+  copyFromRing(position, length, buffer->writableData());
+  buffer->append(length);
+
+  frames.reserve(std::distance(found, frames_.end()));
+  for (; found != frames_.end(); ++found) {
+    const auto next = std::next(found);
+    const auto frameEnd = next == frames_.end() ? lastSentPosition_ : *next;
+    auto frame = buffer->cloneOne();
+    frame->trimStart(static_cast<size_t>(*found - position));
+    frame->trimEnd(static_cast<size_t>(lastSentPosition_ - frameEnd));
+    frames.emplace_back(*found, std::move(frame));
+  }
+  return frames;
+}
+
 void WarmResumeManager::sendFramesFromPosition(
     ResumePosition position,
     FrameTransport& frameTransport) const {
@@ -141,21 +166,62 @@ void WarmResumeManager::sendFramesFromPosition(
     return;
   }
 
-  auto found = std::lower_bound(
-      frames_.begin(),
-      frames_.end(),
-      position,
-      [](decltype(frames_.back()) pair, ResumePosition pos) {
-        return pair.first < pos;
-      });
+  auto frames = copyFrames(position);
+  DCHECK(!frames.empty());
+  DCHECK(frames.front().first == position);
+
+  for (auto& frame : frames) {
+    frameTransport.outputFrameOrDrop(std::move(frame.second));
+  }
+}
+
+void WarmResumeManager::reserveRing(size_t bytes) {
+  if (bytes <= ringSize_) {
+    return;
+  }
+  DCHECK_LE(bytes, capacity_);
+
+  auto newSize = ringSize_ > 0 ? ringSize_ : size_t{MIN_RING_SIZE};
+  while (newSize < bytes) {
+    newSize *= 2;
+  }
+  newSize = std::min(newSize, capacity_);
+
+  // The offsets of the cached bytes depend on the ring size, so they are
+  // copied out and back in.
+  std::unique_ptr<uint8_t[]> cached(new uint8_t[size_]);
+  copyFromRing(firstSentPosition_, size_, cached.get());
+  ring_.reset(new uint8_t[newSize]);
+  ringSize_ = newSize;
+  copyToRing(firstSentPosition_, cached.get(), size_);
+}
 
-  DCHECK(found != frames_.end());
-  DCHECK(found->first == position);
+void WarmResumeManager::copyToRing(
+    ResumePosition position,
+    const uint8_t* data,
+    size_t length) {
+  DCHECK_LE(length, ringSize_);
+  if (length == 0) {
+    return;
+  }
+  const auto offset = static_cast<size_t>(position) % ringSize_;
+  const auto head = std::min(length, ringSize_ - offset);
+  std::memcpy(ring_.get() + offset, data, head);
+  std::memcpy(ring_.get(), data + head, length - head);
+}
 
-  while (found != frames_.end()) {
-    frameTransport.outputFrameOrDrop(found->second->clone());
-    found++;
+void WarmResumeManager::copyFromRing(
+    ResumePosition position,
+    size_t length,
+    uint8_t* out) const {
+  DCHECK_LE(length, ringSize_);
+  if (length == 0) {
+    return;
   }
+  const auto offset = static_cast<size_t>(position) % ringSize_;
+  const auto head = std::min(length, ringSize_ - offset);
+  std::memcpy(out, ring_.get() + offset, head);
+  std::memcpy(out + head, ring_.get(), length - head);
 }
 
 std::shared_ptr<ResumeManager> ResumeManager::makeEmpty() {
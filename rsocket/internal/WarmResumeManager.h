@@ -15,6 +15,10 @@
 #pragma once
 
 #include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "rsocket/RSocketStats.h"
 #include "rsocket/ResumeManager.h"
 
@@ -27,6 +31,14 @@ namespace rsocket {
 class RSocketStateMachine;
 class FrameTransport;
 
+/// Keeps the frames sent on a connection, up to `capacity` bytes, so they can
+/// be sent again when the connection resumes.
+///
+/// The frames are copied into a ring of bytes indexed by resume position: the
+/// byte at position P lives at offset P % ring size.  The ring grows by
+/// doubling up to the capacity, so tracking a frame allocates nothing once it
+/// has reached its working size.  The start position of every frame is kept in
+/// order, so a resume position is found by binary search.
 class WarmResumeManager : public ResumeManager {
  public:
   explicit WarmResumeManager(
@@ -93,6 +105,11 @@ class WarmResumeManager : public ResumeManager {
   // Called before clearing cached frames to update stats.
   void clearFrames(ResumePosition position);
 
+  /// Copies out the cached frames from `position` on, with their positions.
+  /// The frames share a single buffer.
+  std::vector<std::pair<ResumePosition, std::unique_ptr<folly::IOBuf>>>
+  copyFrames(ResumePosition position) const;
+
   const std::shared_ptr<RSocketStats> stats_;
 
   // Start position of the send buffer queue
@@ -102,10 +119,23 @@ class WarmResumeManager : public ResumeManager {
   // Inferred position of the rcvd frames
   ResumePosition impliedPosition_{0};
 
-  std::deque<std::pair<ResumePosition, std::unique_ptr<folly::IOBuf>>> frames_;
+  // Start positions of the cached frames
+  std::deque<ResumePosition> frames_;
 
   constexpr static size_t DEFAULT_CAPACITY = 1024 * 1024; // 1MB
+  constexpr static size_t MIN_RING_SIZE = 4 * 1024;
   const size_t capacity_;
   size_t size_{0};
+
+ private:
+  void reserveRing(size_t bytes);
+  void copyToRing(ResumePosition position, const uint8_t* data, size_t length);
+  void copyFromRing(ResumePosition position, size_t length, uint8_t* out)
+      const;
+
+  // The bytes of the cached frames, from firstSentPosition_ to
+  // lastSentPosition_
+  std::unique_ptr<uint8_t[]> ring_;
+  size_t ringSize_{0};
 };
 } // namespace rsocket
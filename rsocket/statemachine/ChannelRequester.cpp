@@ -94,6 +94,7 @@ void ChannelRequester::handlePayload(
     bool flagsNext,
     bool flagsFollows) {
   CHECK(requested_);
+  recordResponseLatency(StreamType::CHANNEL);
   bool finalComplete = processFragmentedPayload(
       std::move(payload), flagsNext, flagsComplete, flagsFollows);
 
@@ -128,7 +129,8 @@ void ChannelRequester::endStream(StreamCompletionSignal signal) {
 void ChannelRequester::initStream(Payload&& request) {
   requested_ = true;
 
-  const size_t initialN = initialResponseAllowance_.consumeUpTo(kMaxRequestN);
+  const size_t initialN =
+      initialResponseAllowance_.consumeUpTo(maxInitialRequestN());
   const size_t remainingN = initialResponseAllowance_.consumeAll();
 
   // Send as much as possible with the initial request.
@@ -152,4 +154,12 @@ void ChannelRequester::tryCompleteChannel() {
   }
 }
 
+void ChannelRequester::handleWritable() {
+  resumePublisher();
+}
+
+bool ChannelRequester::shouldHoldRequests() {
+  return deferUntilWritable();
+}
+
 } // namespace rsocket
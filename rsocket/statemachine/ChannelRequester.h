@@ -55,10 +55,13 @@ class ChannelRequester : public ConsumerBase,
   void handleRequestN(uint32_t) override;
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
+  void handleWritable() override;
 
   void endStream(StreamCompletionSignal) override;
 
  private:
+  bool shouldHoldRequests() override;
+
   void initStream(Payload&&);
   void tryCompleteChannel();
 
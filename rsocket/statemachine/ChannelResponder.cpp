@@ -63,7 +63,11 @@ void ChannelResponder::handlePayload(
     bool flagsComplete,
     bool flagsNext,
     bool flagsFollows) {
-  payloadFragments_.addPayload(std::move(payload), flagsNext, flagsComplete);
+  if (!payloadFragments_.addPayload(
+          std::move(payload), flagsNext, flagsComplete, flagsFollows)) {
+    handleReassemblyLimitError(!newStream_);
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -119,4 +123,12 @@ void ChannelResponder::tryCompleteChannel() {
   }
 }
 
+void ChannelResponder::handleWritable() {
+  resumePublisher();
+}
+
+bool ChannelResponder::shouldHoldRequests() {
+  return deferUntilWritable();
+}
+
 } // namespace rsocket
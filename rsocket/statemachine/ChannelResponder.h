@@ -49,10 +49,13 @@ class ChannelResponder : public ConsumerBase,
   void handleRequestN(uint32_t) override;
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
+  void handleWritable() override;
 
   void endStream(StreamCompletionSignal) override;
 
  private:
+  bool shouldHoldRequests() override;
+
   void tryCompleteChannel();
 
   bool newStream_{true};
@@ -18,6 +18,8 @@
 
 #include <glog/logging.h>
 
+#include "rsocket/statemachine/StreamsWriter.h"
+
 namespace rsocket {
 
 void ConsumerBase::subscribe(
@@ -65,6 +67,12 @@ void ConsumerBase::endStream(StreamCompletionSignal signal) {
   }
 }
 
+uint32_t ConsumerBase::maxInitialRequestN() const {
+  auto const window = writer_->requestNPolicy().window;
+  auto const max = static_cast<uint32_t>(kMaxRequestN);
+  return window ? std::min(window, max) : max;
+}
+
 size_t ConsumerBase::getConsumerAllowance() const {
   return allowance_.get();
 }
@@ -95,7 +103,11 @@ bool ConsumerBase::processFragmentedPayload(
     bool flagsNext,
     bool flagsComplete,
     bool flagsFollows) {
-  payloadFragments_.addPayload(std::move(payload), flagsNext, flagsComplete);
+  if (!payloadFragments_.addPayload(
+          std::move(payload), flagsNext, flagsComplete, flagsFollows)) {
+    handleReassemblyLimitError(true);
+    return false;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -128,6 +140,24 @@ void ConsumerBase::errorConsumer(folly::exception_wrapper ew) {
 }
 
 void ConsumerBase::sendRequests() {
+  auto const& policy = writer_->requestNPolicy();
+  if (policy.window) {
+    // Grant nothing while the peer still holds more than the replenish share
+    // of the window, then top it back up to the full window.
+    auto const window = std::min<uint32_t>(policy.window, kMaxRequestN);
+    auto const actives = activeRequests_.get();
+    if (actives >= window ||
+        actives > uint64_t{window} * policy.replenishPercent / 100) {
+      return;
+    }
+    auto const toSync = pendingAllowance_.consumeUpTo(window - actives);
+    if (toSync > 0) {
+      writeRequestN(static_cast<uint32_t>(toSync));
+      activeRequests_.add(toSync);
+    }
+    return;
+  }
+
   auto toSync = std::min<size_t>(pendingAllowance_.get(), kMaxRequestN);
   auto actives = activeRequests_.get();
   if (actives < (toSync + 1) / 2) {
@@ -47,9 +47,13 @@ class ConsumerBase : public StreamStateMachineBase,
   void endStream(StreamCompletionSignal) override;
 
  protected:
+  /// The most credits the request that opens the stream may carry.
+  uint32_t maxInitialRequestN() const;
+
   void processPayload(Payload&&, bool onNext);
 
-  // returns true if the stream is completed
+  // returns true if the stream is completed.  Fails the stream, and returns
+  // false, if the fragments exceed the reassembly limits.
   bool
   processFragmentedPayload(Payload&&, bool next, bool complete, bool follows);
 
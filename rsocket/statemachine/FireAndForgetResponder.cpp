@@ -24,7 +24,12 @@ void FireAndForgetResponder::handlePayload(
     bool /*flagsComplete*/,
     bool /*flagsNext*/,
     bool flagsFollows) {
-  payloadFragments_.addPayloadIgnoreFlags(std::move(payload));
+  if (!payloadFragments_.addPayloadIgnoreFlags(
+          std::move(payload), flagsFollows)) {
+    // there is no one to report the error to
+    removeFromWriter();
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
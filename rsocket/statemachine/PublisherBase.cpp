@@ -29,7 +29,7 @@ void PublisherBase::publisherSubscribe(
   }
   DCHECK(!producingSubscription_);
   producingSubscription_ = std::move(subscription);
-  if (initialRequestN_) {
+  if (initialRequestN_ && !shouldHoldRequests()) {
     producingSubscription_->request(initialRequestN_.consumeAll());
   }
 }
@@ -50,13 +50,21 @@ void PublisherBase::processRequestN(uint32_t requestN) {
 
   // We might not have the subscription set yet as there can be REQUEST_N frames
   // scheduled on the executor before onSubscribe method.
-  if (producingSubscription_) {
+  if (producingSubscription_ && !shouldHoldRequests()) {
     producingSubscription_->request(requestN);
   } else {
     initialRequestN_.add(requestN);
   }
 }
 
+void PublisherBase::resumePublisher() {
+  if (state_ == State::CLOSED || !producingSubscription_ || !initialRequestN_ ||
+      shouldHoldRequests()) {
+    return;
+  }
+  producingSubscription_->request(initialRequestN_.consumeAll());
+}
+
 void PublisherBase::terminatePublisher() {
   state_ = State::CLOSED;
   if (auto subscription = std::move(producingSubscription_)) {
@@ -32,6 +32,16 @@ class PublisherBase {
   bool publisherClosed() const;
   void terminatePublisher();
 
+ protected:
+  /// Whether requests should be held back for now rather than passed on to
+  /// the producer.  Held requests are passed on by resumePublisher().
+  virtual bool shouldHoldRequests() {
+    return false;
+  }
+
+  /// Pass on the requests held back so far, unless they should still be held.
+  void resumePublisher();
+
  private:
   enum class State : uint8_t {
     RESPONDING,
@@ -18,10 +18,14 @@
 #include <folly/Format.h>
 #include <folly/Optional.h>
 #include <folly/String.h>
+#include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventBaseManager.h>
 
+#include <algorithm>
+
 #include "rsocket/DuplexConnection.h"
 #include "rsocket/RSocketConnectionEvents.h"
+#include "rsocket/RSocketErrors.h"
 #include "rsocket/RSocketParameters.h"
 #include "rsocket/RSocketResponder.h"
 #include "rsocket/RSocketStats.h"
@@ -29,6 +33,8 @@
 #include "rsocket/framing/FrameSerializer.h"
 #include "rsocket/framing/FrameTransportImpl.h"
 #include "rsocket/internal/ClientResumeStatusCallback.h"
+#include "rsocket/internal/FreeListAllocator.h"
+#include "rsocket/internal/ReassemblyBudget.h"
 #include "rsocket/internal/ScheduledSubscriber.h"
 #include "rsocket/internal/WarmResumeManager.h"
 #include "rsocket/statemachine/ChannelRequester.h"
@@ -61,6 +67,20 @@ void disconnectError(
   observer->onError(std::move(exn));
 }
 
+constexpr auto kNoLease = "No lease available for a new request";
+
+void noLeaseError(
+    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
+  subscriber->onSubscribe(yarpl::flowable::Subscription::create());
+  subscriber->onError(RejectedError{kNoLease});
+}
+
+void noLeaseError(
+    std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer) {
+  observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+  observer->onError(RejectedError{kNoLease});
+}
+
 } // namespace
 
 RSocketStateMachine::RSocketStateMachine(
@@ -125,6 +145,68 @@ RSocketStateMachine::~RSocketStateMachine() {
   // close method
 }
 
+void RSocketStateMachine::setLeaseSender(
+    std::shared_ptr<LeaseSender> leaseSender,
+    folly::EventBase& eventBase) {
+  setLeaseSender(
+      std::move(leaseSender),
+      [&eventBase](
+          folly::Function<void()> callback, std::chrono::milliseconds delay) {
+        eventBase.runAfterDelay(
+            std::move(callback), static_cast<uint32_t>(delay.count()));
+      });
+}
+
+void RSocketStateMachine::setLeaseSender(
+    std::shared_ptr<LeaseSender> leaseSender,
+    LeaseTimer timer) {
+  DCHECK(isDisconnected());
+  leaseSender_ = std::move(leaseSender);
+  leaseTimer_ = std::move(timer);
+}
+
+void RSocketStateMachine::setRequestNPolicy(
+    RequestNPolicy policy,
+    folly::EventBase& eventBase) {
+  DCHECK(isDisconnected());
+  requestNPolicy_ = policy;
+  requestNEventBase_ = &eventBase;
+}
+
+void RSocketStateMachine::setReassemblyLimits(ReassemblyLimits limits) {
+  DCHECK(isDisconnected());
+  if (limits.maxStreamBytes == 0 && limits.maxConnectionBytes == 0) {
+    reassemblyBudget_ = nullptr;
+    return;
+  }
+  reassemblyBudget_ = std::make_shared<ReassemblyBudget>(limits);
+}
+
+void RSocketStateMachine::setFrameSchedulingPolicy(
+    FrameSchedulingPolicy policy) {
+  DCHECK(isDisconnected());
+  frameScheduling_ = std::move(policy);
+  scheduler().setQuantum(frameScheduling_.quantum);
+}
+
+void RSocketStateMachine::setThreadAffinity(folly::EventBase& eventBase) {
+  threadAffinity_ = &eventBase;
+}
+
+void RSocketStateMachine::checkThreadAffinity() const {
+  DCHECK(!threadAffinity_ || threadAffinity_->isInEventBaseThread())
+      << "Signal crossed threads on a connection tied to "
+      << threadAffinity_->getName();
+}
+
+void RSocketStateMachine::classifyStream(
+    StreamId streamId,
+    const Payload& payload) {
+  if (frameScheduling_.enabled && frameScheduling_.classify) {
+    scheduler().setPriority(streamId, frameScheduling_.classify(payload));
+  }
+}
+
 void RSocketStateMachine::setResumable(bool resumable) {
   // We should set this flag before we are connected
   DCHECK(isDisconnected());
@@ -135,9 +217,13 @@ void RSocketStateMachine::connectServer(
     std::shared_ptr<FrameTransport> frameTransport,
     const SetupParameters& setupParams) {
   setResumable(setupParams.resumable);
+  leaseEnabled_ = setupParams.lease && leaseSender_;
   setProtocolVersionOrThrow(setupParams.protocolVersion, frameTransport);
   connect(std::move(frameTransport));
   sendPendingFrames();
+  if (leaseEnabled_) {
+    sendLease();
+  }
 }
 
 bool RSocketStateMachine::resumeServer(
@@ -164,6 +250,10 @@ bool RSocketStateMachine::resumeServer(
 
   const auto result = resumeFromPositionOrClose(
       resumeParams.serverPosition, resumeParams.clientPosition);
+  if (result && leaseEnabled_) {
+    // The client may have missed the last lease while disconnected.
+    sendLease();
+  }
 
   stats_->serverResume(
       clientAvailable,
@@ -184,9 +274,12 @@ void RSocketStateMachine::connectClient(
 
   setProtocolVersionOrThrow(version, transport);
   setResumable(params.resumable);
+  leaseEnabled_ = params.lease;
+  leaseReceiver_ = std::move(params.leaseReceiver);
 
   Frame_SETUP frame(
       (params.resumable ? FrameFlags::RESUME_ENABLE : FrameFlags::EMPTY) |
+          (params.lease ? FrameFlags::LEASE : FrameFlags::EMPTY) |
           (params.payload.metadata ? FrameFlags::METADATA : FrameFlags::EMPTY),
       version.major,
       version.minor,
@@ -250,6 +343,11 @@ void RSocketStateMachine::connect(std::shared_ptr<FrameTransport> transport) {
   // that call which will nullify frameTransport_.
   frameTransport_ = transport;
 
+  // A new transport starts out taking writes.
+  if (writeBlocked_) {
+    onWritabilityChanged(true);
+  }
+
   CHECK(frameSerializer_);
   frameSerializer_->preallocateFrameSizeField() =
       transport->isConnectionFramed();
@@ -417,12 +515,16 @@ void RSocketStateMachine::requestStream(
     disconnectError(std::move(responseSink));
     return;
   }
+  if (!tryAcquireLease(true)) {
+    noLeaseError(std::move(responseSink));
+    return;
+  }
 
   auto const streamId = getNextStreamId();
-  auto stateMachine = std::make_shared<StreamRequester>(
+  auto stateMachine = makeFreeListShared<StreamRequester>(
       shared_from_this(), streamId, std::move(request));
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second);
+  const auto inserted = insertStream(streamId, stateMachine);
+  DCHECK(inserted);
   stateMachine->subscribe(std::move(responseSink));
 }
 
@@ -435,18 +537,22 @@ RSocketStateMachine::requestChannel(
     disconnectError(std::move(responseSink));
     return nullptr;
   }
+  if (!tryAcquireLease(true)) {
+    noLeaseError(std::move(responseSink));
+    return nullptr;
+  }
 
   auto const streamId = getNextStreamId();
   std::shared_ptr<ChannelRequester> stateMachine;
   if (hasInitialRequest) {
-    stateMachine = std::make_shared<ChannelRequester>(
+    stateMachine = makeFreeListShared<ChannelRequester>(
         std::move(request), shared_from_this(), streamId);
   } else {
     stateMachine =
-        std::make_shared<ChannelRequester>(shared_from_this(), streamId);
+        makeFreeListShared<ChannelRequester>(shared_from_this(), streamId);
   }
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second);
+  const auto inserted = insertStream(streamId, stateMachine);
+  DCHECK(inserted);
   stateMachine->subscribe(std::move(responseSink));
   return stateMachine;
 }
@@ -458,25 +564,32 @@ void RSocketStateMachine::requestResponse(
     disconnectError(std::move(responseSink));
     return;
   }
+  if (!tryAcquireLease(true)) {
+    noLeaseError(std::move(responseSink));
+    return;
+  }
 
   auto const streamId = getNextStreamId();
-  auto stateMachine = std::make_shared<RequestResponseRequester>(
+  auto stateMachine = makeFreeListShared<RequestResponseRequester>(
       shared_from_this(), streamId, std::move(request));
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second);
+  const auto inserted = insertStream(streamId, stateMachine);
+  DCHECK(inserted);
   stateMachine->subscribe(std::move(responseSink));
 }
 
 void RSocketStateMachine::closeStreams(StreamCompletionSignal signal) {
+  // Ending a stream can open new ones.
   while (!streams_.empty()) {
-    auto it = streams_.begin();
-    auto streamStateMachine = std::move(it->second);
-    streams_.erase(it);
-    streamStateMachine->endStream(signal);
+    for (auto& streamStateMachine : streams_.takeAll()) {
+      streamStateMachine->endStream(signal);
+    }
   }
+  activeStreams_.store(0, std::memory_order_relaxed);
 }
 
 void RSocketStateMachine::processFrame(std::unique_ptr<folly::IOBuf> frame) {
+  checkThreadAffinity();
+
   if (isClosed()) {
     VLOG(4) << "StateMachine has been closed.  Discarding incoming frame";
     return;
@@ -488,19 +601,25 @@ void RSocketStateMachine::processFrame(std::unique_ptr<folly::IOBuf> frame) {
     return;
   }
 
-  const auto frameType = frameSerializer_->peekFrameType(*frame);
+  const auto header = frameSerializer_->peekHeader(*frame);
+  const auto frameType = header.type();
   stats_->frameRead(frameType);
 
-  const auto optStreamId = frameSerializer_->peekStreamId(*frame, false);
-  if (!optStreamId) {
-    constexpr auto msg = "Cannot decode stream ID";
+  if (!header.valid()) {
+    constexpr auto msg = "Cannot decode frame header";
     closeWithError(Frame_ERROR::connectionError(msg));
     return;
   }
 
-  const auto frameLength = frame->computeChainDataLength();
-  const auto streamId = *optStreamId;
-  handleFrame(streamId, frameType, std::move(frame));
+  const auto frameLength = header.frameLength();
+  const auto streamId = header.streamId();
+  if (stats_->latenciesEnabled()) {
+    const auto start = std::chrono::steady_clock::now();
+    handleFrame(header, std::move(frame));
+    stats_->frameProcessed(frameType, std::chrono::steady_clock::now() - start);
+  } else {
+    handleFrame(header, std::move(frame));
+  }
   resumeManager_->trackReceivedFrame(
       frameLength, frameType, streamId, getConsumerAllowance(streamId));
 }
@@ -515,6 +634,34 @@ void RSocketStateMachine::onTerminal(folly::exception_wrapper ex) {
   close(std::move(ex), termSignal);
 }
 
+void RSocketStateMachine::onWritabilityChanged(bool writable) {
+  VLOG(3) << "Transport " << (writable ? "takes" : "stopped taking")
+          << " writes";
+  writeBlocked_ = !writable;
+  if (!writable) {
+    return;
+  }
+
+  // Frames already waiting go out before publishers are asked for more.
+  flushScheduledFrames();
+
+  // Streams that block the transport again re-register themselves.
+  for (auto streamId : writeBlockedStreams_.takeAll()) {
+    if (auto const found = streams_.find(streamId)) {
+      auto const stateMachine = *found;
+      stateMachine->handleWritable();
+    }
+  }
+}
+
+bool RSocketStateMachine::deferUntilWritable(StreamId streamId) {
+  if (!writeBlocked_) {
+    return false;
+  }
+  writeBlockedStreams_.insert(streamId, streamId);
+  return true;
+}
+
 void RSocketStateMachine::onKeepAliveFrame(
     ResumePosition resumePosition,
     std::unique_ptr<folly::IOBuf> data,
@@ -567,12 +714,12 @@ void RSocketStateMachine::onResumeOkFrame(ResumePosition resumePosition) {
         auto subscriber = coldResumeHandler_->handleRequesterResumeStream(
             streamResumeInfo.streamToken, streamResumeInfo.consumerAllowance);
 
-        auto stateMachine = std::make_shared<StreamRequester>(
+        auto stateMachine = makeFreeListShared<StreamRequester>(
             shared_from_this(), streamId, Payload());
         // Set requested to true (since cold resumption)
         stateMachine->setRequested(streamResumeInfo.consumerAllowance);
-        const auto result = streams_.emplace(streamId, stateMachine);
-        DCHECK(result.second);
+        const auto inserted = insertStream(streamId, stateMachine);
+        DCHECK(inserted);
         stateMachine->subscribe(
             std::make_shared<ScheduledSubscriptionSubscriber<Payload>>(
                 std::move(subscriber),
@@ -637,8 +784,20 @@ void RSocketStateMachine::onReservedFrame() {
   onUnexpectedFrame(0);
 }
 
-void RSocketStateMachine::onLeaseFrame() {
-  onUnexpectedFrame(0);
+void RSocketStateMachine::onLeaseFrame(
+    uint32_t ttl,
+    uint32_t numberOfRequests) {
+  // Only the server grants leases, and only if the client asked for them.
+  if (!leaseEnabled_ || mode_ != RSocketMode::CLIENT) {
+    onUnexpectedFrame(0);
+    return;
+  }
+  const Lease lease{std::chrono::milliseconds{ttl}, numberOfRequests};
+  leaseBudget_.reset(lease, LeaseBudget::Clock::now());
+  stats_->leaseReceived(numberOfRequests);
+  if (leaseReceiver_) {
+    leaseReceiver_->onLease(lease);
+  }
 }
 
 void RSocketStateMachine::onExtFrame() {
@@ -651,10 +810,10 @@ void RSocketStateMachine::onUnexpectedFrame(StreamId streamId) {
 }
 
 void RSocketStateMachine::handleFrame(
-    StreamId streamId,
-    FrameType frameType,
+    const FrameHeaderView& header,
     std::unique_ptr<folly::IOBuf> payload) {
-  switch (frameType) {
+  const auto streamId = header.streamId();
+  switch (header.type()) {
     case FrameType::KEEPALIVE: {
       Frame_KEEPALIVE frame;
       if (!deserializeFrameOrError(frame, std::move(payload))) {
@@ -703,9 +862,15 @@ void RSocketStateMachine::handleFrame(
     case FrameType::RESERVED:
       onReservedFrame();
       return;
-    case FrameType::LEASE:
-      onLeaseFrame();
+    case FrameType::LEASE: {
+      Frame_LEASE frame;
+      if (!deserializeFrameOrError(frame, std::move(payload))) {
+        return;
+      }
+      VLOG(3) << mode_ << " In: " << frame;
+      onLeaseFrame(frame.ttl_, frame.numberOfRequests_);
       return;
+    }
     case FrameType::REQUEST_N: {
       Frame_REQUEST_N frameRequestN;
       if (!deserializeFrameOrError(frameRequestN, std::move(payload))) {
@@ -796,14 +961,14 @@ void RSocketStateMachine::handleFrame(
 
 std::shared_ptr<StreamStateMachineBase>
 RSocketStateMachine::getStreamStateMachine(StreamId streamId) {
-  const auto&& it = streams_.find(streamId);
-  if (it == streams_.end()) {
+  const auto stateMachine = streams_.find(streamId);
+  if (!stateMachine) {
     return nullptr;
   }
   // we are purposely making a copy of the reference here to avoid problems with
   // lifetime of the stateMachine when a terminating signal is delivered which
   // will cause the stateMachine to be destroyed while in one of its methods
-  return it->second;
+  return *stateMachine;
 }
 
 bool RSocketStateMachine::ensureNotInResumption() {
@@ -866,10 +1031,16 @@ void RSocketStateMachine::onRequestStreamFrame(
   if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
     return;
   }
-  auto stateMachine =
-      std::make_shared<StreamResponder>(shared_from_this(), streamId, requestN);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+  if (!tryAcquireLease(false)) {
+    outputFrameOrEnqueue(frameSerializer_->serializeOut(
+        Frame_ERROR::rejected(streamId, kNoLease)));
+    return;
+  }
+  classifyStream(streamId, payload);
+  auto stateMachine = makeFreeListShared<StreamResponder>(
+      shared_from_this(), streamId, requestN);
+  const auto inserted = insertStream(streamId, stateMachine);
+  DCHECK(inserted); // ensured by calling isNewStreamId
   stateMachine->handlePayload(std::move(payload), false, false, flagsFollows);
 }
 
@@ -883,10 +1054,16 @@ void RSocketStateMachine::onRequestChannelFrame(
   if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
     return;
   }
-  auto stateMachine = std::make_shared<ChannelResponder>(
+  if (!tryAcquireLease(false)) {
+    outputFrameOrEnqueue(frameSerializer_->serializeOut(
+        Frame_ERROR::rejected(streamId, kNoLease)));
+    return;
+  }
+  classifyStream(streamId, payload);
+  auto stateMachine = makeFreeListShared<ChannelResponder>(
       shared_from_this(), streamId, requestN);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+  const auto inserted = insertStream(streamId, stateMachine);
+  DCHECK(inserted); // ensured by calling isNewStreamId
   stateMachine->handlePayload(
       std::move(payload), flagsComplete, flagsNext, flagsFollows);
 }
@@ -898,10 +1075,16 @@ void RSocketStateMachine::onRequestResponseFrame(
   if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
     return;
   }
-  auto stateMachine =
-      std::make_shared<RequestResponseResponder>(shared_from_this(), streamId);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+  if (!tryAcquireLease(false)) {
+    outputFrameOrEnqueue(frameSerializer_->serializeOut(
+        Frame_ERROR::rejected(streamId, kNoLease)));
+    return;
+  }
+  classifyStream(streamId, payload);
+  auto stateMachine = makeFreeListShared<RequestResponseResponder>(
+      shared_from_this(), streamId);
+  const auto inserted = insertStream(streamId, stateMachine);
+  DCHECK(inserted); // ensured by calling isNewStreamId
   stateMachine->handlePayload(std::move(payload), false, false, flagsFollows);
 }
 
@@ -912,13 +1095,61 @@ void RSocketStateMachine::onFireAndForgetFrame(
   if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
     return;
   }
+  if (!tryAcquireLease(false)) {
+    return;
+  }
   auto stateMachine =
-      std::make_shared<FireAndForgetResponder>(shared_from_this(), streamId);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+      makeFreeListShared<FireAndForgetResponder>(shared_from_this(), streamId);
+  const auto inserted = insertStream(streamId, stateMachine);
+  DCHECK(inserted); // ensured by calling isNewStreamId
   stateMachine->handlePayload(std::move(payload), false, false, flagsFollows);
 }
 
+void RSocketStateMachine::sendLease() {
+  if (isDisconnected()) {
+    return;
+  }
+
+  auto lease = leaseSender_->nextLease();
+  CHECK_GT(lease.ttl.count(), 0) << "Leases must have a positive ttl";
+  lease.ttl =
+      std::min(lease.ttl, std::chrono::milliseconds{Frame_LEASE::kMaxTtl});
+  lease.numberOfRequests =
+      std::min(lease.numberOfRequests, Frame_LEASE::kMaxNumRequests);
+
+  leaseBudget_.reset(lease, LeaseBudget::Clock::now());
+  if (lease.numberOfRequests > 0) {
+    Frame_LEASE frame{static_cast<uint32_t>(lease.ttl.count()),
+                      lease.numberOfRequests};
+    VLOG(3) << "Out: " << frame;
+    outputFrameOrEnqueue(frameSerializer_->serializeOut(std::move(frame)));
+    stats_->leaseSent(lease.numberOfRequests);
+  }
+
+  const auto generation = ++leaseGeneration_;
+  leaseTimer_(
+      [weak = std::weak_ptr<RSocketStateMachine>(shared_from_this()),
+       generation] {
+        auto self = weak.lock();
+        if (self && self->leaseGeneration_ == generation) {
+          self->sendLease();
+        }
+      },
+      lease.ttl);
+}
+
+bool RSocketStateMachine::tryAcquireLease(bool local) {
+  // Leases are only granted by the server, so only client requests need one.
+  if (!leaseEnabled_ || local != (mode_ == RSocketMode::CLIENT)) {
+    return true;
+  }
+  if (leaseBudget_.tryConsume(LeaseBudget::Clock::now())) {
+    return true;
+  }
+  stats_->requestRejectedNoLease();
+  return false;
+}
+
 bool RSocketStateMachine::isNewStreamId(StreamId streamId) {
   if (frameSerializer_->protocolVersion() > ProtocolVersion{0, 0} &&
       !registerNewPeerStreamId(streamId)) {
@@ -1057,6 +1288,10 @@ bool RSocketStateMachine::shouldQueue() {
 }
 
 void RSocketStateMachine::fireAndForget(Payload request) {
+  if (!tryAcquireLease(true)) {
+    VLOG(3) << "Dropping fire-and-forget request: " << kNoLease;
+    return;
+  }
   auto const streamId = getNextStreamId();
   Frame_REQUEST_FNF frame{streamId, FrameFlags::EMPTY, std::move(request)};
   outputFrameOrEnqueue(frameSerializer_->serializeOut(std::move(frame)));
@@ -1070,6 +1305,7 @@ void RSocketStateMachine::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
 
 void RSocketStateMachine::outputFrame(std::unique_ptr<folly::IOBuf> frame) {
   DCHECK(!isDisconnected());
+  checkThreadAffinity();
 
   const auto frameType = frameSerializer_->peekFrameType(*frame);
   stats_->frameWritten(frameType);
@@ -1093,6 +1329,16 @@ bool RSocketStateMachine::isDisconnected() const {
   return !frameTransport_;
 }
 
+bool RSocketStateMachine::insertStream(
+    StreamId streamId,
+    std::shared_ptr<StreamStateMachineBase> stateMachine) {
+  if (!streams_.insert(streamId, std::move(stateMachine))) {
+    return false;
+  }
+  activeStreams_.store(streams_.size(), std::memory_order_relaxed);
+  return true;
+}
+
 bool RSocketStateMachine::isClosed() const {
   return isClosed_;
 }
@@ -1108,13 +1354,65 @@ void RSocketStateMachine::writeNewStream(
     resumeManager_->onStreamOpen(
         streamId, RequestOriginator::LOCAL, streamToken, streamType);
   }
+  classifyStream(streamId, payload);
 
   StreamsWriterImpl::writeNewStream(
       streamId, streamType, initialRequestN, std::move(payload));
 }
 
+void RSocketStateMachine::writeRequestN(Frame_REQUEST_N&& frame) {
+  checkThreadAffinity();
+  if (!requestNPolicy_.coalesce || !requestNEventBase_) {
+    StreamsWriterImpl::writeRequestN(std::move(frame));
+    return;
+  }
+
+  auto const streamId = frame.header_.streamId;
+  if (auto pending = pendingRequestN_.find(streamId)) {
+    pending->requestN_ = static_cast<uint32_t>(std::min<int64_t>(
+        int64_t{pending->requestN_} + frame.requestN_, kMaxRequestN));
+  } else {
+    pendingRequestN_.insert(streamId, std::move(frame));
+  }
+
+  if (!requestNFlushScheduled_) {
+    requestNFlushScheduled_ = true;
+    DCHECK(requestNEventBase_->isInEventBaseThread());
+    requestNEventBase_->runInLoop(
+        [weak = std::weak_ptr<RSocketStateMachine>(shared_from_this())] {
+          if (auto self = weak.lock()) {
+            self->flushRequestN();
+          }
+        });
+  }
+}
+
+void RSocketStateMachine::writeCancel(Frame_CANCEL&& frame) {
+  checkThreadAffinity();
+  // Credits for a cancelled stream are pointless, and must not follow the
+  // CANCEL on the wire.
+  pendingRequestN_.erase(frame.header_.streamId);
+  StreamsWriterImpl::writeCancel(std::move(frame));
+}
+
+void RSocketStateMachine::flushRequestN() {
+  requestNFlushScheduled_ = false;
+  auto frames = pendingRequestN_.takeAll();
+  if (isClosed()) {
+    return;
+  }
+  for (auto& frame : frames) {
+    StreamsWriterImpl::writeRequestN(std::move(frame));
+  }
+}
+
 void RSocketStateMachine::onStreamClosed(StreamId streamId) {
+  checkThreadAffinity();
   streams_.erase(streamId);
+  activeStreams_.store(streams_.size(), std::memory_order_relaxed);
+  pendingRequestN_.erase(streamId);
+  writeBlockedStreams_.erase(streamId);
+  scheduler().forgetPriority(streamId);
   resumeManager_->onStreamClosed(streamId);
 }
 
@@ -1146,8 +1444,8 @@ bool RSocketStateMachine::ensureOrAutodetectFrameSerializer(
 }
 
 size_t RSocketStateMachine::getConsumerAllowance(StreamId streamId) const {
-  auto const it = streams_.find(streamId);
-  return it != streams_.end() ? it->second->getConsumerAllowance() : 0;
+  auto const stateMachine = streams_.find(streamId);
+  return stateMachine ? (*stateMachine)->getConsumerAllowance() : 0;
 }
 
 void RSocketStateMachine::registerCloseCallback(
@@ -1198,7 +1496,7 @@ StreamId RSocketStateMachine::getNextStreamId() {
     throw std::runtime_error{"Ran out of stream IDs"};
   }
 
-  CHECK_EQ(0, streams_.count(streamId))
+  CHECK(!streams_.contains(streamId))
       << "Next stream ID already exists in the streams map";
 
   nextStreamId_ += 2;
@@ -14,18 +14,27 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <deque>
+#include <functional>
 #include <memory>
 
+#include <folly/Function.h>
+
 #include "rsocket/ColdResumeHandler.h"
 #include "rsocket/DuplexConnection.h"
+#include "rsocket/Lease.h"
 #include "rsocket/Payload.h"
 #include "rsocket/RSocketParameters.h"
 #include "rsocket/ResumeManager.h"
+#include "rsocket/framing/FrameHeaderView.h"
 #include "rsocket/framing/FrameProcessor.h"
 #include "rsocket/framing/FrameSerializer.h"
 #include "rsocket/internal/Common.h"
 #include "rsocket/internal/KeepaliveTimer.h"
+#include "rsocket/internal/LeaseBudget.h"
+#include "rsocket/internal/StreamMap.h"
 #include "rsocket/statemachine/StreamFragmentAccumulator.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
 #include "rsocket/statemachine/StreamsWriter.h"
@@ -33,6 +42,10 @@
 #include "yarpl/flowable/Subscription.h"
 #include "yarpl/single/SingleObserver.h"
 
+namespace folly {
+class EventBase;
+}
+
 namespace rsocket {
 
 class ClientResumeStatusCallback;
@@ -97,6 +110,44 @@ class RSocketStateMachine final
 
   ~RSocketStateMachine();
 
+  /// Runs a callback once a delay has passed.
+  using LeaseTimer = std::function<void(
+      folly::Function<void()> callback,
+      std::chrono::milliseconds delay)>;
+
+  /// Grant leases from `leaseSender` to a client that asked for them,
+  /// renewing each one on `eventBase` when it expires.  Requests from the
+  /// client beyond its lease are rejected.  Must be called before
+  /// connectServer().
+  void setLeaseSender(
+      std::shared_ptr<LeaseSender> leaseSender,
+      folly::EventBase& eventBase);
+
+  /// Like above, but renewals are scheduled with `timer`, which must run its
+  /// callbacks on the state machine's thread.
+  void setLeaseSender(
+      std::shared_ptr<LeaseSender> leaseSender,
+      LeaseTimer timer);
+
+  /// Set how the streams of this connection grant credits to the peer.  With
+  /// `policy.coalesce`, REQUEST_N frames are merged per stream and flushed at
+  /// the end of each loop of `eventBase`, which must be the EventBase the state
+  /// machine runs on.  Must be called before connecting.
+  void setRequestNPolicy(RequestNPolicy policy, folly::EventBase& eventBase);
+
+  /// Limit the bytes the streams of this connection may hold while they
+  /// reassemble fragmented payloads.  Must be called before connecting.
+  void setReassemblyLimits(ReassemblyLimits limits);
+
+  /// Set how the frames of this connection's streams share the connection
+  /// while it is not taking writes.  Must be called before connecting.
+  void setFrameSchedulingPolicy(FrameSchedulingPolicy policy);
+
+  /// Tie the state machine to `eventBase`, for connections that are served
+  /// entirely on one thread.  Debug builds then check that every frame and
+  /// stream signal reaches the state machine on that thread.
+  void setThreadAffinity(folly::EventBase& eventBase);
+
   /// Create a new connection as a server.
   void connectServer(std::shared_ptr<FrameTransport>, const SetupParameters&);
 
@@ -120,6 +171,12 @@ class RSocketStateMachine final
   /// Whether the connection has been disconnected or closed.
   bool isDisconnected() const;
 
+  /// Number of streams open on the connection, in either direction.  Safe to
+  /// call from any thread, so it may lag behind the state machine.
+  size_t activeStreams() const {
+    return activeStreams_.load(std::memory_order_relaxed);
+  }
+
   /// Send an ERROR frame, and close the connection and all of its streams.
   void closeWithError(Frame_ERROR&&);
 
@@ -207,7 +264,7 @@ class RSocketStateMachine final
   void onSetupFrame();
   void onResumeFrame();
   void onReservedFrame();
-  void onLeaseFrame();
+  void onLeaseFrame(uint32_t ttl, uint32_t numberOfRequests);
   void onExtFrame();
   void onUnexpectedFrame(StreamId streamId);
 
@@ -243,6 +300,30 @@ class RSocketStateMachine final
     return *stats_;
   }
 
+  const RequestNPolicy& requestNPolicy() const override {
+    return requestNPolicy_;
+  }
+
+  std::shared_ptr<ReassemblyBudget> reassemblyBudget() const override {
+    return reassemblyBudget_;
+  }
+
+  bool deferUntilWritable(StreamId) override;
+
+  bool shouldSchedule() override {
+    return writeBlocked_ && frameScheduling_.enabled;
+  }
+
+  /// Give the stream the priority the scheduling policy picks from the
+  /// payload opening it.
+  void classifyStream(StreamId, const Payload&);
+
+  void writeRequestN(Frame_REQUEST_N&&) override;
+  void writeCancel(Frame_CANCEL&&) override;
+
+  /// Write out the REQUEST_N frames coalesced during this loop.
+  void flushRequestN();
+
   FrameSerializer& serializer() override {
     return *frameSerializer_;
   }
@@ -261,8 +342,9 @@ class RSocketStateMachine final
   // FrameProcessor.
   void processFrame(std::unique_ptr<folly::IOBuf>) override;
   void onTerminal(folly::exception_wrapper) override;
+  void onWritabilityChanged(bool writable) override;
 
-  void handleFrame(StreamId, FrameType, std::unique_ptr<folly::IOBuf>);
+  void handleFrame(const FrameHeaderView&, std::unique_ptr<folly::IOBuf>);
 
   void closeStreams(StreamCompletionSignal);
   void closeFrameTransport(folly::exception_wrapper);
@@ -295,12 +377,26 @@ class RSocketStateMachine final
   bool ensureOrAutodetectFrameSerializer(const folly::IOBuf& firstFrame);
   bool ensureNotInResumption();
 
+  /// Send the next lease from leaseSender_ and schedule its renewal.
+  void sendLease();
+
+  /// Whether a lease allows a new request, sent by us if `local` and by the
+  /// peer otherwise.  Always true on connections without leases.
+  bool tryAcquireLease(bool local);
+
   size_t getConsumerAllowance(StreamId) const;
 
   void setProtocolVersionOrThrow(
       ProtocolVersion version,
       const std::shared_ptr<FrameTransport>& transport);
 
+  /// Check, in debug builds, that the caller runs on the EventBase given to
+  /// setThreadAffinity().
+  void checkThreadAffinity() const;
+
+  /// Track a new stream.  Returns false if the ID is already taken.
+  bool insertStream(StreamId, std::shared_ptr<StreamStateMachineBase>);
+
   bool isNewStreamId(StreamId streamId);
   bool registerNewPeerStreamId(StreamId streamId);
   StreamId getNextStreamId();
@@ -322,8 +418,10 @@ class RSocketStateMachine final
   std::shared_ptr<RSocketStats> stats_;
 
   /// Map of all individual stream state machines.
-  std::unordered_map<StreamId, std::shared_ptr<StreamStateMachineBase>>
-      streams_;
+  StreamMap<std::shared_ptr<StreamStateMachineBase>> streams_;
+
+  /// Size of streams_, readable from other threads.
+  std::atomic<size_t> activeStreams_{0};
   StreamId nextStreamId_;
   StreamId lastPeerStreamId_{0};
 
@@ -341,6 +439,39 @@ class RSocketStateMachine final
 
   std::shared_ptr<RSocketConnectionEvents> connectionEvents_;
 
+  /// Whether leases were negotiated in the SETUP frame.
+  bool leaseEnabled_{false};
+
+  /// Requests left under the lease we hold (client) or granted (server).
+  LeaseBudget leaseBudget_;
+
+  std::shared_ptr<LeaseSender> leaseSender_;
+  std::shared_ptr<LeaseReceiver> leaseReceiver_;
+  LeaseTimer leaseTimer_;
+
+  /// Bumped for every lease sent, so stale renewals can be dropped.
+  uint32_t leaseGeneration_{0};
+
+  RequestNPolicy requestNPolicy_;
+  folly::EventBase* requestNEventBase_{nullptr};
+
+  /// REQUEST_N frames waiting for the end of the loop, one per stream.
+  StreamMap<Frame_REQUEST_N> pendingRequestN_;
+  bool requestNFlushScheduled_{false};
+
+  /// Shared with the streams, which count the fragments they hold against it.
+  std::shared_ptr<ReassemblyBudget> reassemblyBudget_;
+
+  /// Whether the transport has stopped taking writes, and the streams that
+  /// held back their publishers since, to be resumed once it takes them again.
+  bool writeBlocked_{false};
+  StreamMap<StreamId> writeBlockedStreams_;
+
+  FrameSchedulingPolicy frameScheduling_;
+
+  /// The only EventBase the state machine may be used on, if any.
+  folly::EventBase* threadAffinity_{nullptr};
+
   CloseCallback* closeCallback_{nullptr};
 
   friend class RSocketStateMachineTest;
@@ -105,8 +105,13 @@ void RequestResponseRequester::handlePayload(
   // (State::CLOSED) should not be receiving frames when closed
   // if we fail here, we broke some internal invariant of the class
   CHECK(state_ == State::REQUESTED);
+  recordResponseLatency(StreamType::REQUEST_RESPONSE);
 
-  payloadFragments_.addPayload(std::move(payload), flagsNext, false);
+  if (!payloadFragments_.addPayload(
+          std::move(payload), flagsNext, false, flagsFollows)) {
+    handleReassemblyLimitError(true);
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -90,7 +90,12 @@ void RequestResponseResponder::handlePayload(
     bool /*flagsComplete*/,
     bool /*flagsNext*/,
     bool flagsFollows) {
-  payloadFragments_.addPayloadIgnoreFlags(std::move(payload));
+  if (!payloadFragments_.addPayloadIgnoreFlags(
+          std::move(payload), flagsFollows)) {
+    state_ = State::CLOSED;
+    handleReassemblyLimitError(false);
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
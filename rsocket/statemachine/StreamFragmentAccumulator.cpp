@@ -14,41 +14,69 @@
 
 #include "rsocket/statemachine/StreamFragmentAccumulator.h"
 
+#include "rsocket/internal/ReassemblyBudget.h"
+
 namespace rsocket {
 
-StreamFragmentAccumulator::StreamFragmentAccumulator()
-    : flagsComplete(false), flagsNext(false) {}
+namespace {
 
-void StreamFragmentAccumulator::addPayloadIgnoreFlags(Payload p) {
-  if (p.metadata) {
-    if (!fragments.metadata) {
-      fragments.metadata = std::move(p.metadata);
-    } else {
-      fragments.metadata->prev()->appendChain(std::move(p.metadata));
-    }
+/// The memory the payload's buffers keep alive, whatever part of it they use.
+size_t payloadCapacity(const Payload& p) {
+  return (p.data ? p.data->computeChainCapacity() : 0) +
+      (p.metadata ? p.metadata->computeChainCapacity() : 0);
+}
+
+void appendFragment(
+    std::unique_ptr<folly::IOBuf>& held,
+    std::unique_ptr<folly::IOBuf> fragment) {
+  if (!held) {
+    held = std::move(fragment);
+  } else {
+    held->prev()->appendChain(std::move(fragment));
   }
+}
+
+} // namespace
 
+StreamFragmentAccumulator::StreamFragmentAccumulator(
+    std::shared_ptr<ReassemblyBudget> budget)
+    : flagsComplete(false), flagsNext(false), budget_(std::move(budget)) {}
+
+StreamFragmentAccumulator::~StreamFragmentAccumulator() {
+  release();
+}
+
+bool StreamFragmentAccumulator::addPayloadIgnoreFlags(
+    Payload p,
+    bool follows) {
+  if (follows && budget_ && !reserve(payloadCapacity(p))) {
+    consumePayloadIgnoreFlags();
+    return false;
+  }
+
+  if (p.metadata) {
+    appendFragment(fragments.metadata, std::move(p.metadata));
+  }
   if (p.data) {
-    if (!fragments.data) {
-      fragments.data = std::move(p.data);
-    } else {
-      fragments.data->prev()->appendChain(std::move(p.data));
-    }
+    appendFragment(fragments.data, std::move(p.data));
   }
+  return true;
 }
 
-void StreamFragmentAccumulator::addPayload(
+bool StreamFragmentAccumulator::addPayload(
     Payload p,
     bool next,
-    bool complete) {
+    bool complete,
+    bool follows) {
   flagsNext |= next;
   flagsComplete |= complete;
-  addPayloadIgnoreFlags(std::move(p));
+  return addPayloadIgnoreFlags(std::move(p), follows);
 }
 
 Payload StreamFragmentAccumulator::consumePayloadIgnoreFlags() {
   flagsComplete = false;
   flagsNext = false;
+  release();
   return std::move(fragments);
 }
 
@@ -58,7 +86,28 @@ StreamFragmentAccumulator::consumePayloadAndFlags() {
       std::move(fragments), bool(flagsNext), bool(flagsComplete));
   flagsComplete = false;
   flagsNext = false;
+  release();
   return ret;
 }
 
+bool StreamFragmentAccumulator::reserve(size_t bytes) {
+  auto const streamLimit = budget_->limits().maxStreamBytes;
+  if (streamLimit != 0 &&
+      (bytes > streamLimit || heldBytes_ > streamLimit - bytes)) {
+    return false;
+  }
+  if (!budget_->tryReserve(bytes)) {
+    return false;
+  }
+  heldBytes_ += bytes;
+  return true;
+}
+
+void StreamFragmentAccumulator::release() {
+  if (heldBytes_ != 0) {
+    budget_->release(heldBytes_);
+    heldBytes_ = 0;
+  }
+}
+
 } /* namespace rsocket */
@@ -14,16 +14,40 @@
 
 #pragma once
 
+#include <memory>
+
 #include "rsocket/Payload.h"
 
 namespace rsocket {
 
+class ReassemblyBudget;
+
+/// Holds the fragments of a payload until its last fragment arrives.
+///
+/// The fragments are chained together as they arrive, without copying, so a
+/// reassembled payload is an IOBuf chain of the buffers its frames were read
+/// into.
+///
+/// With a budget, the memory held is limited by the budget's
+/// ReassemblyLimits.  Each fragment is charged the capacity of its buffers
+/// rather than its length, since a small fragment can keep a whole read
+/// buffer alive.  A fragment that does not fit is refused and all the
+/// fragments held so far are dropped.
 class StreamFragmentAccumulator {
  public:
-  StreamFragmentAccumulator();
+  explicit StreamFragmentAccumulator(
+      std::shared_ptr<ReassemblyBudget> budget = nullptr);
+  ~StreamFragmentAccumulator();
 
-  void addPayloadIgnoreFlags(Payload p);
-  void addPayload(Payload p, bool next, bool complete);
+  StreamFragmentAccumulator(const StreamFragmentAccumulator&) = delete;
+  StreamFragmentAccumulator& operator=(const StreamFragmentAccumulator&) =
+      delete;
+
+  /// Adds a fragment.  When `follows` is set more fragments of the payload
+  /// are to come, so the fragment is held and counted against the limits.
+  /// Returns false if the limits refused it.
+  bool addPayloadIgnoreFlags(Payload p, bool follows = false);
+  bool addPayload(Payload p, bool next, bool complete, bool follows = false);
 
   Payload consumePayloadIgnoreFlags();
   std::tuple<Payload, bool, bool> consumePayloadAndFlags();
@@ -32,10 +56,22 @@ class StreamFragmentAccumulator {
     return fragments.data || fragments.metadata;
   }
 
+  /// The buffer capacity of the fragments held and counted against the
+  /// limits.
+  size_t heldBytes() const {
+    return heldBytes_;
+  }
+
  private:
+  bool reserve(size_t bytes);
+  void release();
+
   bool flagsComplete : 1;
   bool flagsNext : 1;
   Payload fragments;
+
+  const std::shared_ptr<ReassemblyBudget> budget_;
+  size_t heldBytes_{0};
 };
 
 } /* namespace rsocket */
@@ -38,7 +38,8 @@ void StreamRequester::request(int64_t signedN) {
 
   // We must inform ConsumerBase about an implicit allowance we have requested
   // from the remote end.
-  auto const initial = std::min<uint32_t>(n, kMaxRequestN);
+  auto const initial =
+      static_cast<uint32_t>(std::min<size_t>(n, maxInitialRequestN()));
   addImplicitAllowance(initial);
   newStream(StreamType::STREAM, initial, std::move(initialPayload_));
 
@@ -70,6 +71,7 @@ void StreamRequester::handlePayload(
     handleError(std::runtime_error("Haven't sent REQUEST_STREAM yet"));
     return;
   }
+  recordResponseLatency(StreamType::STREAM);
   bool finalComplete =
       processFragmentedPayload(std::move(payload), next, complete, follows);
 
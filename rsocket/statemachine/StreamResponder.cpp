@@ -63,7 +63,14 @@ void StreamResponder::handlePayload(
     bool /*flagsComplete*/,
     bool /*flagsNext*/,
     bool flagsFollows) {
-  payloadFragments_.addPayloadIgnoreFlags(std::move(payload));
+  if (!payloadFragments_.addPayloadIgnoreFlags(
+          std::move(payload), flagsFollows)) {
+    if (newStream_) {
+      newStream_ = false;
+      handleReassemblyLimitError(false);
+    }
+    return;
+  }
 
   if (flagsFollows) {
     // there will be more fragments to come
@@ -99,4 +106,12 @@ void StreamResponder::endStream(StreamCompletionSignal signal) {
   removeFromWriter();
 }
 
+void StreamResponder::handleWritable() {
+  resumePublisher();
+}
+
+bool StreamResponder::shouldHoldRequests() {
+  return deferUntilWritable();
+}
+
 } // namespace rsocket
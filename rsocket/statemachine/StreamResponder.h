@@ -46,10 +46,13 @@ class StreamResponder : public StreamStateMachineBase,
   void handleRequestN(uint32_t) override;
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
+  void handleWritable() override;
 
   void endStream(StreamCompletionSignal) override;
 
  private:
+  bool shouldHoldRequests() override;
+
   bool newStream_{true};
 };
 
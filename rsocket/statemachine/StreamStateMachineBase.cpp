@@ -14,11 +14,19 @@
 
 #include "rsocket/statemachine/StreamStateMachineBase.h"
 #include <folly/io/IOBuf.h>
+#include "rsocket/RSocketStats.h"
 #include "rsocket/statemachine/RSocketStateMachine.h"
 #include "rsocket/statemachine/StreamsWriter.h"
 
 namespace rsocket {
 
+StreamStateMachineBase::StreamStateMachineBase(
+    std::shared_ptr<StreamsWriter> writer,
+    StreamId streamId)
+    : writer_(std::move(writer)),
+      payloadFragments_(writer_->reassemblyBudget()),
+      streamId_(streamId) {}
+
 void StreamStateMachineBase::handleRequestN(uint32_t) {
   VLOG(4) << "Unexpected handleRequestN";
 }
@@ -40,10 +48,26 @@ void StreamStateMachineBase::newStream(
     StreamType streamType,
     uint32_t initialRequestN,
     Payload payload) {
+  if (writer_->stats().latenciesEnabled()) {
+    requestedAt_ = std::chrono::steady_clock::now();
+  }
   writer_->writeNewStream(
       streamId_, streamType, initialRequestN, std::move(payload));
 }
 
+void StreamStateMachineBase::recordResponseLatency(StreamType streamType) {
+  if (requestedAt_ == std::chrono::steady_clock::time_point{}) {
+    return;
+  }
+  auto const latency = std::chrono::steady_clock::now() - requestedAt_;
+  requestedAt_ = {};
+  if (streamType == StreamType::REQUEST_RESPONSE) {
+    writer_->stats().requestResponseLatency(latency);
+  } else {
+    writer_->stats().streamFirstPayloadLatency(latency);
+  }
+}
+
 void StreamStateMachineBase::writeRequestN(uint32_t n) {
   writer_->writeRequestN(Frame_REQUEST_N{streamId_, n});
 }
@@ -81,6 +105,20 @@ void StreamStateMachineBase::removeFromWriter() {
   // TODO: set writer_ to nullptr
 }
 
+bool StreamStateMachineBase::deferUntilWritable() {
+  return writer_->deferUntilWritable(streamId_);
+}
+
+void StreamStateMachineBase::handleReassemblyLimitError(bool started) {
+  constexpr folly::StringPiece kMessage{"Payload exceeds reassembly limit"};
+  writeInvalidError(kMessage);
+  if (started) {
+    handleError(std::runtime_error(kMessage.str()));
+  } else {
+    removeFromWriter();
+  }
+}
+
 std::shared_ptr<yarpl::flowable::Subscriber<Payload>>
 StreamStateMachineBase::onNewStreamReady(
     StreamType streamType,
@@ -16,6 +16,8 @@
 
 #include <folly/ExceptionWrapper.h>
 
+#include <chrono>
+
 #include "rsocket/framing/FrameHeader.h"
 #include "rsocket/internal/Common.h"
 #include "rsocket/statemachine/StreamFragmentAccumulator.h"
@@ -39,8 +41,7 @@ class StreamStateMachineBase {
  public:
   StreamStateMachineBase(
       std::shared_ptr<StreamsWriter> writer,
-      StreamId streamId)
-      : writer_(std::move(writer)), streamId_(streamId) {}
+      StreamId streamId);
   virtual ~StreamStateMachineBase() = default;
 
   virtual void handlePayload(
@@ -54,6 +55,10 @@ class StreamStateMachineBase {
 
   virtual size_t getConsumerAllowance() const;
 
+  /// Called once the connection takes writes again, after the stream was
+  /// held back by deferUntilWritable().
+  virtual void handleWritable() {}
+
   /// Indicates a terminal signal from the connection.
   ///
   /// This signal corresponds to Subscriber::{onComplete,onError} and
@@ -82,6 +87,21 @@ class StreamStateMachineBase {
 
   void removeFromWriter();
 
+  /// Whether the stream should hold back asking its publisher for more,
+  /// because the connection has too many bytes waiting to be written.  If
+  /// so, handleWritable() is called once they have drained.
+  bool deferUntilWritable();
+
+  /// Fails the stream after its fragments exceeded the connection's
+  /// ReassemblyLimits.  The peer gets an ERROR frame; the local side, if the
+  /// stream has `started`, gets the error as if the peer had sent it.
+  void handleReassemblyLimitError(bool started);
+
+  /// Reports the time since newStream() to the stats, the first time it is
+  /// called after newStream().  Does nothing unless the stats asked for
+  /// latencies.
+  void recordResponseLatency(StreamType);
+
   std::shared_ptr<yarpl::flowable::Subscriber<Payload>> onNewStreamReady(
       StreamType streamType,
       Payload payload,
@@ -100,6 +120,9 @@ class StreamStateMachineBase {
 
  private:
   const StreamId streamId_;
+
+  /// When newStream() sent the request, if it is being timed.
+  std::chrono::steady_clock::time_point requestedAt_;
 };
 
 } // namespace rsocket
@@ -37,6 +37,35 @@ void StreamsWriterImpl::sendPendingFrames() {
   }
 }
 
+void StreamsWriterImpl::outputStreamFrame(
+    StreamId streamId,
+    std::unique_ptr<folly::IOBuf> frame) {
+  if (scheduler_.empty() && !shouldSchedule()) {
+    outputFrameOrEnqueue(std::move(frame));
+    return;
+  }
+
+  auto const length = frame->computeChainDataLength();
+  stats().streamBufferChanged(1, static_cast<int64_t>(length));
+  scheduler_.enqueue(streamId, std::move(frame));
+  flushScheduledFrames();
+}
+
+void StreamsWriterImpl::flushScheduledFrames() {
+  // Writing a frame can make a stream write more.
+  if (flushingScheduledFrames_) {
+    return;
+  }
+  flushingScheduledFrames_ = true;
+  while (!scheduler_.empty() && !shouldSchedule()) {
+    auto frame = scheduler_.dequeue();
+    auto const length = frame->computeChainDataLength();
+    stats().streamBufferChanged(-1, -static_cast<int64_t>(length));
+    outputFrameOrEnqueue(std::move(frame));
+  }
+  flushingScheduledFrames_ = false;
+}
+
 void StreamsWriterImpl::enqueuePendingOutputFrame(
     std::unique_ptr<folly::IOBuf> frame) {
   auto const length = frame->computeChainDataLength();
@@ -65,21 +94,28 @@ void StreamsWriterImpl::writeNewStream(
       [&](Payload p, FrameFlags flags) {
         switch (streamType) {
           case StreamType::CHANNEL:
-            outputFrameOrEnqueue(
+            outputStreamFrame(
+                streamId,
                 serializer().serializeOut(Frame_REQUEST_CHANNEL(
                     streamId, flags, initialRequestN, std::move(p))));
             break;
           case StreamType::STREAM:
-            outputFrameOrEnqueue(serializer().serializeOut(Frame_REQUEST_STREAM(
-                streamId, flags, initialRequestN, std::move(p))));
+            outputStreamFrame(
+                streamId,
+                serializer().serializeOut(Frame_REQUEST_STREAM(
+                    streamId, flags, initialRequestN, std::move(p))));
             break;
           case StreamType::REQUEST_RESPONSE:
-            outputFrameOrEnqueue(serializer().serializeOut(
-                Frame_REQUEST_RESPONSE(streamId, flags, std::move(p))));
+            outputStreamFrame(
+                streamId,
+                serializer().serializeOut(
+                    Frame_REQUEST_RESPONSE(streamId, flags, std::move(p))));
             break;
           case StreamType::FNF:
-            outputFrameOrEnqueue(serializer().serializeOut(
-                Frame_REQUEST_FNF(streamId, flags, std::move(p))));
+            outputStreamFrame(
+                streamId,
+                serializer().serializeOut(
+                    Frame_REQUEST_FNF(streamId, flags, std::move(p))));
             break;
           default:
             CHECK(false) << "invalid stream type " << toString(streamType);
@@ -91,11 +127,15 @@ void StreamsWriterImpl::writeNewStream(
 }
 
 void StreamsWriterImpl::writeRequestN(Frame_REQUEST_N&& frame) {
-  outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
+  auto const streamId = frame.header_.streamId;
+  outputFrameInStreamOrder(
+      streamId, serializer().serializeOut(std::move(frame)));
 }
 
 void StreamsWriterImpl::writeCancel(Frame_CANCEL&& frame) {
-  outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
+  auto const streamId = frame.header_.streamId;
+  outputFrameInStreamOrder(
+      streamId, serializer().serializeOut(std::move(frame)));
 }
 
 void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
@@ -105,8 +145,10 @@ void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
 
   writeFragmented(
       [this, streamId](Payload p, FrameFlags flags) {
-        outputFrameOrEnqueue(serializer().serializeOut(
-            Frame_PAYLOAD(streamId, flags, std::move(p))));
+        outputStreamFrame(
+            streamId,
+            serializer().serializeOut(
+                Frame_PAYLOAD(streamId, flags, std::move(p))));
       },
       streamId,
       initialFlags,
@@ -115,7 +157,20 @@ void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
 
 void StreamsWriterImpl::writeError(Frame_ERROR&& frame) {
   // TODO: implement fragmentation for writeError as well
-  outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
+  auto const streamId = frame.header_.streamId;
+  outputFrameInStreamOrder(
+      streamId, serializer().serializeOut(std::move(frame)));
+}
+
+void StreamsWriterImpl::outputFrameInStreamOrder(
+    StreamId streamId,
+    std::unique_ptr<folly::IOBuf> frame) {
+  // Don't let the frame overtake the frames its stream wrote before it.
+  if (scheduler_.contains(streamId)) {
+    outputStreamFrame(streamId, std::move(frame));
+  } else {
+    outputFrameOrEnqueue(std::move(frame));
+  }
 }
 
 // The max amount of user data transmitted per frame - eg the size
@@ -184,8 +239,10 @@ void StreamsWriterImpl::writeFragmented(
       isFirstFrame = false;
       writeInitialFrame(std::move(sendme), flags);
     } else {
-      outputFrameOrEnqueue(serializer().serializeOut(
-          Frame_PAYLOAD(streamId, flags, std::move(sendme))));
+      outputStreamFrame(
+          streamId,
+          serializer().serializeOut(
+              Frame_PAYLOAD(streamId, flags, std::move(sendme))));
     }
 
     if (!moreFragments) {
@@ -19,14 +19,17 @@
 #include <yarpl/Flowable.h>
 #include <yarpl/Single.h>
 #include "rsocket/Payload.h"
+#include "rsocket/RequestNPolicy.h"
 #include "rsocket/framing/Frame.h"
 #include "rsocket/framing/FrameType.h"
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/FrameScheduler.h"
 
 namespace rsocket {
 
 class RSocketStats;
 class FrameSerializer;
+class ReassemblyBudget;
 
 /// The interface for writing stream related frames on the wire.
 class StreamsWriter {
@@ -47,6 +50,27 @@ class StreamsWriter {
 
   virtual void onStreamClosed(StreamId) = 0;
 
+  virtual RSocketStats& stats() = 0;
+
+  /// How the consuming streams on this connection grant credits to the peer.
+  virtual const RequestNPolicy& requestNPolicy() const {
+    static const RequestNPolicy kDefault;
+    return kDefault;
+  }
+
+  /// What the streams on this connection may hold while they reassemble
+  /// fragmented payloads, or null for no limits.
+  virtual std::shared_ptr<ReassemblyBudget> reassemblyBudget() const {
+    return nullptr;
+  }
+
+  /// Whether the connection has stopped taking writes.  If so, the stream is
+  /// remembered and gets StreamStateMachineBase::handleWritable() once the
+  /// connection takes writes again.
+  virtual bool deferUntilWritable(StreamId) {
+    return false;
+  }
+
   virtual std::shared_ptr<yarpl::flowable::Subscriber<Payload>>
   onNewStreamReady(
       StreamId streamId,
@@ -80,7 +104,6 @@ class StreamsWriterImpl : public StreamsWriter {
   // note: onStreamClosed() method is also still pure
   virtual void outputFrame(std::unique_ptr<folly::IOBuf>) = 0;
   virtual FrameSerializer& serializer() = 0;
-  virtual RSocketStats& stats() = 0;
   virtual bool shouldQueue() = 0;
 
   template <typename WriteInitialFrame>
@@ -96,7 +119,32 @@ class StreamsWriterImpl : public StreamsWriter {
   void enqueuePendingOutputFrame(std::unique_ptr<folly::IOBuf> frame);
   std::deque<std::unique_ptr<folly::IOBuf>> consumePendingOutputFrames();
 
+  /// Whether frames that streams write should wait in the scheduler rather
+  /// than go out right away.
+  virtual bool shouldSchedule() {
+    return false;
+  }
+
+  /// Write out the frames waiting in the scheduler, for as long as
+  /// shouldSchedule() allows.
+  void flushScheduledFrames();
+
+  FrameScheduler& scheduler() {
+    return scheduler_;
+  }
+
  private:
+  /// Send a frame of a stream through the scheduler.
+  void outputStreamFrame(StreamId, std::unique_ptr<folly::IOBuf>);
+
+  /// Send a frame that must not overtake the frames of its stream still
+  /// waiting in the scheduler.
+  void outputFrameInStreamOrder(StreamId, std::unique_ptr<folly::IOBuf>);
+
+  /// Frames streams wrote while shouldSchedule() was true.
+  FrameScheduler scheduler_;
+  bool flushingScheduledFrames_{false};
+
   /// A queue of frames that are slated to be sent out.
   std::deque<std::unique_ptr<folly::IOBuf>> pendingOutputFrames_;
 
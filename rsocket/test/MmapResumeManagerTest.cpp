@@ -0,0 +1,248 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Executor.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/IOBuf.h>
+#include <folly/portability/SysStat.h>
+#include <gmock/gmock.h>
+
+#include "rsocket/internal/MmapResumeManager.h"
+#include "rsocket/test/test_utils/MockFrameTransport.h"
+
+using namespace ::testing;
+using namespace ::rsocket;
+
+namespace {
+
+std::vector<std::string> replay(
+    const ResumeManager& manager,
+    ResumePosition position) {
+  MockFrameTransport transport;
+  std::vector<std::string> frames;
+  EXPECT_CALL(transport, outputFrameOrDrop_(_))
+      .WillRepeatedly(Invoke([&](std::unique_ptr<folly::IOBuf>& frame) {
+        frames.push_back(frame->moveToFbString().toStdString());
+      }));
+  manager.sendFramesFromPosition(position, transport);
+  return frames;
+}
+
+void trackSent(ResumeManager& manager, std::string frame, size_t allowance) {
+  manager.trackSentFrame(
+      *folly::IOBuf::copyBuffer(frame), FrameType::PAYLOAD, 1, allowance);
+}
+
+/// Copies the files of a store, as they would be if the process crashed.
+void copyStore(const std::string& from, const std::string& to) {
+  for (auto name : {"frames", "journal.0", "journal.1", "checkpoint"}) {
+    std::string contents;
+    ASSERT_TRUE(folly::readFile((from + "/" + name).c_str(), contents));
+    ASSERT_TRUE(folly::writeFile(contents, (to + "/" + name).c_str()));
+  }
+}
+
+/// Runs checkpoints inline, or holds on to them while `hold` is set.
+class HoldingExecutor : public folly::Executor {
+ public:
+  void add(folly::Func func) override {
+    ++added;
+    if (hold) {
+      held.push_back(std::move(func));
+    } else {
+      func();
+    }
+  }
+
+  void runHeld() {
+    for (auto& func : held) {
+      func();
+    }
+    held.clear();
+  }
+
+  size_t added{0};
+  bool hold{false};
+  std::vector<folly::Func> held;
+};
+
+} // namespace
+
+class MmapResumeManagerTest : public Test {
+ protected:
+  std::string directory() const {
+    return directory_.path().string();
+  }
+
+  folly::test::TemporaryDirectory directory_;
+};
+
+TEST_F(MmapResumeManagerTest, EmptyStore) {
+  MmapResumeManager store(RSocketStats::noop(), directory());
+  EXPECT_EQ(0, store.firstSentPosition());
+  EXPECT_EQ(0, store.lastSentPosition());
+  EXPECT_EQ(0, store.impliedPosition());
+  EXPECT_TRUE(store.isPositionAvailable(0));
+  EXPECT_FALSE(store.isPositionAvailable(1));
+  EXPECT_TRUE(store.getStreamResumeInfos().empty());
+}
+
+TEST_F(MmapResumeManagerTest, RecoversAfterRestart) {
+  {
+    MmapResumeManager store(RSocketStats::noop(), directory());
+    store.onStreamOpen(1, RequestOriginator::LOCAL, "one", StreamType::STREAM);
+    store.onStreamOpen(
+        2, RequestOriginator::REMOTE, "two", StreamType::CHANNEL);
+    store.onStreamOpen(
+        3, RequestOriginator::LOCAL, "three", StreamType::STREAM);
+    store.onStreamClosed(3);
+
+    trackSent(store, "aaaa", 10);
+    trackSent(store, "bbb", 9);
+    trackSent(store, "cc", 8);
+    store.trackReceivedFrame(7, FrameType::PAYLOAD, 2, 5);
+    store.resetUpToPosition(4);
+
+    // The store is not closed in any way, as if the process had crashed.
+  }
+
+  MmapResumeManager store(RSocketStats::noop(), directory());
+  EXPECT_EQ(4, store.firstSentPosition());
+  EXPECT_EQ(9, store.lastSentPosition());
+  EXPECT_EQ(7, store.impliedPosition());
+  EXPECT_EQ(3u, store.getLargestUsedStreamId());
+
+  const auto& infos = store.getStreamResumeInfos();
+  ASSERT_EQ(2u, infos.size());
+  EXPECT_EQ("one", infos.at(1).streamToken);
+  EXPECT_EQ(StreamType::STREAM, infos.at(1).streamType);
+  EXPECT_EQ(8u, infos.at(1).consumerAllowance);
+  EXPECT_EQ("two", infos.at(2).streamToken);
+  EXPECT_EQ(RequestOriginator::REMOTE, infos.at(2).requester);
+  EXPECT_EQ(5u, infos.at(2).consumerAllowance);
+
+  EXPECT_FALSE(store.isPositionAvailable(0));
+  EXPECT_TRUE(store.isPositionAvailable(7));
+  EXPECT_EQ((std::vector<std::string>{"bbb", "cc"}), replay(store, 4));
+}
+
+TEST_F(MmapResumeManagerTest, EvictsWithinCapacity) {
+  MmapResumeManager::Options options;
+  // Room for two 6-byte frames and their lengths.
+  options.capacity = 20;
+  options.journalCapacity = 32;
+  {
+    MmapResumeManager store(RSocketStats::noop(), directory(), options);
+    store.onStreamOpen(1, RequestOriginator::LOCAL, "one", StreamType::STREAM);
+
+    // The ring wraps around many times, and the journal fills up and is
+    // checkpointed many times.
+    for (size_t i = 0; i < 100; ++i) {
+      trackSent(store, std::string(6, 'a' + i % 26), i);
+      EXPECT_LE(store.size(), options.capacity);
+    }
+    EXPECT_EQ(588, store.firstSentPosition());
+    EXPECT_EQ(600, store.lastSentPosition());
+    EXPECT_EQ(
+        (std::vector<std::string>{std::string(6, 'u'), std::string(6, 'v')}),
+        replay(store, 588));
+
+    // A frame larger than the ring empties it.
+    trackSent(store, std::string(32, 'x'), 100);
+    EXPECT_EQ(0u, store.size());
+    EXPECT_EQ(632, store.firstSentPosition());
+    EXPECT_EQ(632, store.lastSentPosition());
+
+    trackSent(store, "yyy", 101);
+  }
+
+  MmapResumeManager recovered(RSocketStats::noop(), directory(), options);
+  EXPECT_EQ(632, recovered.firstSentPosition());
+  EXPECT_EQ(635, recovered.lastSentPosition());
+  EXPECT_EQ(101u, recovered.getStreamResumeInfos().at(1).consumerAllowance);
+  EXPECT_EQ(std::vector<std::string>{"yyy"}, replay(recovered, 632));
+}
+
+TEST_F(MmapResumeManagerTest, RejectsDifferentCapacity) {
+  { MmapResumeManager store(RSocketStats::noop(), directory()); }
+
+  MmapResumeManager::Options options;
+  options.capacity = 4096;
+  EXPECT_THROW(
+      MmapResumeManager(RSocketStats::noop(), directory(), options),
+      std::runtime_error);
+}
+
+TEST_F(MmapResumeManagerTest, SizesNewFiles) {
+  MmapResumeManager::Options options;
+  { MmapResumeManager store(RSocketStats::noop(), directory(), options); }
+
+  struct stat st;
+  ASSERT_EQ(0, stat((directory() + "/frames").c_str(), &st));
+  EXPECT_LT(options.capacity, static_cast<size_t>(st.st_size));
+  for (auto journal : {"/journal.0", "/journal.1"}) {
+    ASSERT_EQ(0, stat((directory() + journal).c_str(), &st));
+    EXPECT_LT(options.journalCapacity, static_cast<size_t>(st.st_size));
+  }
+}
+
+TEST_F(MmapResumeManagerTest, RejectsTruncatedFile) {
+  ASSERT_TRUE(folly::writeFile(
+      std::string("short"), (directory() + "/frames").c_str()));
+  EXPECT_THROW(
+      MmapResumeManager(RSocketStats::noop(), directory()),
+      std::runtime_error);
+}
+
+TEST_F(MmapResumeManagerTest, RejectsSecondManager) {
+  {
+    MmapResumeManager store(RSocketStats::noop(), directory());
+    EXPECT_THROW(
+        MmapResumeManager(RSocketStats::noop(), directory()),
+        std::runtime_error);
+  }
+  MmapResumeManager store(RSocketStats::noop(), directory());
+}
+
+TEST_F(MmapResumeManagerTest, CheckpointsOnExecutorWhenJournalFills) {
+  HoldingExecutor executor;
+  MmapResumeManager::Options options;
+  // An open record is 14 bytes, and an allowance record 13.
+  options.journalCapacity = 64;
+  options.checkpointExecutor = &executor;
+  MmapResumeManager store(RSocketStats::noop(), directory(), options);
+  store.onStreamOpen(1, RequestOriginator::LOCAL, "one", StreamType::STREAM);
+  EXPECT_EQ(1u, executor.added);
+
+  // Only the fourth allowance update overflows the journal, and the
+  // checkpoint it starts is left outstanding.
+  executor.hold = true;
+  for (size_t i = 1; i <= 7; ++i) {
+    trackSent(store, "a", i);
+  }
+  EXPECT_EQ(2u, executor.added);
+  ASSERT_EQ(1u, executor.held.size());
+
+  folly::test::TemporaryDirectory crashed;
+  copyStore(directory(), crashed.path().string());
+  executor.runHeld();
+
+  // The journal stands in for the checkpoint that never made it to disk.
+  options.checkpointExecutor = nullptr;
+  MmapResumeManager recovered(
+      RSocketStats::noop(), crashed.path().string(), options);
+  EXPECT_EQ(7, recovered.lastSentPosition());
+  EXPECT_EQ(7u, recovered.getStreamResumeInfos().at(1).consumerAllowance);
+}
@@ -0,0 +1,160 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Synchronized.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "RSocketTests.h"
+#include "yarpl/Single.h"
+#include "yarpl/single/SingleTestObserver.h"
+
+using namespace rsocket;
+using namespace rsocket::tests;
+using namespace rsocket::tests::client_server;
+using namespace yarpl::single;
+
+namespace {
+
+/// Answers every request, and remembers the stream IDs it was sent on.
+class StreamIdResponder : public RSocketResponder {
+ public:
+  std::shared_ptr<Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId streamId) override {
+    streamIds.wlock()->push_back(streamId);
+    return Singles::fromGenerator<Payload>([] { return Payload("pong"); });
+  }
+
+  folly::Synchronized<std::vector<StreamId>> streamIds;
+};
+
+/// Fails its first connection attempt.
+class FlakyConnectionFactory : public ConnectionFactory {
+ public:
+  explicit FlakyConnectionFactory(std::unique_ptr<ConnectionFactory> factory)
+      : factory_{std::move(factory)} {}
+
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion version,
+      ResumeStatus resume) override {
+    if (attempts++ == 0) {
+      return folly::makeFuture<ConnectedDuplexConnection>(
+          std::runtime_error("Flaky connection"));
+    }
+    return factory_->connect(version, resume);
+  }
+
+  std::atomic<size_t> attempts{0};
+
+ private:
+  const std::unique_ptr<ConnectionFactory> factory_;
+};
+
+} // namespace
+
+TEST(RSocketClientPool, SpreadsRequestsOverConnections) {
+  auto responder = std::make_shared<StreamIdResponder>();
+  auto server = makeServer(responder);
+
+  folly::ScopedEventBaseThread worker1;
+  folly::ScopedEventBaseThread worker2;
+  RSocketClientPool::Options opts;
+  opts.connections = 3;
+  opts.factories.push_back(
+      getConnFactory(worker1.getEventBase(), *server->listeningPort()));
+  opts.factories.push_back(
+      getConnFactory(worker2.getEventBase(), *server->listeningPort()));
+
+  auto pool = RSocket::createClientPool(std::move(opts)).get();
+  EXPECT_EQ(3u, pool->connected());
+
+  for (int i = 0; i < 6; ++i) {
+    auto to = SingleTestObserver<Payload>::create();
+    pool->getRequester()->requestResponse(Payload("ping"))->subscribe(to);
+    to->awaitTerminalEvent();
+    to->assertSuccess();
+  }
+
+  // Each connection numbers its streams on its own, so every connection
+  // that got a request used stream 1.
+  auto const streamIds = responder->streamIds.copy();
+  ASSERT_EQ(6u, streamIds.size());
+  EXPECT_GT(std::count(streamIds.begin(), streamIds.end(), 1), 1);
+}
+
+TEST(RSocketClientPool, ConnectFails) {
+  folly::ScopedEventBaseThread worker;
+
+  folly::SocketAddress address;
+  address.setFromHostPort("localhost", 1);
+  RSocketClientPool::Options opts;
+  opts.connections = 2;
+  opts.factories.push_back(std::make_shared<TcpConnectionFactory>(
+      *worker.getEventBase(), std::move(address)));
+
+  EXPECT_THROW(
+      RSocket::createClientPool(std::move(opts)).get(), std::runtime_error);
+}
+
+TEST(RSocketClientPool, ReplacesFailedConnections) {
+  auto server = makeServer(std::make_shared<StreamIdResponder>());
+
+  folly::ScopedEventBaseThread worker;
+  auto factory = std::make_shared<FlakyConnectionFactory>(
+      getConnFactory(worker.getEventBase(), *server->listeningPort()));
+  RSocketClientPool::Options opts;
+  opts.connections = 2;
+  opts.factories.push_back(factory);
+  opts.reconnectDelay = std::chrono::milliseconds{10};
+
+  auto pool = RSocket::createClientPool(std::move(opts)).get();
+  EXPECT_EQ(1u, pool->connected());
+
+  while (pool->connected() < 2) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(3u, factory->attempts);
+}
+
+TEST(RSocketClientPool, PowerOfTwoChoicesSpreadsRequests) {
+  auto responder = std::make_shared<StreamIdResponder>();
+  auto server = makeServer(responder);
+
+  folly::ScopedEventBaseThread worker;
+  RSocketClientPool::Options opts;
+  opts.connections = 4;
+  opts.balancing = RSocketClientPool::Balancing::POWER_OF_TWO_CHOICES;
+  opts.factories.push_back(
+      getConnFactory(worker.getEventBase(), *server->listeningPort()));
+
+  auto pool = RSocket::createClientPool(std::move(opts)).get();
+  EXPECT_EQ(4u, pool->connected());
+
+  // Every request finds both picks idle, so where it goes is down to the
+  // random draws alone.
+  for (int i = 0; i < 32; ++i) {
+    auto to = SingleTestObserver<Payload>::create();
+    pool->getRequester()->requestResponse(Payload("ping"))->subscribe(to);
+    to->awaitTerminalEvent();
+    to->assertSuccess();
+  }
+
+  auto const streamIds = responder->streamIds.copy();
+  ASSERT_EQ(32u, streamIds.size());
+  EXPECT_GT(std::count(streamIds.begin(), streamIds.end(), 1), 1);
+}
@@ -18,6 +18,8 @@
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <gtest/gtest.h>
 #include "rsocket/test/handlers/HelloStreamRequestHandler.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+#include "yarpl/flowable/TestSubscriber.h"
 
 using namespace rsocket;
 using namespace rsocket::tests;
@@ -137,3 +139,31 @@ TEST(RSocketClientServer, CloseServerWithConnections) {
 
   server.reset();
 }
+
+/// Test streaming from a server that keeps each connection on one thread.
+TEST(RSocketClientServer, ThreadPerCoreServer) {
+  TcpConnectionAcceptor::Options opts;
+  opts.threads = 2;
+  opts.address = folly::SocketAddress("0.0.0.0", 0);
+  opts.reusePort = true;
+  // CPU 0 is the only one every machine has.
+  opts.workerCpus = {0};
+  auto server = RSocket::createServer(
+      std::make_unique<TcpConnectionAcceptor>(std::move(opts)));
+  server->setThreadPerCore();
+  auto responder = std::make_shared<HelloStreamRequestHandler>();
+  server->start([responder](const SetupParameters&) { return responder; });
+
+  folly::ScopedEventBaseThread worker;
+  for (size_t i = 0; i < 4; ++i) {
+    auto client = makeClient(worker.getEventBase(), *server->listeningPort());
+    auto ts = yarpl::flowable::TestSubscriber<std::string>::create();
+    client->getRequester()
+        ->requestStream(Payload("Bob"))
+        ->map([](auto p) { return p.moveDataToString(); })
+        ->subscribe(ts);
+    ts->awaitTerminalEvent();
+    ts->assertSuccess();
+    ts->assertValueCount(10);
+  }
+}
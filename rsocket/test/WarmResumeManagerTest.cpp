@@ -18,30 +18,13 @@
 
 #include "rsocket/framing/Frame.h"
 #include "rsocket/framing/FrameSerializer.h"
-#include "rsocket/framing/FrameTransportImpl.h"
 #include "rsocket/internal/WarmResumeManager.h"
-#include "rsocket/test/test_utils/MockDuplexConnection.h"
+#include "rsocket/test/test_utils/MockFrameTransport.h"
 #include "rsocket/test/test_utils/MockStats.h"
 
 using namespace ::testing;
 using namespace ::rsocket;
 
-namespace {
-
-class FrameTransportMock : public FrameTransportImpl {
- public:
-  FrameTransportMock()
-      : FrameTransportImpl(std::make_unique<MockDuplexConnection>()) {}
-
-  MOCK_METHOD1(outputFrameOrDrop_, void(std::unique_ptr<folly::IOBuf>&));
-
-  void outputFrameOrDrop(std::unique_ptr<folly::IOBuf> frame) override {
-    outputFrameOrDrop_(frame);
-  }
-};
-
-} // namespace
-
 class WarmResumeManagerTest : public Test {
  protected:
   std::unique_ptr<FrameSerializer> frameSerializer_{
@@ -50,7 +33,7 @@ class WarmResumeManagerTest : public Test {
 
 TEST_F(WarmResumeManagerTest, EmptyCache) {
   WarmResumeManager cache(RSocketStats::noop());
-  FrameTransportMock transport;
+  MockFrameTransport transport;
 
   EXPECT_CALL(transport, outputFrameOrDrop_(_)).Times(0);
 
@@ -71,7 +54,7 @@ TEST_F(WarmResumeManagerTest, EmptyCache) {
 
 TEST_F(WarmResumeManagerTest, OneFrame) {
   WarmResumeManager cache(RSocketStats::noop());
-  FrameTransportMock transport;
+  MockFrameTransport transport;
 
   auto frame1 = frameSerializer_->serializeOut(Frame_CANCEL(0));
   const auto frame1Size = frame1->computeChainDataLength();
@@ -112,7 +95,7 @@ TEST_F(WarmResumeManagerTest, OneFrame) {
 
 TEST_F(WarmResumeManagerTest, TwoFrames) {
   WarmResumeManager cache(RSocketStats::noop());
-  FrameTransportMock transport;
+  MockFrameTransport transport;
 
   auto frame1 = frameSerializer_->serializeOut(Frame_CANCEL(0));
   const auto frame1Size = frame1->computeChainDataLength();
@@ -344,3 +327,58 @@ TEST_F(WarmResumeManagerTest, PositionLargeFrame) {
       frame->computeChainDataLength(),
       static_cast<size_t>(cache.lastSentPosition()));
 }
+
+TEST_F(WarmResumeManagerTest, ReplayWrapsAroundRing) {
+  // Frames are copied into a ring as big as the capacity, so the third frame
+  // wraps around and evicts the first.
+  WarmResumeManager cache(RSocketStats::noop(), 10);
+  cache.trackSentFrame(
+      *folly::IOBuf::copyBuffer("aaaa"), FrameType::CANCEL, 1, 0);
+  cache.trackSentFrame(
+      *folly::IOBuf::copyBuffer("bbb"), FrameType::CANCEL, 1, 0);
+  cache.trackSentFrame(
+      *folly::IOBuf::copyBuffer("cccc"), FrameType::CANCEL, 1, 0);
+
+  EXPECT_EQ(4, cache.firstSentPosition());
+  EXPECT_EQ(11, cache.lastSentPosition());
+  EXPECT_FALSE(cache.isPositionAvailable(0));
+  EXPECT_FALSE(cache.isPositionAvailable(5));
+
+  MockFrameTransport transport;
+  std::vector<std::string> replayed;
+  EXPECT_CALL(transport, outputFrameOrDrop_(_))
+      .WillRepeatedly(Invoke([&](std::unique_ptr<folly::IOBuf>& frame) {
+        replayed.push_back(frame->moveToFbString().toStdString());
+      }));
+
+  cache.sendFramesFromPosition(4, transport);
+  EXPECT_EQ((std::vector<std::string>{"bbb", "cccc"}), replayed);
+
+  replayed.clear();
+  cache.sendFramesFromPosition(7, transport);
+  EXPECT_EQ((std::vector<std::string>{"cccc"}), replayed);
+}
+
+TEST_F(WarmResumeManagerTest, ReplayAfterRingGrows) {
+  WarmResumeManager cache(RSocketStats::noop(), 64 * 1024);
+
+  // Frames larger than the initial ring make it grow, keeping what it holds.
+  const std::string first(3000, 'a');
+  const std::string second(5000, 'b');
+  const std::string third(9000, 'c');
+  for (const auto& data : {first, second, third}) {
+    cache.trackSentFrame(
+        *folly::IOBuf::copyBuffer(data), FrameType::CANCEL, 1, 0);
+  }
+  EXPECT_EQ(17000u, cache.size());
+
+  MockFrameTransport transport;
+  std::vector<std::string> replayed;
+  EXPECT_CALL(transport, outputFrameOrDrop_(_))
+      .WillRepeatedly(Invoke([&](std::unique_ptr<folly::IOBuf>& frame) {
+        replayed.push_back(frame->moveToFbString().toStdString());
+      }));
+
+  cache.sendFramesFromPosition(0, transport);
+  EXPECT_EQ((std::vector<std::string>{first, second, third}), replayed);
+}
@@ -0,0 +1,147 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/IOBuf.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameHeaderView.h"
+#include "rsocket/framing/FrameSerializer.h"
+
+using namespace ::rsocket;
+
+namespace {
+
+template <typename Frame>
+FrameHeaderView serializeAndPeek(Frame frame) {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto buf = serializer->serializeOut(std::move(frame));
+  return serializer->peekHeader(*buf);
+}
+
+std::unique_ptr<folly::IOBuf> bytes(std::initializer_list<uint8_t> data) {
+  auto buf = folly::IOBuf::create(data.size());
+  for (auto byte : data) {
+    *buf->writableTail() = byte;
+    buf->append(1);
+  }
+  return buf;
+}
+
+} // namespace
+
+TEST(FrameHeaderViewTest, RequestStreamWithMetadata) {
+  auto const flags = FrameFlags::METADATA | FrameFlags::FOLLOWS;
+  auto header = serializeAndPeek(Frame_REQUEST_STREAM(
+      7,
+      flags,
+      5,
+      Payload(
+          folly::IOBuf::copyBuffer("data"),
+          folly::IOBuf::copyBuffer("metadata"))));
+
+  EXPECT_TRUE(header.valid());
+  EXPECT_EQ(7, header.streamId());
+  EXPECT_EQ(FrameType::REQUEST_STREAM, header.type());
+  EXPECT_EQ(flags, header.flags());
+  EXPECT_TRUE(header.hasMetadataLength());
+  EXPECT_EQ(8, header.metadataLength());
+}
+
+TEST(FrameHeaderViewTest, PayloadWithMetadata) {
+  auto const flags = FrameFlags::METADATA | FrameFlags::NEXT;
+  auto header = serializeAndPeek(Frame_PAYLOAD(
+      3,
+      flags,
+      Payload(
+          folly::IOBuf::copyBuffer("hello"),
+          folly::IOBuf::copyBuffer("meta"))));
+
+  EXPECT_TRUE(header.valid());
+  EXPECT_EQ(3, header.streamId());
+  EXPECT_EQ(FrameType::PAYLOAD, header.type());
+  EXPECT_EQ(flags, header.flags());
+  EXPECT_TRUE(header.hasMetadataLength());
+  EXPECT_EQ(4, header.metadataLength());
+}
+
+TEST(FrameHeaderViewTest, PayloadWithoutMetadata) {
+  auto header = serializeAndPeek(Frame_PAYLOAD(
+      3,
+      FrameFlags::NEXT | FrameFlags::COMPLETE,
+      Payload(folly::IOBuf::copyBuffer("hello"))));
+
+  EXPECT_TRUE(header.valid());
+  EXPECT_EQ(FrameType::PAYLOAD, header.type());
+  EXPECT_FALSE(header.hasMetadataLength());
+  EXPECT_EQ(0, header.metadataLength());
+}
+
+TEST(FrameHeaderViewTest, ShortFrames) {
+  auto cancel = serializeAndPeek(Frame_CANCEL(9));
+  EXPECT_TRUE(cancel.valid());
+  EXPECT_EQ(9, cancel.streamId());
+  EXPECT_EQ(FrameType::CANCEL, cancel.type());
+  EXPECT_EQ(6, cancel.frameLength());
+
+  auto keepalive = serializeAndPeek(Frame_KEEPALIVE(
+      FrameFlags::KEEPALIVE_RESPOND, 1234, folly::IOBuf::create(0)));
+  EXPECT_TRUE(keepalive.valid());
+  EXPECT_EQ(0, keepalive.streamId());
+  EXPECT_EQ(FrameType::KEEPALIVE, keepalive.type());
+  EXPECT_EQ(FrameFlags::KEEPALIVE_RESPOND, keepalive.flags());
+  EXPECT_FALSE(keepalive.hasMetadataLength());
+}
+
+TEST(FrameHeaderViewTest, ChainedFrame) {
+  auto buf = bytes({0x00, 0x00, 0x00, 0x05});
+  buf->appendChain(bytes({0x28, 0x00, 0x00, 0x00, 0x00, 0x01}));
+
+  FrameHeaderView header{*buf};
+  EXPECT_TRUE(header.valid());
+  EXPECT_EQ(5, header.streamId());
+  EXPECT_EQ(FrameType::PAYLOAD, header.type());
+  EXPECT_EQ(10, header.frameLength());
+}
+
+TEST(FrameHeaderViewTest, TooShort) {
+  auto buf = bytes({0x00, 0x00, 0x00, 0x01, 0x24});
+  EXPECT_FALSE(FrameHeaderView{*buf}.valid());
+}
+
+TEST(FrameHeaderViewTest, ReservedBitSet) {
+  auto buf = bytes({0x80, 0x00, 0x00, 0x01, 0x24, 0x00});
+  FrameHeaderView header{*buf};
+  EXPECT_FALSE(header.valid());
+  EXPECT_EQ(1, header.streamId());
+}
+
+TEST(FrameHeaderViewTest, MetadataOverrunsFrame) {
+  // PAYLOAD with METADATA claiming 16 bytes of metadata but carrying 2.
+  auto buf =
+      bytes({0x00, 0x00, 0x00, 0x01, 0x29, 0x00, 0x00, 0x00, 0x10, 0xAA, 0xBB});
+  FrameHeaderView header{*buf};
+  EXPECT_FALSE(header.valid());
+  EXPECT_TRUE(header.hasMetadataLength());
+  EXPECT_EQ(16, header.metadataLength());
+}
+
+TEST(FrameHeaderViewTest, UnknownType) {
+  auto buf = bytes({0x00, 0x00, 0x00, 0x01, 0x80, 0x00});
+  FrameHeaderView header{*buf};
+  EXPECT_TRUE(header.valid());
+  EXPECT_EQ(FrameType::RESERVED, header.type());
+  EXPECT_FALSE(header.hasMetadataLength());
+}
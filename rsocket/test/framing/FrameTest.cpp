@@ -303,3 +303,202 @@ TEST(FrameTest, Frame_PreallocatedFrameLengthField) {
 
   EXPECT_LT(0, serializedFrame->headroom());
 }
+
+TEST(FrameTest, Frame_PAYLOAD_SerializedIntoHeadroom) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::COMPLETE | FrameFlags::METADATA;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  frameSerializer->preallocateFrameSizeField() = true;
+
+  auto metadata = folly::IOBuf::copyBuffer(
+      std::string("i'm so meta even this acronym"), 16 /* headroom */);
+  auto data = folly::IOBuf::copyBuffer("424242");
+  auto const metadataBuf = metadata.get();
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_PAYLOAD(
+      streamId, flags, Payload(data->clone(), std::move(metadata))));
+
+  // The header went into the metadata's headroom, leaving room for the frame
+  // length field.
+  EXPECT_EQ(metadataBuf, serializedFrame.get());
+  EXPECT_LE(3, serializedFrame->headroom());
+  EXPECT_EQ(2, serializedFrame->countChainElements());
+
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  expectHeader(FrameType::PAYLOAD, flags, streamId, frame);
+  EXPECT_EQ(
+      "i'm so meta even this acronym", frame.payload_.moveMetadataToString());
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *frame.payload_.data));
+}
+
+TEST(FrameTest, Frame_REQUEST_STREAM_SerializedIntoHeadroom) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::METADATA;
+  uint32_t requestN = 3;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  frameSerializer->preallocateFrameSizeField() = true;
+
+  auto metadata = folly::IOBuf::copyBuffer(
+      std::string("i'm so meta even this acronym"), 16 /* headroom */);
+  auto data = folly::IOBuf::copyBuffer("424242");
+  auto const metadataBuf = metadata.get();
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_STREAM(
+      streamId,
+      flags,
+      requestN,
+      Payload(data->clone(), std::move(metadata))));
+
+  // The header and request N went into the metadata's headroom.
+  EXPECT_EQ(metadataBuf, serializedFrame.get());
+  EXPECT_EQ(2, serializedFrame->countChainElements());
+
+  Frame_REQUEST_STREAM frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  expectHeader(FrameType::REQUEST_STREAM, flags, streamId, frame);
+  EXPECT_EQ(requestN, frame.requestN_);
+  EXPECT_EQ(
+      "i'm so meta even this acronym", frame.payload_.moveMetadataToString());
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *frame.payload_.data));
+}
+
+TEST(FrameTest, Frame_REQUEST_CHANNEL_SerializedIntoHeadroom) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::COMPLETE;
+  uint32_t requestN = 7;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto data =
+      folly::IOBuf::copyBuffer(std::string("424242"), 16 /* headroom */);
+  auto const dataBuf = data.get();
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_CHANNEL(
+      streamId, flags, requestN, Payload(std::move(data))));
+
+  // Without metadata the header goes in front of the data.
+  EXPECT_EQ(dataBuf, serializedFrame.get());
+  EXPECT_FALSE(serializedFrame->isChained());
+
+  Frame_REQUEST_CHANNEL frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  expectHeader(FrameType::REQUEST_CHANNEL, flags, streamId, frame);
+  EXPECT_EQ(requestN, frame.requestN_);
+  EXPECT_EQ("424242", frame.payload_.moveDataToString());
+}
+
+TEST(FrameTest, Frame_PAYLOAD_SharedBufferIsNotWrittenInto) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::NEXT;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto data =
+      folly::IOBuf::copyBuffer(std::string("424242"), 16 /* headroom */);
+  auto const headroom = data->headroom();
+
+  auto serializedFrame = frameSerializer->serializeOut(
+      Frame_PAYLOAD(streamId, flags, Payload(data->clone())));
+
+  EXPECT_EQ(headroom, data->headroom());
+  EXPECT_EQ(2, serializedFrame->countChainElements());
+}
+
+TEST(FrameTest, Frame_PAYLOAD_DeserializedWithoutCopying) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::NEXT | FrameFlags::METADATA;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_PAYLOAD(
+      streamId, flags, Payload(std::string("424242"), std::string("meta"))));
+  serializedFrame->coalesce();
+  auto const frameStart = serializedFrame->data();
+
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  expectHeader(FrameType::PAYLOAD, flags, streamId, frame);
+
+  // Header, metadata length, metadata, data.
+  EXPECT_EQ(frameStart + 9, frame.payload_.metadata->data());
+  EXPECT_EQ(frameStart + 13, frame.payload_.data->data());
+  EXPECT_EQ("meta", frame.payload_.moveMetadataToString());
+  EXPECT_EQ("424242", frame.payload_.moveDataToString());
+}
+
+TEST(FrameTest, Frame_PAYLOAD_DataTakesOverChainedBuffer) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::NEXT;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto data = folly::IOBuf::copyBuffer("424242");
+  auto serializedFrame = frameSerializer->serializeOut(
+      Frame_PAYLOAD(streamId, flags, Payload(data->clone())));
+  EXPECT_EQ(2, serializedFrame->countChainElements());
+
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  expectHeader(FrameType::PAYLOAD, flags, streamId, frame);
+  EXPECT_EQ(nullptr, frame.payload_.metadata);
+  EXPECT_EQ(1, frame.payload_.data->countChainElements());
+  EXPECT_EQ(data->data(), frame.payload_.data->data());
+}
+
+TEST(FrameTest, Frame_PAYLOAD_DeserializedDataLeavesCloneIntact) {
+  uint32_t streamId = 42;
+  FrameFlags flags = FrameFlags::NEXT | FrameFlags::METADATA;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_PAYLOAD(
+      streamId, flags, Payload(std::string("424242"), std::string("meta"))));
+  serializedFrame->coalesce();
+  auto const held = serializedFrame->clone();
+  auto const heldBytes = [&] {
+    return std::string(
+        reinterpret_cast<const char*>(held->data()), held->length());
+  };
+  auto const bytes = heldBytes();
+
+  // The data and the metadata end up sharing the frame's buffer with the
+  // clone the caller still holds.
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  EXPECT_TRUE(frame.payload_.data->isShared());
+  EXPECT_EQ(bytes, heldBytes());
+
+  // Sending the payload on can't write its header into the shared headroom.
+  auto reserialized = frameSerializer->serializeOut(
+      Frame_PAYLOAD(streamId + 2, flags, std::move(frame.payload_)));
+  EXPECT_EQ(bytes, heldBytes());
+
+  Frame_PAYLOAD forwarded;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(forwarded, std::move(reserialized)));
+  expectHeader(FrameType::PAYLOAD, flags, streamId + 2, forwarded);
+  EXPECT_EQ("meta", forwarded.payload_.moveMetadataToString());
+  EXPECT_EQ("424242", forwarded.payload_.moveDataToString());
+}
+
+TEST(FrameTest, Frame_PAYLOAD_MetadataOverrunsFrame) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  // PAYLOAD with METADATA, claiming 16 bytes of metadata but carrying 2.
+  const uint8_t bytes[] = {
+      0x00, 0x00, 0x00, 0x01, 0x29, 0x20, 0x00, 0x00, 0x10, 0xAA, 0xBB};
+
+  Frame_PAYLOAD frame;
+  EXPECT_FALSE(frameSerializer->deserializeFrom(
+      frame, folly::IOBuf::copyBuffer(bytes, sizeof(bytes))));
+}
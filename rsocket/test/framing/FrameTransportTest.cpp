@@ -15,6 +15,7 @@
 #include <gtest/gtest.h>
 
 #include "rsocket/framing/FrameTransportImpl.h"
+#include "rsocket/framing/FramedDuplexConnection.h"
 #include "rsocket/test/test_utils/MockDuplexConnection.h"
 #include "rsocket/test/test_utils/MockFrameProcessor.h"
 
@@ -80,3 +81,16 @@ TEST(FrameTransport, InputSendsError) {
   transport->setFrameProcessor(std::move(processor));
   transport->close();
 }
+
+TEST(FrameTransport, WritabilityPassesThroughFramedConnection) {
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  auto rawConnection = connection.get();
+  FramedDuplexConnection framed(std::move(connection), ProtocolVersion::Latest);
+
+  std::vector<bool> changes;
+  framed.setWritabilityCallback(
+      [&changes](bool writable) { changes.push_back(writable); });
+  rawConnection->setWritable(false);
+  rawConnection->setWritable(true);
+  EXPECT_EQ((std::vector<bool>{false, true}), changes);
+}
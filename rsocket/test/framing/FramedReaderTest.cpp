@@ -111,3 +111,42 @@ TEST(FramedReader, SubscriberErrorAfterError) {
   reader->error("Oops");
   reader->onError(std::runtime_error{"Not oops"});
 }
+
+TEST(FramedReader, FramesSpanningBuffers) {
+  auto version = std::make_shared<ProtocolVersion>(ProtocolVersion::Latest);
+  auto reader = std::make_shared<FramedReader>(version);
+
+  // Three frames of six bytes each, prefixed with their length.
+  constexpr size_t kFrames = 3;
+  constexpr size_t kFrameLength = 6;
+  std::string bytes;
+  for (size_t i = 0; i < kFrames; ++i) {
+    bytes.append({'\x00', '\x00', static_cast<char>(kFrameLength)});
+    bytes.append(kFrameLength, static_cast<char>('a' + i));
+  }
+
+  auto subscriber = std::make_shared<
+      StrictMock<MockSubscriber<std::unique_ptr<folly::IOBuf>>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onNext_(_))
+      .Times(kFrames)
+      .WillRepeatedly(Invoke([i = 0](const std::unique_ptr<folly::IOBuf>&
+                                         frame) mutable {
+        EXPECT_FALSE(frame->isChained());
+        EXPECT_EQ(
+            std::string(kFrameLength, static_cast<char>('a' + i++)),
+            frame->cloneAsValue().moveToFbString().toStdString());
+      }));
+  EXPECT_CALL(*subscriber, onComplete_());
+
+  reader->onSubscribe(yarpl::flowable::Subscription::create());
+  reader->setInput(subscriber);
+
+  // Feed the bytes in chunks that don't line up with the frame boundaries.
+  constexpr size_t kChunkLength = 5;
+  for (size_t i = 0; i < bytes.size(); i += kChunkLength) {
+    reader->onNext(folly::IOBuf::copyBuffer(bytes.substr(i, kChunkLength)));
+  }
+
+  reader->onComplete();
+}
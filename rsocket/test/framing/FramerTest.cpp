@@ -69,3 +69,16 @@ TEST(Framer, ParseFrame) {
 
   framer.addFrameChunk(framer.prependSize(std::move(buf)));
 }
+
+TEST(Framer, PrependSizeLeavesSharedHeadroomAlone) {
+  FramerMock framer;
+
+  // The bytes in front of the frame belong to whoever holds the other clone.
+  auto whole = folly::IOBuf::copyBuffer("xxxxABCDEFGHIJKLMNOP");
+  auto frame = whole->clone();
+  frame->trimStart(4);
+
+  auto sized = framer.prependSize(std::move(frame));
+  EXPECT_EQ(2, sized->countChainElements());
+  EXPECT_EQ("xxxxABCDEFGHIJKLMNOP", whole->moveToFbString().toStdString());
+}
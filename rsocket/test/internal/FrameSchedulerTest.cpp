@@ -0,0 +1,120 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/FrameScheduler.h"
+
+#include <gtest/gtest.h>
+
+using namespace ::rsocket;
+
+namespace {
+
+/// A frame of `size` bytes whose first byte names its stream.
+std::unique_ptr<folly::IOBuf> frame(StreamId streamId, size_t size) {
+  auto buf = folly::IOBuf::create(size);
+  buf->append(size);
+  buf->writableData()[0] = static_cast<uint8_t>(streamId);
+  return buf;
+}
+
+/// Stream of each frame dequeued, until the scheduler is empty.
+std::vector<StreamId> drain(FrameScheduler& scheduler) {
+  std::vector<StreamId> order;
+  while (auto buf = scheduler.dequeue()) {
+    order.push_back(buf->data()[0]);
+  }
+  return order;
+}
+
+} // namespace
+
+TEST(FrameSchedulerTest, Empty) {
+  FrameScheduler scheduler;
+  EXPECT_TRUE(scheduler.empty());
+  EXPECT_EQ(nullptr, scheduler.dequeue());
+}
+
+TEST(FrameSchedulerTest, CountsWaitingFrames) {
+  FrameScheduler scheduler{100};
+  scheduler.enqueue(1, frame(1, 10));
+  scheduler.enqueue(3, frame(3, 20));
+  EXPECT_FALSE(scheduler.empty());
+  EXPECT_TRUE(scheduler.contains(1));
+  EXPECT_FALSE(scheduler.contains(5));
+  EXPECT_EQ(2u, scheduler.frames());
+  EXPECT_EQ(30u, scheduler.bytes());
+
+  scheduler.dequeue();
+  EXPECT_FALSE(scheduler.contains(1));
+  EXPECT_EQ(1u, scheduler.frames());
+  EXPECT_EQ(20u, scheduler.bytes());
+}
+
+TEST(FrameSchedulerTest, StreamsTakeTurns) {
+  FrameScheduler scheduler{100};
+  for (int i = 0; i < 3; ++i) {
+    scheduler.enqueue(1, frame(1, 100));
+  }
+  for (int i = 0; i < 3; ++i) {
+    scheduler.enqueue(3, frame(3, 100));
+  }
+  EXPECT_EQ((std::vector<StreamId>{1, 3, 1, 3, 1, 3}), drain(scheduler));
+}
+
+TEST(FrameSchedulerTest, LargeFramesDontStarveSmallOnes) {
+  FrameScheduler scheduler{1000};
+  scheduler.enqueue(1, frame(1, 4000));
+  scheduler.enqueue(1, frame(1, 4000));
+  for (int i = 0; i < 10; ++i) {
+    scheduler.enqueue(3, frame(3, 100));
+  }
+
+  // Stream 1 needs four turns of credit before its first frame goes out,
+  // while stream 3 writes all of its frames in one.
+  auto const order = drain(scheduler);
+  ASSERT_EQ(12u, order.size());
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(3u, order[i]);
+  }
+  EXPECT_EQ(1u, order[10]);
+  EXPECT_EQ(1u, order[11]);
+}
+
+TEST(FrameSchedulerTest, WeightsSplitTheBytes) {
+  FrameScheduler scheduler{100};
+  scheduler.setPriority(1, StreamPriority{0, 3});
+  for (int i = 0; i < 6; ++i) {
+    scheduler.enqueue(1, frame(1, 100));
+  }
+  for (int i = 0; i < 2; ++i) {
+    scheduler.enqueue(3, frame(3, 100));
+  }
+  EXPECT_EQ((std::vector<StreamId>{1, 1, 1, 3, 1, 1, 1, 3}), drain(scheduler));
+}
+
+TEST(FrameSchedulerTest, LowerClassesGoFirst) {
+  FrameScheduler scheduler{100};
+  scheduler.setPriority(5, StreamPriority{1, 1});
+  scheduler.enqueue(5, frame(5, 10));
+  scheduler.enqueue(5, frame(5, 10));
+  scheduler.enqueue(7, frame(7, 10));
+  scheduler.enqueue(7, frame(7, 10));
+  EXPECT_EQ((std::vector<StreamId>{7, 7, 5, 5}), drain(scheduler));
+
+  // Frames enqueued after the priority is forgotten use the default class.
+  scheduler.forgetPriority(5);
+  scheduler.enqueue(7, frame(7, 200));
+  scheduler.enqueue(5, frame(5, 10));
+  EXPECT_EQ((std::vector<StreamId>{5, 7}), drain(scheduler));
+}
@@ -0,0 +1,119 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/FreeListAllocator.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace ::rsocket;
+
+namespace {
+
+struct Stream : public std::enable_shared_from_this<Stream> {
+  explicit Stream(int id) : id{id} {}
+
+  int id;
+  char state[100];
+};
+
+/// Records the thread it is destroyed on.
+struct Tracked {
+  explicit Tracked(std::thread::id* destroyedOn) : destroyedOn{destroyedOn} {}
+
+  ~Tracked() {
+    *destroyedOn = std::this_thread::get_id();
+  }
+
+  std::thread::id* destroyedOn;
+};
+} // namespace
+
+TEST(FreeListAllocatorTest, ReusesFreedBlocks) {
+  FreeListAllocator<Stream> allocator;
+  auto first = allocator.allocate(1);
+  allocator.deallocate(first, 1);
+  auto const cached = allocator.freeList()->cached();
+  EXPECT_LE(1U, cached);
+
+  auto second = allocator.allocate(1);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(cached - 1, allocator.freeList()->cached());
+  allocator.deallocate(second, 1);
+}
+
+TEST(FreeListAllocatorTest, MakeShared) {
+  auto stream = makeFreeListShared<Stream>(7);
+  EXPECT_EQ(7, stream->id);
+  EXPECT_EQ(stream, stream->shared_from_this());
+
+  auto const block = static_cast<void*>(stream.get());
+  stream.reset();
+  stream = makeFreeListShared<Stream>(8);
+  EXPECT_EQ(block, static_cast<void*>(stream.get()));
+  EXPECT_EQ(8, stream->id);
+}
+
+TEST(FreeListAllocatorTest, CacheIsBounded) {
+  FreeListAllocator<Stream> allocator;
+  auto const maxCached = allocator.freeList()->kMaxCachedBlocks;
+
+  std::vector<Stream*> blocks;
+  for (size_t i = 0; i < maxCached * 2; ++i) {
+    blocks.push_back(allocator.allocate(1));
+  }
+  for (auto block : blocks) {
+    allocator.deallocate(block, 1);
+  }
+  EXPECT_EQ(maxCached, allocator.freeList()->cached());
+}
+
+TEST(FreeListAllocatorTest, FreeOnAnotherThread) {
+  std::thread::id destroyedOn;
+  auto tracked = makeFreeListShared<Tracked>(&destroyedOn);
+
+  std::thread::id freeingThread;
+  std::thread([&freeingThread, tracked = std::move(tracked)]() mutable {
+    freeingThread = std::this_thread::get_id();
+    tracked.reset();
+  }).join();
+
+  EXPECT_NE(std::thread::id(), freeingThread);
+  EXPECT_EQ(freeingThread, destroyedOn);
+}
+
+TEST(FreeListAllocatorTest, FreeAfterThreadTeardown) {
+  // Frees its block from a thread-local destructor that runs after the
+  // thread's free list has been destroyed.
+  struct LateFree {
+    ~LateFree() {
+      listGone = !FreeListAllocator<Stream>::freeList();
+      FreeListAllocator<Stream>().deallocate(block, 1);
+    }
+
+    Stream* block{nullptr};
+    bool& listGone;
+  };
+
+  bool listGone = false;
+  std::thread([&listGone] {
+    // Constructed before the free list, so destroyed after it.
+    static thread_local LateFree late{nullptr, listGone};
+    late.block = FreeListAllocator<Stream>().allocate(1);
+  }).join();
+
+  EXPECT_TRUE(listGone);
+}
@@ -0,0 +1,133 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/IOBufPool.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "rsocket/RSocketStats.h"
+
+using namespace ::rsocket;
+
+namespace {
+
+class CountingStats : public RSocketStats {
+ public:
+  void bufferPoolHit() override {
+    ++hits;
+  }
+
+  void bufferPoolMiss() override {
+    ++misses;
+  }
+
+  void bufferPoolFootprint(size_t bytes) override {
+    footprint = bytes;
+  }
+
+  size_t hits{0};
+  size_t misses{0};
+  size_t footprint{0};
+};
+} // namespace
+
+TEST(IOBufPoolTest, RecyclesFreedBuffers) {
+  auto& pool = IOBufPool::get();
+  auto buf = pool.allocate(4000);
+  EXPECT_EQ(4096U, buf->capacity());
+  EXPECT_EQ(0U, buf->length());
+  auto const slab = buf->data();
+
+  buf.reset();
+  auto const footprint = pool.counters().footprint;
+  EXPECT_LE(4096U, footprint);
+
+  auto const hits = pool.counters().hits;
+  buf = pool.allocate(4096);
+  EXPECT_EQ(slab, buf->data());
+  EXPECT_EQ(hits + 1, pool.counters().hits);
+  EXPECT_EQ(footprint - 4096, pool.counters().footprint);
+}
+
+TEST(IOBufPoolTest, SizeClasses) {
+  auto& pool = IOBufPool::get();
+  EXPECT_EQ(4096U, pool.allocate(1)->capacity());
+  EXPECT_EQ(16384U, pool.allocate(4097)->capacity());
+  EXPECT_EQ(65536U, pool.allocate(65536)->capacity());
+
+  // Too large to pool.
+  auto const counters = pool.counters();
+  EXPECT_LE(65537U, pool.allocate(65537)->capacity());
+  EXPECT_EQ(counters.hits, pool.counters().hits);
+  EXPECT_EQ(counters.misses, pool.counters().misses);
+}
+
+TEST(IOBufPoolTest, IdleBytesAreBounded) {
+  auto& pool = IOBufPool::get();
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  for (size_t i = 0; i < 2 * IOBufPool::kMaxIdleBytes / 65536; ++i) {
+    bufs.push_back(pool.allocate(65536));
+  }
+  bufs.clear();
+  EXPECT_GE(IOBufPool::kMaxIdleBytes, pool.counters().footprint);
+}
+
+TEST(IOBufPoolTest, ReportsToStats) {
+  auto& pool = IOBufPool::get();
+  CountingStats stats;
+
+  // Drain the idle 16KB slabs so the first allocation misses.
+  std::vector<std::unique_ptr<folly::IOBuf>> drained;
+  while (pool.counters().footprint > 0) {
+    drained.push_back(pool.allocate(16384));
+    drained.push_back(pool.allocate(4096));
+    drained.push_back(pool.allocate(65536));
+  }
+  auto buf = pool.allocate(10000, &stats);
+  EXPECT_EQ(0U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+
+  buf.reset();
+  buf = pool.allocate(10000, &stats);
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(pool.counters().footprint, stats.footprint);
+}
+
+TEST(IOBufPoolTest, FreeOnAnotherThread) {
+  auto& pool = IOBufPool::get();
+  auto buf = pool.allocate(4096);
+  auto const footprint = pool.counters().footprint;
+
+  // The slab goes back to the allocator, not into either thread's pool.
+  std::thread([&] {
+    auto const otherFootprint = IOBufPool::get().counters().footprint;
+    buf.reset();
+    EXPECT_EQ(otherFootprint, IOBufPool::get().counters().footprint);
+  }).join();
+  EXPECT_EQ(footprint, pool.counters().footprint);
+}
+
+TEST(IOBufPoolTest, FreeAfterOwningThreadExited) {
+  std::unique_ptr<folly::IOBuf> buf;
+  std::thread([&] { buf = IOBufPool::get().allocate(4096); }).join();
+
+  // The allocating pool is destroyed by now; freeing must not touch it.
+  auto const footprint = IOBufPool::get().counters().footprint;
+  buf.reset();
+  EXPECT_EQ(footprint, IOBufPool::get().counters().footprint);
+}
@@ -0,0 +1,132 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/LatencyHistogram.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace ::rsocket;
+using namespace std::chrono;
+
+TEST(LatencyHistogramTest, Buckets) {
+  // Small values are exact.
+  for (uint64_t i = 0; i < LatencyHistogram::kSubBuckets; ++i) {
+    EXPECT_EQ(i, LatencyHistogram::bucketFor(i));
+    EXPECT_EQ(i, LatencyHistogram::bucketUpperBound(i));
+  }
+
+  // Larger values are within one sub-bucket of their bucket's upper bound.
+  for (uint64_t value : {16ULL, 17ULL, 100ULL, 12345ULL, 987654321ULL}) {
+    auto const bucket = LatencyHistogram::bucketFor(value);
+    auto const upper = LatencyHistogram::bucketUpperBound(bucket);
+    EXPECT_LE(value, upper);
+    EXPECT_LE(upper - value, value / LatencyHistogram::kSubBuckets);
+    EXPECT_LT(LatencyHistogram::bucketUpperBound(bucket - 1), value);
+  }
+
+  // Buckets are contiguous.
+  for (size_t i = 1; i < LatencyHistogram::kBuckets; ++i) {
+    auto const lower = LatencyHistogram::bucketUpperBound(i - 1) + 1;
+    EXPECT_EQ(i, LatencyHistogram::bucketFor(lower));
+  }
+
+  EXPECT_EQ(
+      LatencyHistogram::kBuckets - 1,
+      LatencyHistogram::bucketFor(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.snapshot().count());
+  EXPECT_EQ(nanoseconds{0}, histogram.snapshot().percentile(99));
+
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(microseconds{i});
+  }
+
+  auto const snapshot = histogram.snapshot();
+  EXPECT_EQ(1000U, snapshot.count());
+
+  auto const near = [](nanoseconds actual, nanoseconds expected) {
+    return actual >= expected && actual <= expected + expected / 16;
+  };
+  EXPECT_TRUE(near(snapshot.percentile(50), microseconds{500}));
+  EXPECT_TRUE(near(snapshot.percentile(99), microseconds{990}));
+  EXPECT_TRUE(near(snapshot.percentile(100), microseconds{1000}));
+}
+
+TEST(LatencyHistogramTest, RecordFromManyThreadsAndMerge) {
+  LatencyHistogram first;
+  LatencyHistogram second;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) {
+        first.record(microseconds{1});
+        second.record(milliseconds{1});
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto snapshot = first.snapshot();
+  EXPECT_EQ(8000U, snapshot.count());
+  snapshot.merge(second.snapshot());
+  EXPECT_EQ(16000U, snapshot.count());
+  EXPECT_LT(snapshot.percentile(50), microseconds{2});
+  EXPECT_GE(snapshot.percentile(51), milliseconds{1});
+}
+
+TEST(LatencyHistogramTest, SnapshotWhileThreadsRecord) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.snapshot().count());
+
+  // The threads race to allocate the shards they share while the snapshots
+  // read them.
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 16; ++t) {
+    threads.emplace_back([&] {
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < 10000; ++i) {
+        histogram.record(nanoseconds{i});
+      }
+    });
+  }
+  go = true;
+
+  uint64_t last = 0;
+  while (last < 160000) {
+    auto const count = histogram.snapshot().count();
+    EXPECT_GE(count, last);
+    last = count;
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto const snapshot = histogram.snapshot();
+  EXPECT_EQ(160000U, snapshot.count());
+  EXPECT_LE(nanoseconds{9999}, snapshot.percentile(100));
+}
@@ -0,0 +1,54 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/LeaseBudget.h"
+
+#include <gtest/gtest.h>
+
+using namespace ::rsocket;
+
+TEST(LeaseBudgetTest, NoLease) {
+  LeaseBudget budget;
+  auto const now = LeaseBudget::Clock::now();
+  EXPECT_EQ(0U, budget.remaining(now));
+  EXPECT_FALSE(budget.tryConsume(now));
+}
+
+TEST(LeaseBudgetTest, ConsumeUpToNumberOfRequests) {
+  LeaseBudget budget;
+  auto const now = LeaseBudget::Clock::now();
+  budget.reset(Lease{std::chrono::seconds{1}, 3}, now);
+  EXPECT_EQ(3U, budget.remaining(now));
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(budget.tryConsume(now));
+  }
+  EXPECT_FALSE(budget.tryConsume(now));
+  EXPECT_EQ(0U, budget.remaining(now));
+}
+
+TEST(LeaseBudgetTest, ExpiresAfterTtl) {
+  LeaseBudget budget;
+  auto const now = LeaseBudget::Clock::now();
+  budget.reset(Lease{std::chrono::seconds{1}, 3}, now);
+
+  auto const later = now + std::chrono::seconds{1};
+  EXPECT_EQ(0U, budget.remaining(later));
+  EXPECT_FALSE(budget.tryConsume(later));
+
+  // A new lease replaces the expired one.
+  budget.reset(Lease{std::chrono::seconds{1}, 1}, later);
+  EXPECT_TRUE(budget.tryConsume(later));
+  EXPECT_FALSE(budget.tryConsume(later));
+}
@@ -0,0 +1,127 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/ReadBufferSizer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace ::rsocket;
+
+namespace {
+
+/// A frame with a 24-bit length prefix and `length` bytes of body.
+std::vector<uint8_t> frame(size_t length) {
+  std::vector<uint8_t> bytes(ReadBufferSizer::kFrameLengthFieldSize + length);
+  bytes[0] = static_cast<uint8_t>(length >> 16);
+  bytes[1] = static_cast<uint8_t>(length >> 8);
+  bytes[2] = static_cast<uint8_t>(length);
+  return bytes;
+}
+
+} // namespace
+
+TEST(ReadBufferSizerTest, GrowsWhileReadsFillTheBuffer) {
+  ReadBufferSizer sizer(4096, 64 * 1024, false);
+  std::vector<uint8_t> data(64 * 1024);
+  EXPECT_EQ(4096U, sizer.nextReadSize());
+
+  for (size_t expected : {8192U, 16384U, 32768U, 65536U, 65536U}) {
+    auto const size = sizer.nextReadSize();
+    sizer.onRead(data.data(), size, size);
+    EXPECT_EQ(expected, sizer.nextReadSize());
+  }
+}
+
+TEST(ReadBufferSizerTest, ShrinksAfterSmallReads) {
+  ReadBufferSizer sizer(4096, 64 * 1024, false);
+  std::vector<uint8_t> data(64 * 1024);
+  for (int i = 0; i < 4; ++i) {
+    sizer.onRead(data.data(), sizer.nextReadSize(), sizer.nextReadSize());
+  }
+  ASSERT_EQ(65536U, sizer.nextReadSize());
+
+  // A single small read is not enough to shrink.
+  sizer.onRead(data.data(), 100, 65536);
+  EXPECT_EQ(65536U, sizer.nextReadSize());
+  sizer.onRead(data.data(), 100, 65536);
+  EXPECT_EQ(32768U, sizer.nextReadSize());
+
+  for (int i = 0; i < 20; ++i) {
+    sizer.onRead(data.data(), 100, sizer.nextReadSize());
+  }
+  EXPECT_EQ(4096U, sizer.nextReadSize());
+}
+
+TEST(ReadBufferSizerTest, SizesReadsForTheRestOfAFrame) {
+  ReadBufferSizer sizer(4096, 128 * 1024, true);
+  auto const bytes = frame(100000);
+
+  // Only part of the length field arrived, so the frame size is unknown.
+  sizer.onRead(bytes.data(), 2, 4096);
+  EXPECT_EQ(2U, sizer.incompleteFrameBytes());
+  EXPECT_EQ(0U, sizer.incompleteFrameSize());
+  EXPECT_EQ(4096U, sizer.nextReadSize());
+
+  sizer.onRead(bytes.data() + 2, 1000, 4096);
+  EXPECT_EQ(1002U, sizer.incompleteFrameBytes());
+  EXPECT_EQ(bytes.size(), sizer.incompleteFrameSize());
+  EXPECT_EQ(bytes.size() - 1002, sizer.nextReadSize());
+
+  // The read filled its buffer, so reads grow.
+  sizer.onRead(bytes.data() + 1002, bytes.size() - 1002, bytes.size() - 1002);
+  EXPECT_EQ(0U, sizer.incompleteFrameBytes());
+  EXPECT_EQ(8192U, sizer.nextReadSize());
+}
+
+TEST(ReadBufferSizerTest, FrameHintIsBoundedByMaxSize) {
+  ReadBufferSizer sizer(4096, 64 * 1024, true);
+  auto const bytes = frame(0xFFFFFF);
+
+  // Nothing but a length prefix announcing a 16MB frame.
+  sizer.onRead(bytes.data(), ReadBufferSizer::kFrameLengthFieldSize, 4096);
+  EXPECT_EQ(bytes.size(), sizer.incompleteFrameSize());
+  EXPECT_EQ(64 * 1024U, sizer.nextReadSize());
+
+  // The frame is read a maximum-sized read at a time.
+  size_t offset = ReadBufferSizer::kFrameLengthFieldSize;
+  while (offset < bytes.size()) {
+    auto const size = sizer.nextReadSize();
+    EXPECT_GE(64 * 1024U, size);
+    auto const len = std::min(size, bytes.size() - offset);
+    sizer.onRead(bytes.data() + offset, len, size);
+    offset += len;
+  }
+  EXPECT_EQ(0U, sizer.incompleteFrameBytes());
+}
+
+TEST(ReadBufferSizerTest, TracksSeveralFramesPerRead) {
+  ReadBufferSizer sizer(4096, 4096, true);
+  std::vector<uint8_t> bytes;
+  for (size_t length : {10U, 0U, 300U, 20U}) {
+    auto const next = frame(length);
+    bytes.insert(bytes.end(), next.begin(), next.end());
+  }
+
+  // Everything but the last 5 bytes of the last frame.
+  sizer.onRead(bytes.data(), bytes.size() - 5, 4096);
+  EXPECT_EQ(18U, sizer.incompleteFrameBytes());
+  EXPECT_EQ(23U, sizer.incompleteFrameSize());
+
+  sizer.onRead(bytes.data() + bytes.size() - 5, 5, 4096);
+  EXPECT_EQ(0U, sizer.incompleteFrameBytes());
+  EXPECT_EQ(0U, sizer.incompleteFrameSize());
+}
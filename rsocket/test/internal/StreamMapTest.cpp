@@ -0,0 +1,108 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/StreamMap.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <unordered_map>
+
+using namespace ::rsocket;
+
+TEST(StreamMapTest, InsertFindErase) {
+  StreamMap<int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.find(1));
+  EXPECT_FALSE(map.erase(1));
+
+  EXPECT_TRUE(map.insert(1, 10));
+  EXPECT_TRUE(map.insert(2, 20));
+  EXPECT_FALSE(map.insert(1, 30));
+  EXPECT_EQ(2U, map.size());
+
+  ASSERT_NE(nullptr, map.find(1));
+  EXPECT_EQ(10, *map.find(1));
+  ASSERT_NE(nullptr, map.find(2));
+  EXPECT_EQ(20, *map.find(2));
+  EXPECT_FALSE(map.contains(3));
+
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_FALSE(map.erase(1));
+  EXPECT_FALSE(map.contains(1));
+  EXPECT_TRUE(map.contains(2));
+  EXPECT_EQ(1U, map.size());
+}
+
+TEST(StreamMapTest, InterleavedStreamIds) {
+  // Client (odd) and server (even) stream IDs share home slots.
+  StreamMap<StreamId> map;
+  for (StreamId id = 1; id <= 1000; ++id) {
+    EXPECT_TRUE(map.insert(id, id));
+  }
+  for (StreamId id = 1; id <= 1000; id += 2) {
+    EXPECT_TRUE(map.erase(id));
+  }
+  for (StreamId id = 1; id <= 1000; ++id) {
+    auto const value = map.find(id);
+    if (id % 2) {
+      EXPECT_EQ(nullptr, value);
+    } else {
+      ASSERT_NE(nullptr, value);
+      EXPECT_EQ(id, *value);
+    }
+  }
+  EXPECT_EQ(500U, map.size());
+}
+
+TEST(StreamMapTest, SlidingWindowOfStreams) {
+  // Streams opened and closed in order, as on a long-lived connection, must
+  // keep reusing the table instead of growing it.
+  StreamMap<std::shared_ptr<StreamId>> map;
+  std::unordered_map<StreamId, StreamId> reference;
+
+  constexpr StreamId kWindow = 100;
+  for (StreamId id = 1; id < 100000; id += 2) {
+    EXPECT_TRUE(map.insert(id, std::make_shared<StreamId>(id)));
+    reference.emplace(id, id);
+    if (id > 2 * kWindow) {
+      auto const closed = id - 2 * kWindow;
+      EXPECT_TRUE(map.erase(closed));
+      reference.erase(closed);
+    }
+  }
+
+  EXPECT_EQ(reference.size(), map.size());
+  for (auto const& entry : reference) {
+    auto const value = map.find(entry.first);
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(entry.second, **value);
+  }
+}
+
+TEST(StreamMapTest, TakeAll) {
+  StreamMap<std::unique_ptr<int>> map;
+  for (StreamId id = 1; id <= 100; ++id) {
+    map.insert(id, std::make_unique<int>(id));
+  }
+  map.erase(50);
+
+  auto values = map.takeAll();
+  EXPECT_EQ(99U, values.size());
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.find(1));
+
+  EXPECT_TRUE(map.insert(1, std::make_unique<int>(1)));
+  EXPECT_TRUE(map.contains(1));
+}
@@ -13,12 +13,17 @@
 // limitations under the License.
 
 #include "rsocket/statemachine/RSocketStateMachine.h"
+#include <algorithm>
+#include <folly/io/async/EventBase.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <yarpl/single/SingleSubscriptions.h>
 #include <yarpl/single/Singles.h>
 #include <yarpl/test_utils/Mocks.h>
+#include "rsocket/LatencyStats.h"
+#include "rsocket/Lease.h"
 #include "rsocket/RSocketConnectionEvents.h"
+#include "rsocket/RSocketErrors.h"
 #include "rsocket/RSocketResponder.h"
 #include "rsocket/framing/FrameSerializer_v1_0.h"
 #include "rsocket/framing/FrameTransportImpl.h"
@@ -69,6 +74,10 @@ class ResponderMock : public RSocketResponder {
   }
 };
 
+struct LeaseReceiverMock : public LeaseReceiver {
+  MOCK_METHOD1(onLease, void(const Lease&));
+};
+
 struct ConnectionEventsMock : public RSocketConnectionEvents {
   MOCK_METHOD1(onDisconnected, void(const folly::exception_wrapper&));
   MOCK_METHOD0(onStreamsPaused, void());
@@ -133,8 +142,19 @@ class RSocketStateMachineTest : public Test {
     return stateMachine;
   }
 
-  const std::unordered_map<StreamId, std::shared_ptr<StreamStateMachineBase>>&
-  getStreams(RSocketStateMachine& stateMachine) {
+  /// Records the type of every frame sent on `connection`.
+  static void recordFrameTypes(
+      MockDuplexConnection& connection,
+      std::vector<FrameType>& frameTypes) {
+    ON_CALL(connection, send_(_))
+        .WillByDefault(
+            Invoke([&frameTypes](std::unique_ptr<folly::IOBuf>& buf) {
+              frameTypes.push_back(FrameSerializerV1_0().peekFrameType(*buf));
+            }));
+  }
+
+  const StreamMap<std::shared_ptr<StreamStateMachineBase>>& getStreams(
+      RSocketStateMachine& stateMachine) {
     return stateMachine.streams_;
   }
 
@@ -189,7 +209,7 @@ TEST_F(RSocketStateMachineTest, RequestStream) {
   ASSERT_EQ(1, streams.size());
 
   // This line causes: subscriber.onComplete()
-  streams.at(1)->endStream(StreamCompletionSignal::CANCEL);
+  (*streams.find(1))->endStream(StreamCompletionSignal::CANCEL);
 
   stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
 }
@@ -227,7 +247,7 @@ TEST_F(RSocketStateMachineTest, RequestStream_EarlyClose) {
   // Second stream should still be valid
   ASSERT_EQ(1, streams.size());
 
-  streams.at(3)->endStream(StreamCompletionSignal::CANCEL);
+  (*streams.find(3))->endStream(StreamCompletionSignal::CANCEL);
   stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
 }
 
@@ -252,7 +272,7 @@ TEST_F(RSocketStateMachineTest, RequestChannel) {
   ASSERT_EQ(1, streams.size());
 
   // This line causes: in.onComplete() and outSubscription.cancel()
-  streams.at(1)->endStream(StreamCompletionSignal::CANCEL);
+  (*streams.find(1))->endStream(StreamCompletionSignal::CANCEL);
 
   stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
 }
@@ -272,7 +292,8 @@ TEST_F(RSocketStateMachineTest, RequestResponse) {
   ASSERT_EQ(1, streams.size());
 
   // This line closes the stream
-  streams.at(1)->handlePayload(Payload{"test", "123"}, true, false, false);
+  (*streams.find(1))
+      ->handlePayload(Payload{"test", "123"}, true, false, false);
 
   stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
 }
@@ -303,6 +324,39 @@ TEST_F(RSocketStateMachineTest, RespondStream) {
   stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
 }
 
+TEST_F(RSocketStateMachineTest, RespondStreamWaitsForWritableConnection) {
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  auto* const rawConnection = connection.get();
+  std::vector<FrameType> frameTypes;
+  recordFrameTypes(*connection, frameTypes);
+
+  int sendCount = 0;
+  auto responder = std::make_shared<StrictMock<ResponderMock>>();
+  EXPECT_CALL(*responder, handleRequestStream_(_))
+      .WillOnce(Return(
+          yarpl::flowable::Flowable<Payload>::fromGenerator([&sendCount]() {
+            ++sendCount;
+            return Payload{};
+          })));
+
+  auto stateMachine = createClient(std::move(connection), responder);
+
+  // The connection went over its high water mark: the stream's initial
+  // request is held back instead of reaching the publisher.
+  rawConnection->setWritable(false);
+  setupRequestStream(*stateMachine, 2, 5, Payload{});
+  EXPECT_EQ(0, sendCount);
+  EXPECT_EQ(std::vector<FrameType>{FrameType::SETUP}, frameTypes);
+
+  // Draining to the low water mark releases it.
+  rawConnection->setWritable(true);
+  EXPECT_EQ(5, sendCount);
+  EXPECT_EQ(
+      5, std::count(frameTypes.begin(), frameTypes.end(), FrameType::PAYLOAD));
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
 TEST_F(RSocketStateMachineTest, RespondChannel) {
   auto connection = std::make_unique<StrictMock<MockDuplexConnection>>();
   int requestCount = 5;
@@ -428,4 +482,247 @@ TEST_F(RSocketStateMachineTest, ResumeWithCurrentConnection) {
   stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
 }
 
+TEST_F(RSocketStateMachineTest, LeaseBoundsRequestFlood) {
+  folly::EventBase evb;
+  std::vector<FrameType> frameTypes;
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  recordFrameTypes(*connection, frameTypes);
+
+  constexpr uint32_t kLeasedRequests = 10;
+  auto responder = std::make_shared<StrictMock<ResponderMock>>();
+  EXPECT_CALL(*responder, handleRequestResponse_(_))
+      .Times(kLeasedRequests)
+      .WillRepeatedly(Invoke([](StreamId) {
+        return Singles::fromGenerator<Payload>([] { return Payload{}; });
+      }));
+
+  auto stateMachine = std::make_shared<RSocketStateMachine>(
+      responder,
+      nullptr,
+      RSocketMode::SERVER,
+      nullptr,
+      nullptr,
+      ResumeManager::makeEmpty(),
+      nullptr);
+  stateMachine->setLeaseSender(
+      std::make_shared<FixedLeaseSender>(
+          Lease{std::chrono::hours{1}, kLeasedRequests}),
+      evb);
+
+  SetupParameters setupParameters;
+  setupParameters.lease = true;
+  stateMachine->connectServer(
+      std::make_shared<FrameTransportImpl>(std::move(connection)),
+      setupParameters);
+  ASSERT_EQ(std::vector<FrameType>{FrameType::LEASE}, frameTypes);
+
+  // The client ignores its lease and floods the server.
+  constexpr StreamId kRequests = 1000;
+  for (StreamId i = 0; i < kRequests; ++i) {
+    setupRequestResponse(*stateMachine, 2 * i + 1, Payload{});
+  }
+
+  auto const count = [&](FrameType type) {
+    return std::count(frameTypes.begin(), frameTypes.end(), type);
+  };
+  EXPECT_EQ(kLeasedRequests, count(FrameType::PAYLOAD));
+  EXPECT_EQ(kRequests - kLeasedRequests, count(FrameType::ERROR));
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
+TEST_F(RSocketStateMachineTest, LeaseIsRenewedWhenItExpires) {
+  // Renewals are queued here and run by hand instead of waiting for them.
+  std::vector<std::pair<folly::Function<void()>, std::chrono::milliseconds>>
+      timers;
+  auto const fireTimer = [&timers] {
+    ASSERT_EQ(1u, timers.size());
+    auto callback = std::move(timers.front().first);
+    timers.clear();
+    callback();
+  };
+
+  std::vector<FrameType> frameTypes;
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  recordFrameTypes(*connection, frameTypes);
+
+  auto stateMachine = std::make_shared<RSocketStateMachine>(
+      std::make_shared<RSocketResponder>(),
+      nullptr,
+      RSocketMode::SERVER,
+      nullptr,
+      nullptr,
+      ResumeManager::makeEmpty(),
+      nullptr);
+  stateMachine->setLeaseSender(
+      std::make_shared<FixedLeaseSender>(
+          Lease{std::chrono::milliseconds{10}, 1}),
+      [&timers](
+          folly::Function<void()> callback, std::chrono::milliseconds delay) {
+        timers.emplace_back(std::move(callback), delay);
+      });
+
+  SetupParameters setupParameters;
+  setupParameters.lease = true;
+  stateMachine->connectServer(
+      std::make_shared<FrameTransportImpl>(std::move(connection)),
+      setupParameters);
+  EXPECT_EQ(std::vector<FrameType>{FrameType::LEASE}, frameTypes);
+
+  // Each lease schedules its renewal for when it expires.
+  ASSERT_EQ(1u, timers.size());
+  EXPECT_EQ(std::chrono::milliseconds{10}, timers.front().second);
+  fireTimer();
+  fireTimer();
+  EXPECT_EQ(
+      3, std::count(frameTypes.begin(), frameTypes.end(), FrameType::LEASE));
+
+  // No more leases once the connection is closed.
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+  frameTypes.clear();
+  fireTimer();
+  EXPECT_TRUE(frameTypes.empty());
+  EXPECT_TRUE(timers.empty());
+}
+
+TEST_F(RSocketStateMachineTest, ClientRequestsNeedLease) {
+  std::vector<FrameType> frameTypes;
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  recordFrameTypes(*connection, frameTypes);
+
+  auto stateMachine = std::make_shared<RSocketStateMachine>(
+      std::make_shared<RSocketResponder>(),
+      nullptr,
+      RSocketMode::CLIENT,
+      nullptr,
+      nullptr,
+      ResumeManager::makeEmpty(),
+      nullptr);
+
+  auto leaseReceiver = std::make_shared<StrictMock<LeaseReceiverMock>>();
+  SetupParameters setupParameters;
+  setupParameters.lease = true;
+  setupParameters.leaseReceiver = leaseReceiver;
+  stateMachine->connectClient(
+      std::make_shared<FrameTransportImpl>(std::move(connection)),
+      std::move(setupParameters));
+
+  auto rejected = std::make_shared<StrictMock<MockSubscriber<Payload>>>();
+  EXPECT_CALL(*rejected, onSubscribe_(_)).Times(4);
+  EXPECT_CALL(*rejected, onError_(_))
+      .Times(4)
+      .WillRepeatedly(Invoke([](folly::exception_wrapper ex) {
+        EXPECT_TRUE(ex.is_compatible_with<RejectedError>());
+      }));
+
+  // No lease yet.
+  stateMachine->requestStream(Payload{}, rejected);
+
+  EXPECT_CALL(*leaseReceiver, onLease(_)).WillOnce(Invoke([](const Lease& l) {
+    EXPECT_EQ(std::chrono::minutes{1}, l.ttl);
+    EXPECT_EQ(2, l.numberOfRequests);
+  }));
+  auto processor = std::dynamic_pointer_cast<FrameProcessor>(stateMachine);
+  FrameSerializerV1_0 serializer;
+  processor->processFrame(serializer.serializeOut(Frame_LEASE(60000, 2)));
+
+  auto accepted = std::make_shared<NiceMock<MockSubscriber<Payload>>>();
+  stateMachine->requestStream(Payload{}, accepted);
+  stateMachine->requestStream(Payload{}, accepted);
+  for (int i = 0; i < 3; ++i) {
+    stateMachine->requestStream(Payload{}, rejected);
+  }
+
+  EXPECT_EQ(
+      2,
+      std::count(
+          frameTypes.begin(), frameTypes.end(), FrameType::REQUEST_STREAM));
+  EXPECT_EQ(2, getStreams(*stateMachine).size());
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
+TEST_F(RSocketStateMachineTest, RecordsLatencies) {
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  EXPECT_CALL(*connection, setInput_(_));
+
+  auto stats = std::make_shared<LatencyStats>();
+  auto stateMachine = std::make_shared<RSocketStateMachine>(
+      std::make_shared<RSocketResponder>(),
+      nullptr,
+      RSocketMode::CLIENT,
+      stats,
+      nullptr,
+      ResumeManager::makeEmpty(),
+      nullptr);
+  stateMachine->connectClient(
+      std::make_shared<FrameTransportImpl>(std::move(connection)),
+      SetupParameters{});
+
+  stateMachine->requestResponse(
+      Payload{}, std::make_shared<SingleObserverBase<Payload>>());
+
+  auto processor = std::dynamic_pointer_cast<FrameProcessor>(stateMachine);
+  FrameSerializerV1_0 serializer;
+  processor->processFrame(serializer.serializeOut(Frame_PAYLOAD(
+      1, FrameFlags::NEXT | FrameFlags::COMPLETE, Payload{"response"})));
+
+  auto const snapshot = stats->snapshot();
+  EXPECT_EQ(1, snapshot.requestResponse.count());
+  EXPECT_EQ(0, snapshot.streamFirstPayload.count());
+  EXPECT_EQ(1, snapshot.frameProcessed(FrameType::PAYLOAD).count());
+  EXPECT_EQ(0, snapshot.frameProcessed(FrameType::ERROR).count());
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
+TEST_F(RSocketStateMachineTest, CoalescesRequestNPerLoop) {
+  folly::EventBase evb;
+  std::vector<FrameType> frameTypes;
+  std::vector<uint32_t> requestNs;
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  ON_CALL(*connection, send_(_))
+      .WillByDefault(Invoke([&](std::unique_ptr<folly::IOBuf>& buf) {
+        FrameSerializerV1_0 serializer;
+        frameTypes.push_back(serializer.peekFrameType(*buf));
+        Frame_REQUEST_N frame;
+        if (frameTypes.back() == FrameType::REQUEST_N &&
+            serializer.deserializeFrom(frame, buf->clone())) {
+          requestNs.push_back(frame.requestN_);
+        }
+      }));
+
+  auto stateMachine = std::make_shared<RSocketStateMachine>(
+      std::make_shared<RSocketResponder>(),
+      nullptr,
+      RSocketMode::CLIENT,
+      nullptr,
+      nullptr,
+      ResumeManager::makeEmpty(),
+      nullptr);
+  RequestNPolicy policy;
+  policy.window = 100;
+  policy.replenishPercent = 100;
+  policy.coalesce = true;
+  stateMachine->setRequestNPolicy(policy, evb);
+  stateMachine->connectClient(
+      std::make_shared<FrameTransportImpl>(std::move(connection)),
+      SetupParameters{});
+
+  auto subscriber = std::make_shared<NiceMock<MockSubscriber<Payload>>>(1);
+  stateMachine->requestStream(Payload{}, subscriber);
+  for (int i = 0; i < 5; ++i) {
+    subscriber->subscription()->request(2);
+  }
+  EXPECT_EQ(
+      (std::vector<FrameType>{FrameType::SETUP, FrameType::REQUEST_STREAM}),
+      frameTypes);
+
+  // All five grants leave as one frame at the end of the loop.
+  evb.loopOnce();
+  EXPECT_EQ(std::vector<uint32_t>{10}, requestNs);
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
 } // namespace rsocket
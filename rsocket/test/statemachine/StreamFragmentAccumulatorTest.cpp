@@ -0,0 +1,145 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+
+#include <folly/io/IOBuf.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/internal/ReassemblyBudget.h"
+#include "rsocket/statemachine/StreamFragmentAccumulator.h"
+
+using namespace rsocket;
+
+namespace {
+
+std::shared_ptr<ReassemblyBudget> makeBudget(
+    size_t maxStreamBytes,
+    size_t maxConnectionBytes) {
+  ReassemblyLimits limits;
+  limits.maxStreamBytes = maxStreamBytes;
+  limits.maxConnectionBytes = maxConnectionBytes;
+  return std::make_shared<ReassemblyBudget>(limits);
+}
+
+/// A fragment whose buffers are exactly as large as its bytes.
+Payload fragment(const char* data, const char* metadata = nullptr) {
+  auto wrap = [](const char* s) {
+    return folly::IOBuf::wrapBuffer(s, std::strlen(s));
+  };
+  return metadata ? Payload(wrap(data), wrap(metadata)) : Payload(wrap(data));
+}
+
+} // namespace
+
+TEST(StreamFragmentAccumulator, ReassemblesWithoutBudget) {
+  StreamFragmentAccumulator accumulator;
+  EXPECT_TRUE(accumulator.addPayload(Payload("ab", "m"), true, false, true));
+  EXPECT_TRUE(accumulator.addPayload(Payload("cd"), false, true, false));
+  EXPECT_EQ(0u, accumulator.heldBytes());
+
+  Payload payload;
+  bool next, complete;
+  std::tie(payload, next, complete) = accumulator.consumePayloadAndFlags();
+  EXPECT_EQ("abcd", payload.moveDataToString());
+  EXPECT_EQ("m", payload.moveMetadataToString());
+  EXPECT_TRUE(next);
+  EXPECT_TRUE(complete);
+}
+
+TEST(StreamFragmentAccumulator, ChainsFragmentsWithoutCopying) {
+  auto first = folly::IOBuf::copyBuffer("abcd");
+  auto const firstData = first->data();
+
+  StreamFragmentAccumulator accumulator;
+  EXPECT_TRUE(
+      accumulator.addPayloadIgnoreFlags(Payload(std::move(first)), true));
+  for (int i = 1; i < 100; ++i) {
+    EXPECT_TRUE(accumulator.addPayloadIgnoreFlags(Payload("abcd"), i < 99));
+  }
+
+  auto payload = accumulator.consumePayloadIgnoreFlags();
+  EXPECT_EQ(firstData, payload.data->data());
+  EXPECT_EQ(100u, payload.data->countChainElements());
+  EXPECT_EQ(400u, payload.data->computeChainDataLength());
+}
+
+TEST(StreamFragmentAccumulator, ChargesTheBuffersFragmentsKeepAlive) {
+  auto budget = makeBudget(100, 0);
+  StreamFragmentAccumulator accumulator(budget);
+
+  // Three bytes of a 1000 byte read buffer pin all of it.
+  auto buffer = folly::IOBuf::create(1000);
+  buffer->append(3);
+  EXPECT_FALSE(
+      accumulator.addPayloadIgnoreFlags(Payload(std::move(buffer)), true));
+  EXPECT_EQ(0u, budget->reserved());
+
+  EXPECT_TRUE(accumulator.addPayloadIgnoreFlags(fragment("abc"), true));
+  EXPECT_EQ(3u, budget->reserved());
+}
+
+TEST(StreamFragmentAccumulator, CountsOnlyHeldFragments) {
+  auto budget = makeBudget(4, 0);
+  StreamFragmentAccumulator accumulator(budget);
+
+  // A payload in a single frame is never held, whatever its size.
+  EXPECT_TRUE(accumulator.addPayloadIgnoreFlags(fragment("abcdef"), false));
+  EXPECT_EQ(0u, budget->reserved());
+  accumulator.consumePayloadIgnoreFlags();
+
+  EXPECT_TRUE(accumulator.addPayloadIgnoreFlags(fragment("ab", "c"), true));
+  EXPECT_EQ(3u, accumulator.heldBytes());
+  EXPECT_EQ(3u, budget->reserved());
+
+  // The last fragment is handed over at once, so it does not count.
+  EXPECT_TRUE(accumulator.addPayloadIgnoreFlags(fragment("defgh"), false));
+  EXPECT_EQ("abdefgh", accumulator.consumePayloadIgnoreFlags()
+                           .moveDataToString());
+  EXPECT_EQ(0u, accumulator.heldBytes());
+  EXPECT_EQ(0u, budget->reserved());
+}
+
+TEST(StreamFragmentAccumulator, RefusesFragmentsPastStreamLimit) {
+  auto budget = makeBudget(4, 0);
+  StreamFragmentAccumulator accumulator(budget);
+
+  EXPECT_TRUE(accumulator.addPayload(fragment("abc"), true, false, true));
+  EXPECT_FALSE(accumulator.addPayload(fragment("de"), true, false, true));
+
+  // Everything held so far was dropped.
+  EXPECT_FALSE(accumulator.anyFragments());
+  EXPECT_EQ(0u, accumulator.heldBytes());
+  EXPECT_EQ(0u, budget->reserved());
+}
+
+TEST(StreamFragmentAccumulator, SharesConnectionLimitAcrossStreams) {
+  auto budget = makeBudget(0, 5);
+  StreamFragmentAccumulator first(budget);
+  {
+    StreamFragmentAccumulator second(budget);
+
+    EXPECT_TRUE(first.addPayloadIgnoreFlags(fragment("abc"), true));
+    EXPECT_TRUE(second.addPayloadIgnoreFlags(fragment("de"), true));
+    EXPECT_EQ(5u, budget->reserved());
+
+    EXPECT_FALSE(first.addPayloadIgnoreFlags(fragment("f"), true));
+    EXPECT_EQ(2u, budget->reserved());
+  }
+
+  // A destroyed stream gives its bytes back.
+  EXPECT_EQ(0u, budget->reserved());
+  EXPECT_TRUE(first.addPayloadIgnoreFlags(fragment("fghij"), true));
+  EXPECT_EQ(5u, budget->reserved());
+}
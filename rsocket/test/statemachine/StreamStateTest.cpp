@@ -16,8 +16,11 @@
 #include <gtest/gtest.h>
 #include <yarpl/test_utils/Mocks.h>
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/ReassemblyBudget.h"
 #include "rsocket/statemachine/ChannelRequester.h"
 #include "rsocket/statemachine/ChannelResponder.h"
+#include "rsocket/statemachine/StreamRequester.h"
+#include "rsocket/statemachine/StreamResponder.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
 #include "rsocket/test/test_utils/MockStreamsWriter.h"
 
@@ -330,3 +333,87 @@ TEST(StreamState, ChannelResponderHandleCancel) {
   auto consumerSubscription = mockSubscriber->subscription();
   consumerSubscription->cancel();
 }
+
+TEST(StreamState, StreamRequesterBatchesCreditsInWindow) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  RequestNPolicy policy;
+  policy.window = 8;
+  policy.replenishPercent = 25;
+  writer->setRequestNPolicy(policy);
+
+  auto requester = std::make_shared<StreamRequester>(writer, 1u, Payload());
+
+  // The stream opens with a full window, not with all of the demand.
+  EXPECT_CALL(*writer, writeNewStream_(1u, StreamType::STREAM, 8u, _));
+  auto mockSubscriber =
+      std::make_shared<StrictMock<MockSubscriber<rsocket::Payload>>>(100);
+  EXPECT_CALL(*mockSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*mockSubscriber, onNext_(_)).Times(6);
+  requester->subscribe(mockSubscriber);
+
+  // Nothing is granted until the peer holds only a quarter of the window, and
+  // then it is topped back up in a single frame.
+  EXPECT_CALL(*writer, writeRequestN_(Field(&Frame_REQUEST_N::requestN_, 6u)));
+  for (int i = 0; i < 6; ++i) {
+    requester->handlePayload(Payload("x"), false, true, false);
+  }
+  EXPECT_EQ(94u, requester->getConsumerAllowance());
+
+  EXPECT_CALL(*writer, writeCancel_(_));
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+  mockSubscriber->subscription()->cancel();
+}
+
+TEST(StreamState, StreamRequesterFailsPastReassemblyLimit) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  ReassemblyLimits limits;
+  limits.maxStreamBytes = 4;
+  auto budget = std::make_shared<ReassemblyBudget>(limits);
+  writer->setReassemblyBudget(budget);
+
+  auto requester = std::make_shared<StreamRequester>(writer, 1u, Payload());
+
+  EXPECT_CALL(*writer, writeNewStream_(1u, StreamType::STREAM, _, _));
+  auto mockSubscriber =
+      std::make_shared<StrictMock<MockSubscriber<rsocket::Payload>>>(100);
+  EXPECT_CALL(*mockSubscriber, onSubscribe_(_));
+  requester->subscribe(mockSubscriber);
+
+  // Fragments are charged their buffers' capacity, so wrap exact-size ones.
+  requester->handlePayload(
+      Payload(folly::IOBuf::wrapBuffer("abc", 3)), false, true, true);
+  EXPECT_EQ(3u, budget->reserved());
+
+  // The fragment that would go past the limit fails the stream on both ends
+  // and frees what it held.
+  EXPECT_CALL(*writer, writeError_(_));
+  EXPECT_CALL(*mockSubscriber, onError_(_));
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+  requester->handlePayload(
+      Payload(folly::IOBuf::wrapBuffer("de", 2)), false, true, true);
+  EXPECT_EQ(0u, budget->reserved());
+  EXPECT_TRUE(requester->consumerClosed());
+}
+
+TEST(StreamState, StreamResponderHoldsRequestsWhileWriteBlocked) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  writer->setWriteBlocked(true);
+  auto responder = std::make_shared<StreamResponder>(writer, 1u, 4u);
+
+  // Neither the initial request nor later ones reach the producer while the
+  // connection is not taking writes.
+  auto subscription = std::make_shared<StrictMock<MockSubscription>>();
+  responder->onSubscribe(subscription);
+  responder->handleRequestN(3);
+
+  writer->setWriteBlocked(false);
+  EXPECT_CALL(*subscription, request_(7));
+  responder->handleWritable();
+
+  EXPECT_CALL(*subscription, request_(2));
+  responder->handleRequestN(2);
+
+  EXPECT_CALL(*subscription, cancel_());
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+  responder->handleCancel();
+}
@@ -85,3 +85,28 @@ TEST(StreamsWriterTest, FlushQueuedFrames) {
   // it will not send the pending frames twice
   impl.sendPendingFrames();
 }
+
+TEST(StreamsWriterTest, CancelWaitsBehindScheduledRequest) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->shouldSchedule_ = true;
+
+  std::vector<FrameType> written;
+  EXPECT_CALL(*writer, outputFrame_(_))
+      .WillRepeatedly(Invoke([&](folly::IOBuf* frame) {
+        written.push_back(writer->frameSerializer.peekFrameType(*frame));
+      }));
+
+  // The request is still waiting in the scheduler when the stream is asked
+  // for more and then cancelled.
+  writer->writeNewStream(1, StreamType::STREAM, 5, Payload("request"));
+  writer->writeRequestN(Frame_REQUEST_N(1, 10));
+  writer->writeCancel(Frame_CANCEL(1));
+  EXPECT_TRUE(written.empty());
+
+  writer->shouldSchedule_ = false;
+  writer->flushScheduledFrames();
+  EXPECT_EQ(
+      (std::vector<FrameType>{
+          FrameType::REQUEST_STREAM, FrameType::REQUEST_N, FrameType::CANCEL}),
+      written);
+}
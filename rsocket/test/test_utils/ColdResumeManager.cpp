@@ -64,8 +64,9 @@ ColdResumeManager::ColdResumeManager(
       throw std::runtime_error("Invalid file content.  Keys Missing");
     }
 
+    // The cached frames are added back from the first sent position on.
     firstSentPosition_ = state[FIRST_SENT_POSITION].getInt();
-    lastSentPosition_ = state[LAST_SENT_POSITION].getInt();
+    lastSentPosition_ = firstSentPosition_;
     impliedPosition_ = state[IMPLIED_POSITION].getInt();
     largestUsedStreamId_ = state[LARGEST_USED_STREAMID].getInt();
 
@@ -106,9 +107,16 @@ ColdResumeManager::ColdResumeManager(
       auto ioBuf = folly::IOBuf::copyBuffer(
           item.values().begin()->getString().c_str(),
           item.values().begin()->getString().size());
-      frames_.emplace_back(
-          folly::to<int64_t>(item.keys().begin()->getString()),
-          std::move(ioBuf));
+      if (folly::to<int64_t>(item.keys().begin()->getString()) !=
+          lastSentPosition_) {
+        throw std::runtime_error("Invalid file content.  Frames not in order");
+      }
+      addFrame(*ioBuf, ioBuf->length());
+      lastSentPosition_ += ioBuf->length();
+    }
+
+    if (lastSentPosition_ != state[LAST_SENT_POSITION].getInt()) {
+      throw std::runtime_error("Invalid file content.  Frames missing");
     }
   } catch (const std::exception& ex) {
     throw std::runtime_error(
@@ -140,7 +148,7 @@ void ColdResumeManager::persistState(std::string outputFile) {
           folly::to<std::string>(streamResumeInfo.first), val);
     }
     state[FRAMES] = folly::dynamic::array();
-    for (const auto& frame : frames_) {
+    for (const auto& frame : copyFrames(firstSentPosition_)) {
       state[FRAMES].push_back(folly::dynamic::object(
           folly::to<std::string>(frame.first),
           frame.second->moveToFbString().toStdString()));
@@ -44,11 +44,25 @@ class MockDuplexConnection : public DuplexConnection {
     send_(buf);
   }
 
+  void setWritabilityCallback(std::function<void(bool)> callback) override {
+    writabilityCallback_ = std::move(callback);
+  }
+
+  /// Reports the connection crossing one of its write buffer water marks.
+  void setWritable(bool writable) {
+    if (auto callback = writabilityCallback_) {
+      callback(writable);
+    }
+  }
+
   // Mocks.
 
   MOCK_METHOD1(setInput_, void(std::shared_ptr<Subscriber>));
   MOCK_METHOD1(send_, void(std::unique_ptr<folly::IOBuf>&));
   MOCK_CONST_METHOD0(isFramed, bool());
+
+ private:
+  std::function<void(bool)> writabilityCallback_;
 };
 
 } // namespace rsocket
@@ -0,0 +1,40 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gmock/gmock.h>
+
+#include <folly/io/IOBuf.h>
+
+#include "rsocket/framing/FrameTransportImpl.h"
+#include "rsocket/test/test_utils/MockDuplexConnection.h"
+
+namespace rsocket {
+
+/// FrameTransportImpl over a mock connection, with the frames it outputs
+/// captured by a mock method.
+class MockFrameTransport : public FrameTransportImpl {
+ public:
+  MockFrameTransport()
+      : FrameTransportImpl(std::make_unique<MockDuplexConnection>()) {}
+
+  void outputFrameOrDrop(std::unique_ptr<folly::IOBuf> frame) override {
+    outputFrameOrDrop_(frame);
+  }
+
+  MOCK_METHOD1(outputFrameOrDrop_, void(std::unique_ptr<folly::IOBuf>&));
+};
+
+} // namespace rsocket
@@ -65,9 +65,15 @@ class MockStreamsWriterImpl : public StreamsWriterImpl {
     // ignoring...
   }
 
+  bool shouldSchedule() override {
+    return shouldSchedule_;
+  }
+
+  using StreamsWriterImpl::flushScheduledFrames;
   using StreamsWriterImpl::sendPendingFrames;
 
   bool shouldQueue_{false};
+  bool shouldSchedule_{false};
   std::shared_ptr<RSocketStats> stats_ = RSocketStats::noop();
   FrameSerializerV1_0 frameSerializer;
 };
@@ -144,9 +150,40 @@ class MockStreamsWriter : public StreamsWriter {
     // ignoring...
   }
 
+  RSocketStats& stats() override {
+    return impl_.stats();
+  }
+
+  const RequestNPolicy& requestNPolicy() const override {
+    return requestNPolicy_;
+  }
+
+  void setRequestNPolicy(RequestNPolicy policy) {
+    requestNPolicy_ = policy;
+  }
+
+  std::shared_ptr<ReassemblyBudget> reassemblyBudget() const override {
+    return reassemblyBudget_;
+  }
+
+  void setReassemblyBudget(std::shared_ptr<ReassemblyBudget> budget) {
+    reassemblyBudget_ = std::move(budget);
+  }
+
+  bool deferUntilWritable(StreamId) override {
+    return writeBlocked_;
+  }
+
+  void setWriteBlocked(bool blocked) {
+    writeBlocked_ = blocked;
+  }
+
  protected:
   MockStreamsWriterImpl impl_;
   bool delegateToImpl_{false};
+  RequestNPolicy requestNPolicy_;
+  std::shared_ptr<ReassemblyBudget> reassemblyBudget_;
+  bool writeBlocked_{false};
 };
 
 } // namespace rsocket
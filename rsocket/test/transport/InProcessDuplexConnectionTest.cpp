@@ -0,0 +1,185 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/inprocess/InProcessConnectionAcceptor.h"
+#include "rsocket/transports/inprocess/InProcessConnectionFactory.h"
+#include "yarpl/test_utils/Mocks.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+using namespace ::testing;
+
+namespace {
+
+std::string acceptorName() {
+  static int counter = 0;
+  return folly::sformat("rsocket-test-{}", counter++);
+}
+
+/**
+ * Synchronously create a server and a client.
+ */
+std::pair<
+    std::unique_ptr<ConnectionAcceptor>,
+    std::unique_ptr<ConnectionFactory>>
+makeSingleClientServer(
+    std::unique_ptr<DuplexConnection>& serverConnection,
+    EventBase** serverEvb,
+    std::unique_ptr<DuplexConnection>& clientConnection,
+    EventBase* clientEvb) {
+  Promise<Unit> serverPromise;
+
+  InProcessConnectionAcceptor::Options options;
+  options.name = acceptorName();
+  options.threads = 1;
+
+  auto server = std::make_unique<InProcessConnectionAcceptor>(options);
+  server->start(
+      [&serverPromise, &serverConnection, &serverEvb](
+          std::unique_ptr<DuplexConnection> connection, EventBase& eventBase) {
+        serverConnection = std::move(connection);
+        *serverEvb = &eventBase;
+        serverPromise.setValue();
+      });
+
+  EXPECT_FALSE(server->listeningPort());
+
+  auto client =
+      std::make_unique<InProcessConnectionFactory>(*clientEvb, options.name);
+  client->connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+      .thenValue([&clientConnection](
+                     ConnectionFactory::ConnectedDuplexConnection connection) {
+        clientConnection = std::move(connection.connection);
+      })
+      .wait();
+
+  serverPromise.getSemiFuture().wait();
+  return std::make_pair(std::move(server), std::move(client));
+}
+
+} // namespace
+
+TEST(InProcessDuplexConnection, IsFramed) {
+  EventBase evb;
+  auto connections = InProcessDuplexConnection::createPair(evb, evb);
+  EXPECT_TRUE(connections.first->isFramed());
+  EXPECT_TRUE(connections.second->isFramed());
+}
+
+TEST(InProcessDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(InProcessDuplexConnection, InputAndOutputIsUntied) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(InProcessDuplexConnection, ConnectionAndSubscribersAreUntied) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  verifyClosingInputAndOutputDoesntCloseConnection(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(InProcessDuplexConnection, FramesSentBeforeSetInputAreKept) {
+  constexpr int kFrames = 100;
+  folly::ScopedEventBaseThread serverWorker;
+  folly::ScopedEventBaseThread clientWorker;
+  auto* serverEvb = serverWorker.getEventBase();
+  auto* clientEvb = clientWorker.getEventBase();
+  auto connections =
+      InProcessDuplexConnection::createPair(*clientEvb, *serverEvb);
+
+  auto subscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onNext_(_)).Times(kFrames);
+  EXPECT_CALL(*subscriber, onComplete_());
+
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    for (int i = 0; i < kFrames; ++i) {
+      connections.first->send(folly::IOBuf::copyBuffer("0123456"));
+    }
+    connections.first.reset();
+  });
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { connections.second->setInput(subscriber); });
+  subscriber->awaitTerminalEvent();
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { connections.second.reset(); });
+}
+
+TEST(InProcessDuplexConnection, ConnectWithoutAcceptorFails) {
+  folly::ScopedEventBaseThread worker;
+  InProcessConnectionFactory client{*worker.getEventBase(), acceptorName()};
+  EXPECT_THROW(
+      client.connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION).get(),
+      std::runtime_error);
+}
+
+TEST(InProcessDuplexConnection, NameIsReleasedOnStop) {
+  InProcessConnectionAcceptor::Options options;
+  options.name = acceptorName();
+  options.threads = 1;
+
+  InProcessConnectionAcceptor first{options};
+  first.start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+
+  InProcessConnectionAcceptor second{options};
+  EXPECT_THROW(
+      second.start([](std::unique_ptr<DuplexConnection>, EventBase&) {}),
+      std::runtime_error);
+
+  first.stop();
+
+  InProcessConnectionAcceptor third{options};
+  third.start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+}
+
+} // namespace tests
+} // namespace rsocket
@@ -0,0 +1,341 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
+#include "yarpl/test_utils/Mocks.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+using namespace ::testing;
+
+namespace {
+
+/// Create a connection on the thread of the EventBase it will run on.
+std::unique_ptr<DuplexConnection> makeConnection(
+    ShmDuplexConnection::Endpoint endpoint,
+    EventBase* evb) {
+  std::unique_ptr<DuplexConnection> connection;
+  evb->runInEventBaseThreadAndWait([&] {
+    connection =
+        std::make_unique<ShmDuplexConnection>(std::move(endpoint), *evb);
+  });
+  return connection;
+}
+
+struct ShmConnections {
+  ScopedEventBaseThread serverWorker;
+  ScopedEventBaseThread clientWorker;
+  std::unique_ptr<DuplexConnection> serverConnection;
+  std::unique_ptr<DuplexConnection> clientConnection;
+
+  explicit ShmConnections(size_t ringCapacity = 1 << 16) {
+    auto endpoints = ShmDuplexConnection::createChannel(ringCapacity);
+    clientConnection = makeConnection(
+        std::move(endpoints.first), clientWorker.getEventBase());
+    serverConnection = makeConnection(
+        std::move(endpoints.second), serverWorker.getEventBase());
+  }
+};
+
+} // namespace
+
+TEST(ShmDuplexConnection, IsFramed) {
+  ShmConnections connections;
+  EXPECT_TRUE(connections.clientConnection->isFramed());
+  connections.clientWorker.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(connections.clientConnection)] {});
+  connections.serverWorker.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(connections.serverConnection)] {});
+}
+
+TEST(ShmDuplexConnection, MultipleSetInputGetOutputCalls) {
+  ShmConnections connections;
+  makeMultipleSetInputGetOutputCalls(
+      std::move(connections.serverConnection),
+      connections.serverWorker.getEventBase(),
+      std::move(connections.clientConnection),
+      connections.clientWorker.getEventBase());
+}
+
+TEST(ShmDuplexConnection, InputAndOutputIsUntied) {
+  ShmConnections connections;
+  verifyInputAndOutputIsUntied(
+      std::move(connections.serverConnection),
+      connections.serverWorker.getEventBase(),
+      std::move(connections.clientConnection),
+      connections.clientWorker.getEventBase());
+}
+
+TEST(ShmDuplexConnection, ConnectionAndSubscribersAreUntied) {
+  ShmConnections connections;
+  verifyClosingInputAndOutputDoesntCloseConnection(
+      std::move(connections.serverConnection),
+      connections.serverWorker.getEventBase(),
+      std::move(connections.clientConnection),
+      connections.clientWorker.getEventBase());
+}
+
+TEST(ShmDuplexConnection, FillsAndDrainsSmallRing) {
+  constexpr int kFrames = 1000;
+  ShmConnections connections{256};
+  auto* serverEvb = connections.serverWorker.getEventBase();
+  auto* clientEvb = connections.clientWorker.getEventBase();
+
+  auto subscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onNext_(_)).Times(kFrames);
+
+  // Sent before anybody reads, so most frames queue up behind a full ring.
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    for (int i = 0; i < kFrames; ++i) {
+      connections.clientConnection->send(
+          folly::IOBuf::copyBuffer(std::string(100, 'a')));
+    }
+  });
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { connections.serverConnection->setInput(subscriber); });
+  subscriber->awaitFrames(kFrames);
+
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    subscriber->subscription()->cancel();
+    connections.serverConnection.reset();
+  });
+  clientEvb->runInEventBaseThreadAndWait(
+      [&] { connections.clientConnection.reset(); });
+}
+
+TEST(ShmDuplexConnection, PeerCloseCompletesInput) {
+  ShmConnections connections;
+  auto* serverEvb = connections.serverWorker.getEventBase();
+  auto* clientEvb = connections.clientWorker.getEventBase();
+
+  auto subscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onComplete_());
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { connections.serverConnection->setInput(subscriber); });
+  clientEvb->runInEventBaseThreadAndWait(
+      [&] { connections.clientConnection.reset(); });
+  subscriber->awaitTerminalEvent();
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { connections.serverConnection.reset(); });
+}
+
+TEST(ShmDuplexConnection, CloseDrainsFramesQueuedBehindFullRing) {
+  constexpr int kFrames = 100;
+  ShmConnections connections{256};
+  auto* serverEvb = connections.serverWorker.getEventBase();
+  auto* clientEvb = connections.clientWorker.getEventBase();
+
+  auto subscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onNext_(_)).Times(kFrames);
+  EXPECT_CALL(*subscriber, onComplete_());
+
+  // Nobody is reading yet, so closing leaves most frames queued behind a
+  // full ring.
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    for (int i = 0; i < kFrames; ++i) {
+      connections.clientConnection->send(
+          folly::IOBuf::copyBuffer(std::string(100, 'a')));
+    }
+    connections.clientConnection.reset();
+  });
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { connections.serverConnection->setInput(subscriber); });
+  subscriber->awaitTerminalEvent();
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { connections.serverConnection.reset(); });
+}
+
+TEST(ShmDuplexConnection, CloseLetsGoOnceQueueDrains) {
+  constexpr int kFrames = 10;
+  EventBase evb;
+  auto endpoints = ShmDuplexConnection::createChannel(256);
+  auto client =
+      std::make_unique<ShmDuplexConnection>(std::move(endpoints.first), evb);
+  auto server =
+      std::make_unique<ShmDuplexConnection>(std::move(endpoints.second), evb);
+
+  int received = 0;
+  bool completed = false;
+  server->setInput(
+      yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>::create(
+          [&](std::unique_ptr<folly::IOBuf>) { ++received; },
+          [](folly::exception_wrapper ew) { FAIL() << ew.what(); },
+          [&] {
+            completed = true;
+            evb.runInLoop([&] { server.reset(); });
+          }));
+
+  // The ring holds two of these frames; the rest queue up behind it.
+  for (int i = 0; i < kFrames; ++i) {
+    client->send(folly::IOBuf::copyBuffer(std::string(100, 'a')));
+  }
+  client.reset();
+
+  // loop() returns once nothing is left to wait for.  Nothing must keep the
+  // closed client around once its queue has drained, so this takes far less
+  // than the drain timeout of a peer that stopped reading.
+  auto const start = std::chrono::steady_clock::now();
+  evb.loop();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{1});
+  EXPECT_EQ(kFrames, received);
+  EXPECT_TRUE(completed);
+}
+
+TEST(ShmDuplexConnection, PeerThatGoesAwayErrorsInput) {
+  auto endpoints = ShmDuplexConnection::createChannel(1 << 12);
+
+  // The peer process writes a frame into the ring and exits without closing
+  // the connection, as if it had crashed.
+  auto const pid = ::fork();
+  ASSERT_LE(0, pid);
+  if (pid == 0) {
+    EventBase peerEvb;
+    ShmDuplexConnection peer{std::move(endpoints.second), peerEvb};
+    peer.send(folly::IOBuf::copyBuffer("last words"));
+    ::_exit(0);
+  }
+  endpoints.second = ShmDuplexConnection::Endpoint();
+  int status;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+
+  auto subscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onNext_(_));
+  EXPECT_CALL(*subscriber, onError_(_));
+
+  ScopedEventBaseThread worker;
+  auto* evb = worker.getEventBase();
+  auto connection = makeConnection(std::move(endpoints.first), evb);
+  evb->runInEventBaseThreadAndWait([&] { connection->setInput(subscriber); });
+  subscriber->awaitTerminalEvent();
+
+  evb->runInEventBaseThreadAndWait([&] { connection.reset(); });
+}
+
+TEST(ShmDuplexConnection, WritabilityFollowsWaterMarks) {
+  ScopedEventBaseThread serverWorker;
+  ScopedEventBaseThread clientWorker;
+  auto* serverEvb = serverWorker.getEventBase();
+  auto* clientEvb = clientWorker.getEventBase();
+  auto endpoints = ShmDuplexConnection::createChannel(256);
+
+  ShmDuplexConnection::Options options;
+  options.writeHighWaterMark = 250;
+  options.writeLowWaterMark = 0;
+
+  std::unique_ptr<DuplexConnection> client, server;
+  std::vector<bool> changes;
+  folly::Baton<> unwritable, writable;
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    client = std::make_unique<ShmDuplexConnection>(
+        std::move(endpoints.first), *clientEvb, RSocketStats::noop(), options);
+    client->setWritabilityCallback([&](bool isWritable) {
+      changes.push_back(isWritable);
+      (isWritable ? writable : unwritable).post();
+    });
+    // Two frames fit in the ring; the next three queue up and cross the
+    // high water mark.
+    for (int i = 0; i < 5; ++i) {
+      client->send(folly::IOBuf::copyBuffer(std::string(100, 'a')));
+    }
+    EXPECT_TRUE(changes.empty());
+  });
+  ASSERT_TRUE(unwritable.try_wait_for(std::chrono::seconds{5}));
+
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    server = std::make_unique<ShmDuplexConnection>(
+        std::move(endpoints.second), *serverEvb);
+    server->setInput(
+        yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>::create(
+            [](std::unique_ptr<folly::IOBuf>) {}));
+  });
+  ASSERT_TRUE(writable.try_wait_for(std::chrono::seconds{5}));
+
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    EXPECT_EQ((std::vector<bool>{false, true}), changes);
+    client.reset();
+  });
+  serverEvb->runInEventBaseThreadAndWait([&] { server.reset(); });
+}
+
+TEST(ShmDuplexConnection, OversizedFrameErrorsInput) {
+  ShmConnections connections{256};
+  auto* clientEvb = connections.clientWorker.getEventBase();
+
+  auto subscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onError_(_));
+
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    connections.clientConnection->setInput(subscriber);
+    connections.clientConnection->send(
+        folly::IOBuf::copyBuffer(std::string(1024, 'a')));
+  });
+  subscriber->awaitTerminalEvent();
+
+  clientEvb->runInEventBaseThreadAndWait(
+      [&] { connections.clientConnection.reset(); });
+  connections.serverWorker.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { connections.serverConnection.reset(); });
+}
+
+TEST(ShmDuplexConnection, EndpointOverUnixSocket) {
+  int sockets[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+  folly::File sender{sockets[0], true};
+  folly::File receiver{sockets[1], true};
+
+  auto endpoints = ShmDuplexConnection::createChannel(1 << 12);
+  ShmDuplexConnection::sendEndpoint(sender.fd(), endpoints.second);
+  auto received = ShmDuplexConnection::receiveEndpoint(receiver.fd());
+  EXPECT_FALSE(received.initiator);
+  endpoints.second = ShmDuplexConnection::Endpoint();
+
+  ScopedEventBaseThread serverWorker;
+  ScopedEventBaseThread clientWorker;
+  verifyInputAndOutputIsUntied(
+      makeConnection(std::move(received), serverWorker.getEventBase()),
+      serverWorker.getEventBase(),
+      makeConnection(std::move(endpoints.first), clientWorker.getEventBase()),
+      clientWorker.getEventBase());
+}
+
+} // namespace tests
+} // namespace rsocket
@@ -0,0 +1,177 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "rsocket/transports/shm/ShmRingBuffer.h"
+
+using namespace rsocket;
+
+namespace {
+
+struct FreeDeleter {
+  void operator()(void* p) const {
+    std::free(p);
+  }
+};
+
+using Region = std::unique_ptr<void, FreeDeleter>;
+
+Region makeRegion(size_t capacity) {
+  void* region = nullptr;
+  CHECK_EQ(
+      0, ::posix_memalign(&region, 64, ShmRingBuffer::regionSize(capacity)));
+  return Region{region};
+}
+
+std::string toString(const folly::IOBuf& buf) {
+  std::string str;
+  for (const auto range : buf) {
+    str.append(reinterpret_cast<const char*>(range.data()), range.size());
+  }
+  return str;
+}
+
+} // namespace
+
+TEST(ShmRingBuffer, PreservesFrameBoundaries) {
+  auto region = makeRegion(1024);
+  auto ring = ShmRingBuffer::create(region.get(), 1024);
+
+  auto chained = folly::IOBuf::copyBuffer(std::string("hello "));
+  chained->prependChain(folly::IOBuf::copyBuffer(std::string("world")));
+
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(std::string("a"))));
+  EXPECT_TRUE(ring.tryWrite(*chained));
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::create(0)));
+
+  auto first = ring.tryRead();
+  ASSERT_TRUE(first);
+  EXPECT_EQ("a", toString(*first));
+  auto second = ring.tryRead();
+  ASSERT_TRUE(second);
+  EXPECT_EQ("hello world", toString(*second));
+  auto third = ring.tryRead();
+  ASSERT_TRUE(third);
+  EXPECT_EQ(0u, third->computeChainDataLength());
+  EXPECT_FALSE(ring.tryRead());
+}
+
+TEST(ShmRingBuffer, WrapsAround) {
+  auto region = makeRegion(64);
+  auto ring = ShmRingBuffer::create(region.get(), 64);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    const std::string data(i % 37, static_cast<char>('a' + i % 26));
+    ASSERT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(data)));
+    auto frame = ring.tryRead();
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(data, toString(*frame));
+  }
+}
+
+TEST(ShmRingBuffer, FullRingWakesProducerOnRead) {
+  auto region = makeRegion(64);
+  auto ring = ShmRingBuffer::create(region.get(), 64);
+  const std::string data(20, 'x');
+
+  // Each 20 byte frame takes 24 bytes of the ring.
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(data)));
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(data)));
+  EXPECT_FALSE(ring.tryWrite(*folly::IOBuf::copyBuffer(data)));
+  EXPECT_TRUE(ring.waitForSpace(data.size()));
+
+  EXPECT_TRUE(ring.tryRead());
+  EXPECT_TRUE(ring.producerNeedsWakeup());
+  EXPECT_FALSE(ring.producerNeedsWakeup());
+  EXPECT_FALSE(ring.waitForSpace(data.size()));
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(data)));
+}
+
+TEST(ShmRingBuffer, WakesConsumerOnlyWhenWaiting) {
+  auto region = makeRegion(1024);
+  auto ring = ShmRingBuffer::create(region.get(), 1024);
+
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(std::string("a"))));
+  EXPECT_FALSE(ring.consumerNeedsWakeup());
+  EXPECT_FALSE(ring.waitForData());
+
+  EXPECT_TRUE(ring.tryRead());
+  EXPECT_TRUE(ring.waitForData());
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(std::string("b"))));
+  EXPECT_TRUE(ring.consumerNeedsWakeup());
+  EXPECT_FALSE(ring.consumerNeedsWakeup());
+}
+
+TEST(ShmRingBuffer, ClosedOnceDrained) {
+  auto region = makeRegion(1024);
+  auto ring = ShmRingBuffer::create(region.get(), 1024);
+
+  EXPECT_TRUE(ring.tryWrite(*folly::IOBuf::copyBuffer(std::string("a"))));
+  ring.close();
+  EXPECT_FALSE(ring.isClosed());
+  EXPECT_FALSE(ring.waitForData());
+  EXPECT_TRUE(ring.tryRead());
+  EXPECT_TRUE(ring.isClosed());
+}
+
+TEST(ShmRingBuffer, AttachSharesState) {
+  auto region = makeRegion(1024);
+  auto producer = ShmRingBuffer::create(region.get(), 1024);
+  auto consumer = ShmRingBuffer::attach(region.get());
+
+  EXPECT_TRUE(producer.tryWrite(*folly::IOBuf::copyBuffer(std::string("a"))));
+  auto frame = consumer.tryRead();
+  ASSERT_TRUE(frame);
+  EXPECT_EQ("a", toString(*frame));
+}
+
+TEST(ShmRingBuffer, AttachRejectsUninitializedMemory) {
+  auto region = makeRegion(1024);
+  std::memset(region.get(), 0, ShmRingBuffer::regionSize(1024));
+  EXPECT_THROW(ShmRingBuffer::attach(region.get()), std::runtime_error);
+}
+
+TEST(ShmRingBuffer, ProducerAndConsumerThreads) {
+  constexpr size_t kFrames = 100000;
+  auto region = makeRegion(4096);
+  auto producer = ShmRingBuffer::create(region.get(), 4096);
+  auto consumer = ShmRingBuffer::attach(region.get());
+
+  std::thread thread{[&] {
+    for (size_t i = 0; i < kFrames; ++i) {
+      auto frame = folly::IOBuf::copyBuffer(std::to_string(i));
+      while (!producer.tryWrite(*frame)) {
+        std::this_thread::yield();
+      }
+    }
+    producer.close();
+  }};
+
+  size_t next = 0;
+  while (!consumer.isClosed()) {
+    if (auto frame = consumer.tryRead()) {
+      ASSERT_EQ(std::to_string(next), toString(*frame));
+      ++next;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  thread.join();
+  EXPECT_EQ(kFrames, next);
+}
@@ -16,8 +16,17 @@
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/io/async/ssl/SSLErrors.h>
+#include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
 
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+#include "rsocket/internal/IOBufPool.h"
 #include "rsocket/test/transport/DuplexConnectionTest.h"
 #include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
 #include "rsocket/transports/tcp/TcpConnectionFactory.h"
@@ -39,13 +48,16 @@ makeSingleClientServer(
     std::unique_ptr<DuplexConnection>& serverConnection,
     EventBase** serverEvb,
     std::unique_ptr<DuplexConnection>& clientConnection,
-    EventBase* clientEvb) {
+    EventBase* clientEvb,
+    TcpDuplexConnection::Options connectionOptions =
+        TcpDuplexConnection::Options()) {
   Promise<Unit> serverPromise;
 
   TcpConnectionAcceptor::Options options;
   options.address = folly::SocketAddress{"::", 0};
   options.threads = 1;
   options.backlog = 0;
+  options.connection = connectionOptions;
 
   auto server = std::make_unique<TcpConnectionAcceptor>(std::move(options));
   server->start(
@@ -59,7 +71,10 @@ makeSingleClientServer(
   int16_t port = server->listeningPort().value();
 
   auto client = std::make_unique<TcpConnectionFactory>(
-      *clientEvb, SocketAddress("localhost", port, true));
+      *clientEvb,
+      SocketAddress("localhost", port, true),
+      nullptr,
+      connectionOptions);
   client->connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
       .thenValue([&clientConnection](
                      ConnectionFactory::ConnectedDuplexConnection connection) {
@@ -84,6 +99,105 @@ TEST(TcpDuplexConnection, MultipleSetInputGetOutputCalls) {
       worker.getEventBase());
 }
 
+TEST(TcpDuplexConnection, BatchedWritesMultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  TcpDuplexConnection::Options connectionOptions;
+  connectionOptions.batchWrites = true;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase(),
+      connectionOptions);
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+namespace {
+
+/// AsyncSocket counting the writes handed to it.
+class CountingSocket : public folly::AsyncSocket {
+ public:
+  using folly::AsyncSocket::AsyncSocket;
+
+  void writeChain(
+      WriteCallback* callback,
+      std::unique_ptr<folly::IOBuf>&& buf,
+      folly::WriteFlags flags) override {
+    ++writes;
+    folly::AsyncSocket::writeChain(callback, std::move(buf), flags);
+  }
+
+  size_t writes{0};
+};
+
+/// Sends `frames` frames in one loop iteration over a socketpair, and returns
+/// how many socket writes they took.
+size_t countWrites(TcpDuplexConnection::Options options, size_t frames) {
+  int fds[2];
+  EXPECT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+  folly::ScopedEventBaseThread worker;
+  auto* evb = worker.getEventBase();
+  CountingSocket* socket = nullptr;
+  std::unique_ptr<DuplexConnection> writer, reader;
+  size_t receivedBytes = 0;
+  folly::Baton<> received;
+  evb->runInEventBaseThreadAndWait([&] {
+    socket = new CountingSocket(evb, fds[0]);
+    writer = std::make_unique<TcpDuplexConnection>(
+        folly::AsyncTransportWrapper::UniquePtr(socket),
+        RSocketStats::noop(),
+        options);
+    reader = std::make_unique<TcpDuplexConnection>(
+        folly::AsyncTransportWrapper::UniquePtr(
+            new folly::AsyncSocket(evb, fds[1])));
+    reader->setInput(
+        yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>::create(
+            [&](std::unique_ptr<folly::IOBuf> buf) {
+              receivedBytes += buf->computeChainDataLength();
+              if (receivedBytes == frames * 10) {
+                received.post();
+              }
+            }));
+
+    for (size_t i = 0; i < frames; ++i) {
+      writer->send(folly::IOBuf::copyBuffer(std::string(10, 'x')));
+    }
+  });
+  EXPECT_TRUE(received.try_wait_for(std::chrono::seconds{5}));
+
+  size_t writes = 0;
+  evb->runInEventBaseThreadAndWait([&] {
+    writes = socket->writes;
+    writer.reset();
+    reader.reset();
+  });
+  return writes;
+}
+
+} // namespace
+
+TEST(TcpDuplexConnection, BatchedWritesAreCoalescedPerLoop) {
+  constexpr size_t kFrames = 10;
+  TcpDuplexConnection::Options options;
+  EXPECT_EQ(kFrames, countWrites(options, kFrames));
+
+  // Everything sent within one loop iteration goes out in a single write.
+  options.batchWrites = true;
+  options.maxBatchDelay = std::chrono::seconds{1};
+  EXPECT_EQ(1u, countWrites(options, kFrames));
+
+  // A full batch is flushed at once, without waiting for the loop to end.
+  options.maxBatchBytes = 50;
+  EXPECT_EQ(2u, countWrites(options, kFrames));
+}
+
 TEST(TcpDuplexConnection, InputAndOutputIsUntied) {
   folly::ScopedEventBaseThread worker;
   std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
@@ -110,6 +224,268 @@ TEST(TcpDuplexConnection, ConnectionAndSubscribersAreUntied) {
       worker.getEventBase());
 }
 
+TEST(TcpDuplexConnection, FrameSizedReadsPassOnWholeFrames) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  TcpDuplexConnection::Options connectionOptions;
+  connectionOptions.frameSizedReads = true;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase(),
+      connectionOptions);
+
+  // The middle frame is far larger than any read would be on its own.
+  std::vector<size_t> frameEnds;
+  folly::IOBufQueue frames{folly::IOBufQueue::cacheChainLength()};
+  for (size_t length : {10, 300 * 1024, 20}) {
+    auto frame = folly::IOBuf::create(length + 3);
+    auto const data = frame->writableData();
+    data[0] = static_cast<uint8_t>(length >> 16);
+    data[1] = static_cast<uint8_t>(length >> 8);
+    data[2] = static_cast<uint8_t>(length);
+    std::fill(data + 3, data + 3 + length, 'x');
+    frame->append(length + 3);
+    frames.append(std::move(frame));
+    frameEnds.push_back(frames.chainLength());
+  }
+  auto const totalBytes = frames.chainLength();
+
+  std::vector<std::unique_ptr<folly::IOBuf>> received;
+  size_t receivedBytes = 0;
+  folly::Baton<> done;
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    serverConnection->setInput(
+        yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>::create(
+            [&](std::unique_ptr<folly::IOBuf> buf) {
+              receivedBytes += buf->computeChainDataLength();
+              received.push_back(std::move(buf));
+              if (receivedBytes == totalBytes) {
+                done.post();
+              }
+            }));
+  });
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { clientConnection->send(frames.move()); });
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds{5}));
+
+  // Every buffer ends on a frame boundary, and the large frame is in one.
+  size_t offset = 0;
+  for (auto& buf : received) {
+    auto const start = offset;
+    offset += buf->computeChainDataLength();
+    EXPECT_NE(
+        frameEnds.end(), std::find(frameEnds.begin(), frameEnds.end(), offset));
+    if (start <= frameEnds[0] && offset >= frameEnds[1]) {
+      EXPECT_FALSE(buf->isChained());
+    }
+  }
+
+  serverEvb->runInEventBaseThreadAndWait([&] { serverConnection.reset(); });
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { clientConnection.reset(); });
+}
+
+TEST(TcpDuplexConnection, PooledReadBuffersAreRecycled) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  TcpDuplexConnection::Options connectionOptions;
+  connectionOptions.pooledReadBuffers = true;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase(),
+      connectionOptions);
+
+  constexpr size_t kMessageBytes = 1000;
+  size_t receivedBytes = 0;
+  folly::Baton<> received;
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    serverConnection->setInput(
+        yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>::create(
+            [&](std::unique_ptr<folly::IOBuf> buf) {
+              // Dropping the buffer hands its slab back to the pool.
+              receivedBytes += buf->computeChainDataLength();
+              if (receivedBytes % kMessageBytes == 0) {
+                received.post();
+              }
+            }));
+  });
+
+  auto const sendMessage = [&] {
+    received.reset();
+    worker.getEventBase()->runInEventBaseThreadAndWait([&] {
+      clientConnection->send(
+          folly::IOBuf::copyBuffer(std::string(kMessageBytes, 'x')));
+    });
+    ASSERT_TRUE(received.try_wait_for(std::chrono::seconds{5}));
+  };
+  auto const serverPoolCounters = [&] {
+    IOBufPool::Counters counters;
+    serverEvb->runInEventBaseThreadAndWait(
+        [&] { counters = IOBufPool::get().counters(); });
+    return counters;
+  };
+
+  auto const before = serverPoolCounters();
+  sendMessage();
+  sendMessage();
+  auto const after = serverPoolCounters();
+  EXPECT_LT(before.misses, after.misses);
+  EXPECT_LT(before.hits, after.hits);
+
+  serverEvb->runInEventBaseThreadAndWait([&] { serverConnection.reset(); });
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { clientConnection.reset(); });
+}
+
+namespace {
+
+/// Tracks how many bytes a connection reports as waiting to be written.
+class WriteBufferStats : public RSocketStats {
+ public:
+  void writeBufferChanged(int64_t delta) override {
+    buffered += delta;
+  }
+
+  int64_t buffered{0};
+};
+
+} // namespace
+
+TEST(TcpDuplexConnection, WritabilityFollowsWaterMarks) {
+  constexpr size_t kFrameBytes = 1 << 20;
+  constexpr size_t kFrames = 4;
+
+  int fds[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+  folly::ScopedEventBaseThread worker;
+  auto* evb = worker.getEventBase();
+  auto stats = std::make_shared<WriteBufferStats>();
+  TcpDuplexConnection::Options options;
+  options.writeHighWaterMark = kFrameBytes * 3 / 2;
+  options.writeLowWaterMark = kFrameBytes / 2;
+
+  std::unique_ptr<DuplexConnection> writer, reader;
+  std::vector<std::pair<bool, int64_t>> transitions;
+  folly::Baton<> unwritable, writable;
+  evb->runInEventBaseThreadAndWait([&] {
+    writer = std::make_unique<TcpDuplexConnection>(
+        folly::AsyncTransportWrapper::UniquePtr(
+            new folly::AsyncSocket(evb, fds[0])),
+        stats,
+        options);
+    reader = std::make_unique<TcpDuplexConnection>(
+        folly::AsyncTransportWrapper::UniquePtr(
+            new folly::AsyncSocket(evb, fds[1])));
+    writer->setWritabilityCallback([&](bool isWritable) {
+      transitions.emplace_back(isWritable, stats->buffered);
+      (isWritable ? writable : unwritable).post();
+    });
+
+    // Nobody reads yet, so every frame stays in the write buffer.  The
+    // second one crosses the high water mark, but the callback is only told
+    // from the loop, not from within send().
+    for (size_t i = 0; i < kFrames; ++i) {
+      writer->send(folly::IOBuf::copyBuffer(std::string(kFrameBytes, 'x')));
+    }
+    EXPECT_EQ(static_cast<int64_t>(kFrames * kFrameBytes), stats->buffered);
+    EXPECT_TRUE(transitions.empty());
+  });
+  ASSERT_TRUE(unwritable.try_wait_for(std::chrono::seconds{5}));
+
+  evb->runInEventBaseThreadAndWait([&] {
+    ASSERT_EQ(1u, transitions.size());
+    EXPECT_FALSE(transitions[0].first);
+    EXPECT_EQ(
+        static_cast<int64_t>(kFrames * kFrameBytes), transitions[0].second);
+
+    reader->setInput(
+        yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>::create(
+            [](std::unique_ptr<folly::IOBuf>) {}));
+  });
+  ASSERT_TRUE(writable.try_wait_for(std::chrono::seconds{5}));
+
+  evb->runInEventBaseThreadAndWait([&] {
+    // Dropping below the high water mark with one frame left is not enough;
+    // the connection only becomes writable again at the low water mark.
+    ASSERT_EQ(2u, transitions.size());
+    EXPECT_TRUE(transitions[1].first);
+    EXPECT_LE(transitions[1].second, static_cast<int64_t>(kFrameBytes / 2));
+    EXPECT_EQ(0, stats->buffered);
+
+    writer.reset();
+    reader.reset();
+  });
+}
+
+TEST(TcpDuplexConnection, RejectsLowWaterMarkAboveHighWaterMark) {
+  TcpDuplexConnection::Options options;
+  options.writeHighWaterMark = 1024;
+  options.writeLowWaterMark = 4096;
+  EXPECT_THROW(options.validate(), std::invalid_argument);
+
+  TcpConnectionAcceptor::Options acceptorOptions;
+  acceptorOptions.connection = options;
+  EXPECT_THROW(
+      TcpConnectionAcceptor{std::move(acceptorOptions)}, std::invalid_argument);
+
+  options.writeLowWaterMark = 1024;
+  EXPECT_NO_THROW(options.validate());
+}
+
+TEST(TcpConnectionAcceptor, ReusePortAcceptsOnEveryWorker) {
+  constexpr size_t kConnections = 64;
+
+  TcpConnectionAcceptor::Options options;
+  options.address = folly::SocketAddress{"127.0.0.1", 0};
+  options.threads = 4;
+  options.reusePort = true;
+  TcpConnectionAcceptor acceptor(std::move(options));
+
+  std::mutex mutex;
+  std::set<EventBase*> acceptingEventBases;
+  size_t accepted = 0;
+  folly::Baton<> done;
+  acceptor.start(
+      [&](std::unique_ptr<DuplexConnection>, EventBase& eventBase) {
+        // Connections are accepted on the worker that will run them.
+        EXPECT_TRUE(eventBase.isInEventBaseThread());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        acceptingEventBases.insert(&eventBase);
+        if (++accepted == kConnections) {
+          done.post();
+        }
+      });
+  auto const port = acceptor.listeningPort();
+  ASSERT_TRUE(port);
+
+  folly::ScopedEventBaseThread worker;
+  TcpConnectionFactory factory(
+      *worker.getEventBase(), SocketAddress("127.0.0.1", *port));
+  std::vector<std::unique_ptr<DuplexConnection>> clients;
+  for (size_t i = 0; i < kConnections; ++i) {
+    clients.push_back(
+        factory.connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+            .get()
+            .connection);
+  }
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds{5}));
+
+  // The kernel spreads the connections over the workers' sockets.
+  EXPECT_GT(acceptingEventBases.size(), 1U);
+
+  worker.getEventBase()->runInEventBaseThreadAndWait([&] { clients.clear(); });
+  acceptor.stop();
+  EXPECT_FALSE(acceptor.listeningPort());
+}
+
 TEST(TcpDuplexConnection, ExceptionWrapperTest) {
   folly::AsyncSocketException socketException(
       folly::AsyncSocketException::AsyncSocketExceptionType::INVALID_STATE,
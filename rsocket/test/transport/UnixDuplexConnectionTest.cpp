@@ -0,0 +1,186 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/unix/UnixConnectionAcceptor.h"
+#include "rsocket/transports/unix/UnixConnectionFactory.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+using namespace ::testing;
+
+namespace {
+
+std::string socketPath() {
+  static int counter = 0;
+  return folly::sformat("/tmp/rsocket-test-{}-{}.sock", ::getpid(), counter++);
+}
+
+struct sockaddr_un makeAddress(const std::string& path) {
+  struct sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+
+/// Whether a server is listening on `path`.
+bool canConnect(const std::string& path) {
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  auto addr = makeAddress(path);
+  const bool connected =
+      ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) ==
+      0;
+  ::close(fd);
+  return connected;
+}
+
+/**
+ * Synchronously create a server and a client.
+ */
+std::pair<
+    std::unique_ptr<ConnectionAcceptor>,
+    std::unique_ptr<ConnectionFactory>>
+makeSingleClientServer(
+    std::unique_ptr<DuplexConnection>& serverConnection,
+    EventBase** serverEvb,
+    std::unique_ptr<DuplexConnection>& clientConnection,
+    EventBase* clientEvb) {
+  Promise<Unit> serverPromise;
+
+  UnixConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+  options.backlog = 0;
+
+  auto server = std::make_unique<UnixConnectionAcceptor>(options);
+  server->start(
+      [&serverPromise, &serverConnection, &serverEvb](
+          std::unique_ptr<DuplexConnection> connection, EventBase& eventBase) {
+        serverConnection = std::move(connection);
+        *serverEvb = &eventBase;
+        serverPromise.setValue();
+      });
+
+  EXPECT_FALSE(server->listeningPort());
+
+  auto client =
+      std::make_unique<UnixConnectionFactory>(*clientEvb, options.path);
+  client->connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+      .thenValue([&clientConnection](
+                     ConnectionFactory::ConnectedDuplexConnection connection) {
+        clientConnection = std::move(connection.connection);
+      })
+      .wait();
+
+  serverPromise.getSemiFuture().wait();
+  return std::make_pair(std::move(server), std::move(client));
+}
+
+} // namespace
+
+TEST(UnixDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UnixDuplexConnection, InputAndOutputIsUntied) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UnixDuplexConnection, StopRemovesSocketPath) {
+  UnixConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+
+  UnixConnectionAcceptor server{options};
+  server.start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+  EXPECT_EQ(0, ::access(options.path.c_str(), F_OK));
+
+  server.stop();
+  EXPECT_NE(0, ::access(options.path.c_str(), F_OK));
+
+  // The destructor stops again, which must not touch the path.
+  server.stop();
+}
+
+TEST(UnixDuplexConnection, StartReplacesDeadSocket) {
+  UnixConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+
+  // Leave a socket file behind with nothing listening on it.
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  auto addr = makeAddress(options.path);
+  ASSERT_EQ(
+      0, ::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)));
+  ::close(fd);
+  ASSERT_FALSE(canConnect(options.path));
+
+  UnixConnectionAcceptor server{options};
+  EXPECT_NO_THROW(
+      server.start([](std::unique_ptr<DuplexConnection>, EventBase&) {}));
+}
+
+TEST(UnixDuplexConnection, StartDoesNotStealLiveSocket) {
+  UnixConnectionAcceptor::Options options;
+  options.path = socketPath();
+  options.threads = 1;
+
+  UnixConnectionAcceptor live{options};
+  live.start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+
+  {
+    UnixConnectionAcceptor second{options};
+    EXPECT_ANY_THROW(
+        second.start([](std::unique_ptr<DuplexConnection>, EventBase&) {}));
+  }
+
+  // The failed acceptor must have left the live server's path in place.
+  EXPECT_TRUE(canConnect(options.path));
+}
+
+} // namespace tests
+} // namespace rsocket
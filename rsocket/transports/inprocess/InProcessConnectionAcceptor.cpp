@@ -0,0 +1,120 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/inprocess/InProcessConnectionAcceptor.h"
+
+#include <unordered_map>
+
+#include <folly/Format.h>
+#include <folly/Synchronized.h>
+
+namespace rsocket {
+
+namespace {
+
+using Registry = folly::Synchronized<
+    std::unordered_map<std::string, InProcessConnectionAcceptor*>>;
+
+/// Started acceptors, by name.  Connecting holds the lock while handing over
+/// the server end, so an acceptor cannot be stopped midway.
+Registry& registry() {
+  static auto* registry = new Registry;
+  return *registry;
+}
+
+} // namespace
+
+InProcessConnectionAcceptor::InProcessConnectionAcceptor(Options options)
+    : options_(std::move(options)) {}
+
+InProcessConnectionAcceptor::~InProcessConnectionAcceptor() {
+  if (!workers_.empty()) {
+    stop();
+  }
+}
+
+std::unique_ptr<DuplexConnection> InProcessConnectionAcceptor::connect(
+    const std::string& name,
+    folly::EventBase& eventBase) {
+  auto acceptors = registry().rlock();
+  auto it = acceptors->find(name);
+  if (it == acceptors->end()) {
+    throw std::runtime_error(
+        folly::sformat("No in-process acceptor named '{}'", name));
+  }
+  return it->second->accept(eventBase);
+}
+
+std::unique_ptr<DuplexConnection> InProcessConnectionAcceptor::accept(
+    folly::EventBase& eventBase) {
+  auto& worker = workers_[nextWorker_++ % workers_.size()];
+  auto workerEvb = worker->getEventBase();
+
+  VLOG(2) << "Accepting in-process connection on " << options_.name;
+
+  auto connections = InProcessDuplexConnection::createPair(
+      eventBase, *workerEvb, options_.stats);
+  workerEvb->runInEventBaseThread(
+      [this, workerEvb, server = std::move(connections.second)]() mutable {
+        onAccept_(std::move(server), *workerEvb);
+      });
+  return std::move(connections.first);
+}
+
+void InProcessConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  if (onAccept_ != nullptr) {
+    throw std::runtime_error(
+        "InProcessConnectionAcceptor::start() already called");
+  }
+  if (options_.threads == 0) {
+    throw std::invalid_argument("InProcessConnectionAcceptor needs a thread");
+  }
+
+  onAccept_ = std::move(onAccept);
+
+  workers_.reserve(options_.threads);
+  for (size_t i = 0; i < options_.threads; ++i) {
+    workers_.push_back(
+        std::make_unique<folly::ScopedEventBaseThread>("rsinproc-acceptor"));
+  }
+
+  if (!registry().wlock()->emplace(options_.name, this).second) {
+    workers_.clear();
+    throw std::runtime_error(folly::sformat(
+        "In-process acceptor name '{}' is already taken", options_.name));
+  }
+
+  VLOG(1) << "Accepting in-process connections on " << options_.name
+          << " with " << options_.threads << " request threads";
+}
+
+void InProcessConnectionAcceptor::stop() {
+  VLOG(1) << "Shutting down in-process acceptor " << options_.name;
+
+  {
+    auto acceptors = registry().wlock();
+    auto it = acceptors->find(options_.name);
+    if (it != acceptors->end() && it->second == this) {
+      acceptors->erase(it);
+    }
+  }
+
+  workers_.clear();
+}
+
+folly::Optional<uint16_t> InProcessConnectionAcceptor::listeningPort() const {
+  return folly::none;
+}
+
+} // namespace rsocket
@@ -0,0 +1,102 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+
+#include <folly/io/async/ScopedEventBaseThread.h>
+
+#include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/transports/inprocess/InProcessDuplexConnection.h"
+
+namespace rsocket {
+
+/**
+ * In-process implementation of ConnectionAcceptor for use with
+ * RSocket::createServer.
+ *
+ * The acceptor listens on a name rather than an address.  An
+ * InProcessConnectionFactory created with the same name connects to it without
+ * a socket, and every frame is handed between client and server without being
+ * copied.  This is meant for services embedded in the same binary, and for
+ * measuring the library without the kernel.
+ *
+ * Construction of this does nothing.  The `start` method kicks off work.
+ */
+class InProcessConnectionAcceptor : public ConnectionAcceptor {
+ public:
+  struct Options {
+    /// Name the acceptor is registered under.  Names are unique within the
+    /// process while the acceptor is started.
+    std::string name;
+
+    /// Number of worker threads processing requests.
+    size_t threads{2};
+
+    /// Stats reported by every accepted connection.
+    std::shared_ptr<RSocketStats> stats{RSocketStats::noop()};
+  };
+
+  explicit InProcessConnectionAcceptor(Options);
+  ~InProcessConnectionAcceptor();
+
+  /**
+   * Connect to the acceptor registered under `name`.  The returned end is
+   * driven by `eventBase`, and the server end is handed to the acceptor's
+   * callback on one of its worker threads.
+   *
+   * Throws if no acceptor is started under `name`.
+   */
+  static std::unique_ptr<DuplexConnection> connect(
+      const std::string& name,
+      folly::EventBase& eventBase);
+
+  // ConnectionAcceptor overrides.
+
+  /**
+   * Start the worker threads and register the acceptor under its name.
+   *
+   * Throws if another acceptor is already registered under the same name.
+   */
+  void start(OnDuplexConnectionAccept) override;
+
+  /**
+   * Unregister the acceptor and shut down its worker threads.
+   */
+  void stop() override;
+
+  /**
+   * In-process connections have no port, so this always returns folly::none.
+   */
+  folly::Optional<uint16_t> listeningPort() const override;
+
+ private:
+  /// Create a connection pair and hand the server end to a worker.
+  std::unique_ptr<DuplexConnection> accept(folly::EventBase&);
+
+  /// Options this acceptor has been configured with.
+  const Options options_;
+
+  /// Function to run when a connection is accepted.
+  OnDuplexConnectionAccept onAccept_;
+
+  /// Threads driving the accepted connections, picked in turn.
+  std::vector<std::unique_ptr<folly::ScopedEventBaseThread>> workers_;
+
+  /// Index of the worker to hand the next connection to.
+  std::atomic<size_t> nextWorker_{0};
+};
+
+} // namespace rsocket
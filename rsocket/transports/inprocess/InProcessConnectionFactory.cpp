@@ -0,0 +1,41 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/inprocess/InProcessConnectionFactory.h"
+
+#include <folly/futures/Future.h>
+
+#include "rsocket/transports/inprocess/InProcessConnectionAcceptor.h"
+
+namespace rsocket {
+
+InProcessConnectionFactory::InProcessConnectionFactory(
+    folly::EventBase& eventBase,
+    std::string name)
+    : eventBase_(&eventBase), name_(std::move(name)) {}
+
+InProcessConnectionFactory::~InProcessConnectionFactory() = default;
+
+folly::Future<ConnectionFactory::ConnectedDuplexConnection>
+InProcessConnectionFactory::connect(
+    ProtocolVersion,
+    ResumeStatus /* unused */) {
+  return folly::via(eventBase_, [this] {
+    return ConnectedDuplexConnection{
+        InProcessConnectionAcceptor::connect(name_, *eventBase_),
+        *eventBase_};
+  });
+}
+
+} // namespace rsocket
@@ -0,0 +1,49 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/DuplexConnection.h"
+
+namespace rsocket {
+
+/**
+ * In-process implementation of ConnectionFactory for use with
+ * RSocket::createClient().
+ *
+ * Connects to the InProcessConnectionAcceptor started under the same name.
+ *
+ * Creation of this does nothing.  The `connect` method kicks off work.
+ */
+class InProcessConnectionFactory : public ConnectionFactory {
+ public:
+  InProcessConnectionFactory(folly::EventBase& eventBase, std::string name);
+  virtual ~InProcessConnectionFactory();
+
+  /**
+   * Connect to the acceptor named in the constructor.
+   *
+   * Each call to connect() creates a new connection.  The future fails if no
+   * acceptor is started under that name.
+   */
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion,
+      ResumeStatus resume) override;
+
+ private:
+  folly::EventBase* eventBase_;
+  const std::string name_;
+};
+} // namespace rsocket
@@ -0,0 +1,209 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/inprocess/InProcessDuplexConnection.h"
+
+#include <mutex>
+#include <vector>
+
+#include <folly/io/async/EventBase.h>
+#include <glog/logging.h>
+
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+/// State shared by the two ends of a connection.  Side `i` holds the frames
+/// queued for end `i`.
+class InProcessDuplexConnection::Channel
+    : public std::enable_shared_from_this<Channel> {
+ public:
+  Channel(folly::EventBase& first, folly::EventBase& second) {
+    sides_[0].evb = &first;
+    sides_[1].evb = &second;
+  }
+
+  void send(size_t from, std::unique_ptr<folly::IOBuf> buf) {
+    const auto to = 1 - from;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (sides_[from].closed || sides_[to].closed) {
+        return;
+      }
+      sides_[to].pending.push_back(std::move(buf));
+      if (sides_[to].drainScheduled) {
+        return;
+      }
+      sides_[to].drainScheduled = true;
+    }
+    scheduleDrain(to);
+  }
+
+  void close(size_t side) {
+    std::vector<std::unique_ptr<folly::IOBuf>> dropped;
+    bool schedulePeer = false;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      sides_[side].closed = true;
+      dropped = std::move(sides_[side].pending);
+      auto& peer = sides_[1 - side];
+      if (!peer.closed && !peer.drainScheduled) {
+        peer.drainScheduled = true;
+        schedulePeer = true;
+      }
+    }
+    if (auto input = std::move(sides_[side].input)) {
+      input->onComplete();
+    }
+    if (schedulePeer) {
+      scheduleDrain(1 - side);
+    }
+  }
+
+  void setInput(
+      size_t side,
+      std::shared_ptr<DuplexConnection::Subscriber> input) {
+    DCHECK(sides_[side].evb->isInEventBaseThread());
+    if (auto previous = std::move(sides_[side].input)) {
+      previous->onComplete();
+    }
+    sides_[side].input = std::move(input);
+    if (sides_[side].input) {
+      drain(side);
+    }
+  }
+
+ private:
+  struct Side {
+    /// EventBase driving this end.  Frames are delivered on its thread.
+    folly::EventBase* evb{nullptr};
+
+    /// Subscriber receiving the frames.  Only touched on `evb`'s thread.
+    std::shared_ptr<DuplexConnection::Subscriber> input;
+
+    /// Frames queued for delivery, guarded by `mutex_`.
+    std::vector<std::unique_ptr<folly::IOBuf>> pending;
+
+    /// Whether a drain of `pending` is queued on `evb`, guarded by `mutex_`.
+    bool drainScheduled{false};
+
+    /// Whether this end has been destroyed, guarded by `mutex_`.
+    bool closed{false};
+  };
+
+  class InputSubscription : public yarpl::flowable::Subscription {
+   public:
+    InputSubscription(std::shared_ptr<Channel> channel, size_t side)
+        : channel_{std::move(channel)}, side_{side} {}
+
+    void request(int64_t) noexcept override {
+      // Frames are pushed as they arrive, like every other transport.
+    }
+
+    void cancel() noexcept override {
+      if (auto channel = std::move(channel_)) {
+        channel->sides_[side_].input = nullptr;
+      }
+    }
+
+   private:
+    std::shared_ptr<Channel> channel_;
+    const size_t side_;
+  };
+
+  friend class InProcessDuplexConnection;
+
+  void scheduleDrain(size_t side) {
+    sides_[side].evb->runInEventBaseThread(
+        [self = shared_from_this(), side] { self->drain(side); });
+  }
+
+  void drain(size_t side) {
+    auto& current = sides_[side];
+    std::vector<std::unique_ptr<folly::IOBuf>> frames;
+    bool peerClosed;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      current.drainScheduled = false;
+      if (current.closed || !current.input) {
+        // Keep the frames until a subscriber shows up.
+        return;
+      }
+      frames = std::move(current.pending);
+      peerClosed = sides_[1 - side].closed;
+    }
+
+    for (auto& frame : frames) {
+      if (!current.input) {
+        return;
+      }
+      current.input->onNext(std::move(frame));
+    }
+
+    if (peerClosed) {
+      if (auto input = std::move(current.input)) {
+        input->onComplete();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  Side sides_[2];
+};
+
+std::pair<
+    std::unique_ptr<InProcessDuplexConnection>,
+    std::unique_ptr<InProcessDuplexConnection>>
+InProcessDuplexConnection::createPair(
+    folly::EventBase& firstEventBase,
+    folly::EventBase& secondEventBase,
+    std::shared_ptr<RSocketStats> stats) {
+  auto channel = std::make_shared<Channel>(firstEventBase, secondEventBase);
+  return {std::make_unique<InProcessDuplexConnection>(channel, 0, stats),
+          std::make_unique<InProcessDuplexConnection>(
+              std::move(channel), 1, std::move(stats))};
+}
+
+InProcessDuplexConnection::InProcessDuplexConnection(
+    std::shared_ptr<Channel> channel,
+    size_t side,
+    std::shared_ptr<RSocketStats> stats)
+    : channel_{std::move(channel)}, side_{side}, stats_{std::move(stats)} {
+  DCHECK_LT(side_, 2u);
+  if (stats_) {
+    stats_->duplexConnectionCreated("inprocess", this);
+  }
+}
+
+InProcessDuplexConnection::~InProcessDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("inprocess", this);
+  }
+  channel_->close(side_);
+}
+
+void InProcessDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  channel_->send(side_, std::move(buf));
+}
+
+void InProcessDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> input) {
+  if (input) {
+    input->onSubscribe(
+        std::make_shared<Channel::InputSubscription>(channel_, side_));
+  }
+  channel_->setInput(side_, std::move(input));
+}
+
+} // namespace rsocket
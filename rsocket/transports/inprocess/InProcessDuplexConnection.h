@@ -0,0 +1,71 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+/// DuplexConnection to a peer in the same process.
+///
+/// Frames are handed to the peer as they are, without copying them, and are
+/// delivered on the peer's EventBase.  A burst of frames sent during one loop
+/// is delivered by a single callback on the peer's loop.  Frame boundaries are
+/// kept, so the connection is framed.
+///
+/// Each end must be used on the thread of its EventBase, and both EventBases
+/// must outlive the two ends.  Destroying an end drops the frames still queued
+/// for it and completes its input.  The input of the other end is completed
+/// once it has consumed everything sent before.
+class InProcessDuplexConnection : public DuplexConnection {
+ public:
+  class Channel;
+
+  /// Create two connected ends, driven by `firstEventBase` and
+  /// `secondEventBase` respectively, which may be the same.
+  static std::pair<
+      std::unique_ptr<InProcessDuplexConnection>,
+      std::unique_ptr<InProcessDuplexConnection>>
+  createPair(
+      folly::EventBase& firstEventBase,
+      folly::EventBase& secondEventBase,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+
+  InProcessDuplexConnection(
+      std::shared_ptr<Channel>,
+      size_t side,
+      std::shared_ptr<RSocketStats> stats);
+  ~InProcessDuplexConnection();
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  bool isFramed() const override {
+    return true;
+  }
+
+ private:
+  const std::shared_ptr<Channel> channel_;
+  const size_t side_;
+  const std::shared_ptr<RSocketStats> stats_;
+};
+
+} // namespace rsocket
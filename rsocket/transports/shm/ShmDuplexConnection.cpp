@@ -0,0 +1,919 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <folly/Exception.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+
+#include "rsocket/transports/shm/ShmRingBuffer.h"
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+using namespace yarpl::flowable;
+
+namespace {
+
+/// Frames delivered per wakeup before yielding to the rest of the EventBase.
+constexpr size_t kMaxFramesPerWakeup = 256;
+
+constexpr size_t kEndpointDescriptors = 4;
+
+/// How long close() keeps copying queued frames into a full ring before it
+/// gives up on a peer that has stopped reading.
+constexpr std::chrono::milliseconds kCloseDrainTimeout{5000};
+
+/// Both rings of a channel, mapped into this process.  The first half of the
+/// memory holds the ring written by the initiator, the second half the ring
+/// written by its peer.
+class Mapping {
+ public:
+  explicit Mapping(int fd) {
+    struct stat st;
+    folly::checkUnixError(::fstat(fd, &st), "fstat of shared memory failed");
+    size_ = static_cast<size_t>(st.st_size);
+
+    addr_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr_ == MAP_FAILED) {
+      folly::throwSystemError("mmap of shared memory failed");
+    }
+  }
+
+  ~Mapping() {
+    ::munmap(addr_, size_);
+  }
+
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  ShmRingBuffer ring(size_t index) const {
+    return ShmRingBuffer::attach(
+        static_cast<uint8_t*>(addr_) + index * (size_ / 2));
+  }
+
+ private:
+  void* addr_;
+  size_t size_;
+};
+
+void notify(const folly::File& eventFd) {
+  const uint64_t one = 1;
+  // EAGAIN means the counter is saturated, so the peer is going to wake up
+  // anyway.
+  folly::writeNoInt(eventFd.fd(), &one, sizeof(one));
+}
+
+folly::File makeEventFd() {
+  const int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  folly::checkUnixError(fd, "eventfd failed");
+  return folly::File{fd, true};
+}
+
+} // namespace
+
+class ShmReaderWriter : public folly::EventHandler {
+  friend void intrusive_ptr_add_ref(ShmReaderWriter* x);
+  friend void intrusive_ptr_release(ShmReaderWriter* x);
+
+ public:
+  ShmReaderWriter(
+      ShmDuplexConnection::Endpoint endpoint,
+      folly::EventBase& eventBase,
+      std::shared_ptr<RSocketStats> stats,
+      ShmDuplexConnection::Options options)
+      : folly::EventHandler(&eventBase, endpoint.localWakeup.fd()),
+        eventBase_(eventBase),
+        mapping_(endpoint.memory.fd()),
+        outbound_(mapping_.ring(endpoint.initiator ? 0 : 1)),
+        inbound_(mapping_.ring(endpoint.initiator ? 1 : 0)),
+        localWakeup_(std::move(endpoint.localWakeup)),
+        remoteWakeup_(std::move(endpoint.remoteWakeup)),
+        liveness_(std::move(endpoint.liveness)),
+        stats_(std::move(stats)),
+        options_(std::move(options)),
+        peerWatcher_(*this),
+        drainTimeout_(*this) {
+    options_.validate();
+    registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+    peerWatcher_.registerHandler(folly::EventHandler::READ);
+  }
+
+  ~ShmReaderWriter() {
+    CHECK(isClosed());
+    DCHECK(!inputSubscriber_);
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+    if (inputSubscriber && isClosed()) {
+      inputSubscriber->onComplete();
+      return;
+    }
+
+    if (!inputSubscriber) {
+      inputSubscriber_ = nullptr;
+      return;
+    }
+
+    CHECK(!inputSubscriber_);
+    inputSubscriber_ = std::move(inputSubscriber);
+
+    // Frames may have arrived while nobody was reading.  Deliver them from the
+    // event loop rather than from inside setInput().
+    notify(localWakeup_);
+  }
+
+  void setWritabilityCallback(std::function<void(bool)> callback) {
+    writabilityCallback_ = std::move(callback);
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> frame) {
+    if (isClosed()) {
+      return;
+    }
+
+    const auto length = frame->computeChainDataLength();
+    if (length > outbound_.maxFrameLength()) {
+      closeErr(std::runtime_error(folly::sformat(
+          "Frame of {} bytes does not fit in a {} byte shared-memory ring",
+          length,
+          outbound_.maxFrameLength())));
+      return;
+    }
+
+    pendingWrites_.push_back(std::move(frame));
+    pendingBytesChanged(static_cast<int64_t>(length));
+    flushPendingWrites();
+  }
+
+  /// Stop accepting frames and complete the input.  Frames still queued
+  /// behind a full ring (typically the final ERROR or CANCEL) keep being
+  /// copied in as the peer makes room; the ring is closed once they are all
+  /// written, or after kCloseDrainTimeout if the peer stops reading.
+  void close() {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+    flushPendingWrites();
+    if (pendingWrites_.empty() || peerGone_) {
+      shutdown();
+    } else {
+      // The timeout keeps this object, and so the handler waiting for ring
+      // space, alive until the queue drains or the timeout fires.
+      intrusive_ptr_add_ref(this);
+      drainPending_ = true;
+      drainTimeout_.scheduleTimeout(kCloseDrainTimeout.count());
+    }
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onComplete();
+    }
+  }
+
+  void closeErr(folly::exception_wrapper ew) {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+    shutdown();
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onError(std::move(ew));
+    }
+  }
+
+ private:
+  /// Watches this side's end of the liveness socketpair, which only ever
+  /// becomes readable when the peer's end is closed.
+  class PeerWatcher : public folly::EventHandler {
+   public:
+    explicit PeerWatcher(ShmReaderWriter& owner)
+        : folly::EventHandler(&owner.eventBase_, owner.liveness_.fd()),
+          owner_(owner) {}
+
+    void handlerReady(uint16_t) noexcept override {
+      owner_.onPeerGone();
+    }
+
+   private:
+    ShmReaderWriter& owner_;
+  };
+
+  /// Gives up on a peer that stops reading while close() drains the queue.
+  class DrainTimeout : public folly::AsyncTimeout {
+   public:
+    explicit DrainTimeout(ShmReaderWriter& owner)
+        : folly::AsyncTimeout(&owner.eventBase_), owner_(owner) {}
+
+    void timeoutExpired() noexcept override {
+      if (!owner_.pendingWrites_.empty()) {
+        VLOG(1) << "Dropping " << owner_.pendingWrites_.size()
+                << " frames the shared-memory peer never read";
+      }
+      owner_.shutdown();
+    }
+
+   private:
+    ShmReaderWriter& owner_;
+  };
+
+  bool isClosed() const {
+    return closed_;
+  }
+
+  void shutdown() {
+    if (shutDown_) {
+      return;
+    }
+    shutDown_ = true;
+    if (!pendingWrites_.empty()) {
+      pendingBytesChanged(-static_cast<int64_t>(pendingBytes_));
+      pendingWrites_.clear();
+    }
+    unregisterHandler();
+    peerWatcher_.unregisterHandler();
+    outbound_.close();
+    notify(remoteWakeup_);
+    // The ring is closed first, so a peer that sees the hangup knows this
+    // side went away cleanly.
+    liveness_.close();
+
+    if (drainTimeout_.isScheduled()) {
+      drainTimeout_.cancelTimeout();
+    }
+    if (std::exchange(drainPending_, false)) {
+      // Drop the reference close() took for the drain; this may be the last.
+      intrusive_ptr_release(this);
+    }
+  }
+
+  void handlerReady(uint16_t) noexcept override {
+    // Delivering a frame can destroy the owning connection.
+    boost::intrusive_ptr<ShmReaderWriter> self{this};
+
+    uint64_t count;
+    folly::readNoInt(localWakeup_.fd(), &count, sizeof(count));
+
+    flushPendingWrites();
+    if (isClosed()) {
+      // Draining after close(): finish once the queue is written, or as soon
+      // as the peer has gone away and will never read it.
+      if (pendingWrites_.empty() || inbound_.isClosed() || peerGone_) {
+        shutdown();
+      }
+      return;
+    }
+    readFrames();
+  }
+
+  /// The peer closed its end of the liveness socketpair, or its process
+  /// exited.  Whatever it wrote before is still read; once its ring is empty
+  /// the input completes if the peer closed it, and fails otherwise.
+  void onPeerGone() {
+    boost::intrusive_ptr<ShmReaderWriter> self{this};
+    peerGone_ = true;
+    if (isClosed()) {
+      shutdown();
+      return;
+    }
+    readFrames();
+  }
+
+  /// Copy queued frames into the outbound ring until it fills up, in which
+  /// case the reader will wake this side once it has made room.
+  void flushPendingWrites() {
+    bool wrote = false;
+    while (!shutDown_ && !pendingWrites_.empty()) {
+      auto& frame = pendingWrites_.front();
+      const auto length = frame->computeChainDataLength();
+      if (!outbound_.tryWrite(*frame)) {
+        if (outbound_.waitForSpace(length)) {
+          break;
+        }
+        continue;
+      }
+      if (stats_) {
+        stats_->bytesWritten(length);
+      }
+      pendingWrites_.pop_front();
+      pendingBytesChanged(-static_cast<int64_t>(length));
+      wrote = true;
+    }
+
+    if (wrote && outbound_.consumerNeedsWakeup()) {
+      notify(remoteWakeup_);
+    }
+    if (closed_ && !shutDown_ && pendingWrites_.empty()) {
+      // close() was waiting for the queue; let go of this object now rather
+      // than when the drain timeout would have fired.
+      shutdown();
+    }
+  }
+
+  /// Accounts for frames queued by send() or copied into the ring.
+  void pendingBytesChanged(int64_t delta) {
+    pendingBytes_ += delta;
+    if (stats_) {
+      stats_->writeBufferChanged(delta);
+    }
+    updateWritability();
+  }
+
+  void updateWritability() {
+    if (options_.writeHighWaterMark == 0) {
+      return;
+    }
+    if (writable_ && pendingBytes_ > options_.writeHighWaterMark) {
+      writable_ = false;
+    } else if (!writable_ && pendingBytes_ <= options_.writeLowWaterMark) {
+      writable_ = true;
+    } else {
+      return;
+    }
+    // As on TCP, tell the callback from the loop rather than from inside
+    // send().
+    if (writabilityNotificationScheduled_ || isClosed()) {
+      return;
+    }
+    writabilityNotificationScheduled_ = true;
+    eventBase_.runInLoop([self = boost::intrusive_ptr<ShmReaderWriter>(this)] {
+      self->notifyWritability();
+    });
+  }
+
+  void notifyWritability() {
+    writabilityNotificationScheduled_ = false;
+    if (isClosed() || writable_ == notifiedWritable_) {
+      return;
+    }
+    notifiedWritable_ = writable_;
+    // Copy in case the callback replaces itself.
+    if (auto callback = writabilityCallback_) {
+      callback(writable_);
+    }
+  }
+
+  void readFrames() {
+    size_t budget = kMaxFramesPerWakeup;
+    while (!isClosed()) {
+      if (inbound_.isClosed()) {
+        close();
+        return;
+      }
+      if (!inputSubscriber_) {
+        return;
+      }
+
+      std::unique_ptr<folly::IOBuf> frame;
+      try {
+        frame = inbound_.tryRead();
+      } catch (const std::exception& exn) {
+        closeErr(folly::exception_wrapper{std::current_exception(), exn});
+        return;
+      }
+
+      if (!frame) {
+        if (peerGone_) {
+          // Drained, and the peer will never write or close the ring.
+          closeErr(std::runtime_error(
+              "Shared-memory peer went away without closing the connection"));
+          return;
+        }
+        if (inbound_.waitForData()) {
+          return;
+        }
+        continue;
+      }
+
+      if (inbound_.producerNeedsWakeup()) {
+        notify(remoteWakeup_);
+      }
+      if (stats_) {
+        stats_->bytesRead(frame->computeChainDataLength());
+      }
+      inputSubscriber_->onNext(std::move(frame));
+
+      if (--budget == 0) {
+        // Come back for the rest on the next loop iteration.
+        notify(localWakeup_);
+        return;
+      }
+    }
+  }
+
+  folly::EventBase& eventBase_;
+  const Mapping mapping_;
+  ShmRingBuffer outbound_;
+  ShmRingBuffer inbound_;
+  const folly::File localWakeup_;
+  const folly::File remoteWakeup_;
+  folly::File liveness_;
+  const std::shared_ptr<RSocketStats> stats_;
+  const ShmDuplexConnection::Options options_;
+
+  PeerWatcher peerWatcher_;
+  DrainTimeout drainTimeout_;
+
+  /// Frames waiting for room in the outbound ring, and their total size.
+  std::deque<std::unique_ptr<folly::IOBuf>> pendingWrites_;
+  size_t pendingBytes_{0};
+
+  /// Whether the pending bytes have stayed below the high-water mark since
+  /// they last drained to the low-water mark, the state last passed to the
+  /// writability callback, and whether a loop callback is on its way to pass
+  /// on a change.
+  bool writable_{true};
+  bool notifiedWritable_{true};
+  bool writabilityNotificationScheduled_{false};
+  std::function<void(bool)> writabilityCallback_;
+
+  std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+
+  /// No new frames are accepted and the input has been terminated.
+  bool closed_{false};
+
+  /// close() holds a reference until the queue drains or drainTimeout_ fires.
+  bool drainPending_{false};
+
+  /// The outbound ring is closed and the handlers unregistered.
+  bool shutDown_{false};
+
+  /// The peer's end of the liveness socketpair has been closed.
+  bool peerGone_{false};
+  int refCount_{0};
+};
+
+void intrusive_ptr_add_ref(ShmReaderWriter* x);
+  friend void intrusive_ptr_release(ShmReaderWriter* x);
+
+ public:
+  ShmReaderWriter(
+      ShmDuplexConnection::Endpoint endpoint,
+      folly::EventBase& eventBase,
+      std::shared_ptr<RSocketStats> stats)
+      : folly::EventHandler(&eventBase, endpoint.localWakeup.fd()),
+        eventBase_(eventBase),
+        mapping_(endpoint.memory.fd()),
+        outbound_(mapping_.ring(endpoint.initiator ? 0 : 1)),
+        inbound_(mapping_.ring(endpoint.initiator ? 1 : 0)),
+        localWakeup_(std::move(endpoint.localWakeup)),
+        remoteWakeup_(std::move(endpoint.remoteWakeup)),
+        stats_(std::move(stats)) {
+    registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+  }
+
+  ~ShmReaderWriter() {
+    CHECK(isClosed());
+    DCHECK(!inputSubscriber_);
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+    if (inputSubscriber && isClosed()) {
+      inputSubscriber->onComplete();
+      return;
+    }
+
+    if (!inputSubscriber) {
+      inputSubscriber_ = nullptr;
+      return;
+    }
+
+    CHECK(!inputSubscriber_);
+    inputSubscriber_ = std::move(inputSubscriber);
+
+    // Frames may have arrived while nobody was reading.  Deliver them from the
+    // event loop rather than from inside setInput().
+    notify(localWakeup_);
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> frame) {
+    if (isClosed()) {
+      return;
+    }
+
+    const auto length = frame->computeChainDataLength();
+    if (length > outbound_.maxFrameLength()) {
+      closeErr(std::runtime_error(folly::sformat(
+          "Frame of {} bytes does not fit in a {} byte shared-memory ring",
+          length,
+          outbound_.maxFrameLength())));
+      return;
+    }
+
+    pendingWrites_.push_back(std::move(frame));
+    flushPendingWrites();
+  }
+
+  /// Stop accepting frames and complete the input.  Frames still queued
+  /// behind a full ring (typically the final ERROR or CANCEL) keep being
+  /// copied in as the peer makes room; the ring is closed once they are all
+  /// written, or after kCloseDrainTimeout if the peer stops reading.
+  void close() {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+    flushPendingWrites();
+    if (pendingWrites_.empty()) {
+      shutdown();
+    } else {
+      // Keep this object, and so the handler waiting for ring space, alive
+      // until the timeout has fired.
+      eventBase_.runAfterDelay(
+          [self = boost::intrusive_ptr<ShmReaderWriter>(this)] {
+            if (!self->pendingWrites_.empty()) {
+              VLOG(1) << "Dropping " << self->pendingWrites_.size()
+                      << " frames the shared-memory peer never read";
+            }
+            self->shutdown();
+          },
+          kCloseDrainTimeout.count());
+    }
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onComplete();
+    }
+  }
+
+  void closeErr(folly::exception_wrapper ew) {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+    shutdown();
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onError(std::move(ew));
+    }
+  }
+
+ private:
+  bool isClosed() const {
+    return closed_;
+  }
+
+  void shutdown() {
+    if (shutDown_) {
+      return;
+    }
+    shutDown_ = true;
+    pendingWrites_.clear();
+    unregisterHandler();
+    outbound_.close();
+    notify(remoteWakeup_);
+  }
+
+  void handlerReady(uint16_t) noexcept override {
+    // Delivering a frame can destroy the owning connection.
+    boost::intrusive_ptr<ShmReaderWriter> self{this};
+
+    uint64_t count;
+    folly::readNoInt(localWakeup_.fd(), &count, sizeof(count));
+
+    flushPendingWrites();
+    if (isClosed()) {
+      // Draining after close(): finish once the queue is written, or as soon
+      // as the peer has gone away and will never read it.
+      if (pendingWrites_.empty() || inbound_.isClosed()) {
+        shutdown();
+      }
+      return;
+    }
+    readFrames();
+  }
+
+  /// Copy queued frames into the outbound ring until it fills up, in which
+  /// case the reader will wake this side once it has made room.
+  void flushPendingWrites() {
+    bool wrote = false;
+    while (!shutDown_ && !pendingWrites_.empty()) {
+      auto& frame = pendingWrites_.front();
+      if (!outbound_.tryWrite(*frame)) {
+        if (outbound_.waitForSpace(frame->computeChainDataLength())) {
+          break;
+        }
+        continue;
+      }
+      if (stats_) {
+        stats_->bytesWritten(frame->computeChainDataLength());
+      }
+      pendingWrites_.pop_front();
+      wrote = true;
+    }
+
+    if (wrote && outbound_.consumerNeedsWakeup()) {
+      notify(remoteWakeup_);
+    }
+  }
+
+  void readFrames() {
+    size_t budget = kMaxFramesPerWakeup;
+    while (!isClosed()) {
+      if (inbound_.isClosed()) {
+        close();
+        return;
+      }
+      if (!inputSubscriber_) {
+        return;
+      }
+
+      std::unique_ptr<folly::IOBuf> frame;
+      try {
+        frame = inbound_.tryRead();
+      } catch (const std::exception& exn) {
+        closeErr(folly::exception_wrapper{std::current_exception(), exn});
+        return;
+      }
+
+      if (!frame) {
+        if (inbound_.waitForData()) {
+          return;
+        }
+        continue;
+      }
+
+      if (inbound_.producerNeedsWakeup()) {
+        notify(remoteWakeup_);
+      }
+      if (stats_) {
+        stats_->bytesRead(frame->computeChainDataLength());
+      }
+      inputSubscriber_->onNext(std::move(frame));
+
+      if (--budget == 0) {
+        // Come back for the rest on the next loop iteration.
+        notify(localWakeup_);
+        return;
+      }
+    }
+  }
+
+  folly::EventBase& eventBase_;
+  const Mapping mapping_;
+  ShmRingBuffer outbound_;
+  ShmRingBuffer inbound_;
+  const folly::File localWakeup_;
+  const folly::File remoteWakeup_;
+  const std::shared_ptr<RSocketStats> stats_;
+
+  /// Frames waiting for room in the outbound ring.
+  std::deque<std::unique_ptr<folly::IOBuf>> pendingWrites_;
+
+  std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+
+  /// No new frames are accepted and the input has been terminated.
+  bool closed_{false};
+
+  /// The outbound ring is closed and the handler unregistered.
+  bool shutDown_{false};
+  int refCount_{0};
+};
+
+void intrusive_ptr_add_ref(ShmReaderWriter* x);
+void intrusive_ptr_release(ShmReaderWriter* x);
+
+inline void intrusive_ptr_add_ref(ShmReaderWriter* x) {
+  ++x->refCount_;
+}
+
+inline void intrusive_ptr_release(ShmReaderWriter* x) {
+  if (--x->refCount_ == 0)
+    delete x;
+}
+
+namespace {
+
+class ShmInputSubscription : public Subscription {
+ public:
+  explicit ShmInputSubscription(
+      boost::intrusive_ptr<ShmReaderWriter> shmReaderWriter)
+      : shmReaderWriter_(std::move(shmReaderWriter)) {
+    CHECK(shmReaderWriter_);
+  }
+
+  void request(int64_t n) noexcept override {
+    DCHECK(shmReaderWriter_);
+    DCHECK_EQ(n, std::numeric_limits<int64_t>::max())
+        << "ShmDuplexConnection doesnt support proper flow control";
+  }
+
+  void cancel() noexcept override {
+    shmReaderWriter_->setInput(nullptr);
+    shmReaderWriter_ = nullptr;
+  }
+
+ private:
+  boost::intrusive_ptr<ShmReaderWriter> shmReaderWriter_;
+};
+
+} // namespace
+
+std::pair<ShmDuplexConnection::Endpoint, ShmDuplexConnection::Endpoint>
+ShmDuplexConnection::createChannel(size_t ringCapacity) {
+  const int fd = ::memfd_create("rsocket-shm", MFD_CLOEXEC);
+  folly::checkUnixError(fd, "memfd_create failed");
+  folly::File memory{fd, true};
+
+  const auto ringSize = ShmRingBuffer::regionSize(ringCapacity);
+  folly::checkUnixError(
+      ::ftruncate(memory.fd(), 2 * ringSize),
+      "Sizing shared memory failed");
+
+  auto addr = static_cast<uint8_t*>(::mmap(
+      nullptr,
+      2 * ringSize,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED,
+      memory.fd(),
+      0));
+  if (addr == MAP_FAILED) {
+    folly::throwSystemError("mmap of shared memory failed");
+  }
+  ShmRingBuffer::create(addr, ringCapacity);
+  ShmRingBuffer::create(addr + ringSize, ringCapacity);
+  ::munmap(addr, 2 * ringSize);
+
+  int liveness[2];
+  folly::checkUnixError(
+      ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, liveness),
+      "socketpair failed");
+
+  Endpoint initiator;
+  initiator.memory = std::move(memory);
+  initiator.localWakeup = makeEventFd();
+  initiator.remoteWakeup = makeEventFd();
+  initiator.liveness = folly::File{liveness[0], true};
+  initiator.initiator = true;
+
+  Endpoint peer;
+  peer.memory = initiator.memory.dup();
+  peer.localWakeup = initiator.remoteWakeup.dup();
+  peer.remoteWakeup = initiator.localWakeup.dup();
+  peer.liveness = folly::File{liveness[1], true};
+
+  return std::make_pair(std::move(initiator), std::move(peer));
+}
+
+void ShmDuplexConnection::sendEndpoint(
+    int unixSocket,
+    const Endpoint& endpoint) {
+  const int fds[kEndpointDescriptors] = {endpoint.memory.fd(),
+                                         endpoint.localWakeup.fd(),
+                                         endpoint.remoteWakeup.fd(),
+                                         endpoint.liveness.fd()};
+  uint8_t initiator = endpoint.initiator ? 1 : 0;
+  struct iovec iov = {&initiator, sizeof(initiator)};
+
+  union {
+    struct cmsghdr header;
+    char buf[CMSG_SPACE(sizeof(fds))];
+  } control;
+  std::memset(&control, 0, sizeof(control));
+
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ssize_t ret;
+  do {
+    ret = ::sendmsg(unixSocket, &msg, 0);
+  } while (ret < 0 && errno == EINTR);
+  folly::checkUnixError(ret, "Sending shared-memory endpoint failed");
+}
+
+ShmDuplexConnection::Endpoint ShmDuplexConnection::receiveEndpoint(
+    int unixSocket) {
+  int fds[kEndpointDescriptors];
+  uint8_t initiator = 0;
+  struct iovec iov = {&initiator, sizeof(initiator)};
+
+  union {
+    struct cmsghdr header;
+    char buf[CMSG_SPACE(sizeof(fds))];
+  } control;
+  std::memset(&control, 0, sizeof(control));
+
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  ssize_t ret;
+  do {
+    ret = ::recvmsg(unixSocket, &msg, MSG_CMSG_CLOEXEC);
+  } while (ret < 0 && errno == EINTR);
+  folly::checkUnixError(ret, "Receiving shared-memory endpoint failed");
+
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  if (ret != 1 || !cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+    throw std::runtime_error("Malformed shared-memory endpoint");
+  }
+  std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+  Endpoint endpoint;
+  endpoint.memory = folly::File{fds[0], true};
+  endpoint.localWakeup = folly::File{fds[1], true};
+  endpoint.remoteWakeup = folly::File{fds[2], true};
+  endpoint.liveness = folly::File{fds[3], true};
+  endpoint.initiator = initiator != 0;
+  return endpoint;
+}
+
+void ShmDuplexConnection::Options::validate() const {
+  if (writeLowWaterMark > writeHighWaterMark) {
+    throw std::invalid_argument(folly::sformat(
+        "writeLowWaterMark ({}) is above writeHighWaterMark ({})",
+        writeLowWaterMark,
+        writeHighWaterMark));
+  }
+}
+
+ShmDuplexConnection::ShmDuplexConnection(
+    Endpoint endpoint,
+    folly::EventBase& eventBase,
+    std::shared_ptr<RSocketStats> stats)
+    : ShmDuplexConnection(
+          std::move(endpoint),
+          eventBase,
+          std::move(stats),
+          Options()) {}
+
+ShmDuplexConnection::ShmDuplexConnection(
+    Endpoint endpoint,
+    folly::EventBase& eventBase,
+    std::shared_ptr<RSocketStats> stats,
+    Options options)
+    : shmReaderWriter_(new ShmReaderWriter(
+          std::move(endpoint),
+          eventBase,
+          stats,
+          std::move(options))),
+      stats_(stats) {
+  if (stats_) {
+    stats_->duplexConnectionCreated("shm", this);
+  }
+}
+
+ShmDuplexConnection::~ShmDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("shm", this);
+  }
+  shmReaderWriter_->close();
+}
+
+void ShmDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  if (shmReaderWriter_) {
+    shmReaderWriter_->send(std::move(buf));
+  }
+}
+
+void ShmDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+  // we don't care if the subscriber will call request synchronously
+  inputSubscriber->onSubscribe(
+      std::make_shared<ShmInputSubscription>(shmReaderWriter_));
+  shmReaderWriter_->setInput(std::move(inputSubscriber));
+}
+
+void ShmDuplexConnection::setWritabilityCallback(
+    std::function<void(bool)> callback) {
+  shmReaderWriter_->setWritabilityCallback(std::move(callback));
+}
+} // namespace rsocket
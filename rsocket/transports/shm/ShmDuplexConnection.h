@@ -0,0 +1,121 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
+#include <folly/File.h>
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class ShmReaderWriter;
+
+/// DuplexConnection between two processes on the same host, built on a pair of
+/// ShmRingBuffers (one per direction) in a shared memfd mapping.
+///
+/// Frames are copied straight into the peer's ring, so a busy connection makes
+/// no syscalls at all.  Each side has an eventfd that the peer signals only
+/// when that side has drained its ring and gone to sleep, or is blocked waiting
+/// for ring space.  The rings keep frame boundaries, so the connection is
+/// framed and needs no FramedDuplexConnection on top.
+///
+/// Each side also holds one end of a socketpair shared with the peer.  The
+/// kernel closes it when the peer process exits, so a peer that dies without
+/// closing its ring is noticed as soon as its last frames have been read.
+///
+/// Must be created and used on the thread of the EventBase it is given.
+class ShmDuplexConnection : public DuplexConnection {
+ public:
+  /// One side of a shared-memory channel.  An endpoint can be handed to
+  /// another process with sendEndpoint()/receiveEndpoint(), or by fork().
+  /// Each process must then close the endpoint it does not use, or its copy
+  /// of the liveness socket hides the other process going away.
+  struct Endpoint {
+    /// memfd holding both rings.
+    folly::File memory;
+
+    /// eventfd this side sleeps on.
+    folly::File localWakeup;
+
+    /// eventfd the peer sleeps on.
+    folly::File remoteWakeup;
+
+    /// This side's end of a socketpair whose other end the peer holds.  It
+    /// hangs up once the peer has closed its connection or exited.
+    folly::File liveness;
+
+    /// Whether this side writes to the first ring and reads from the second.
+    bool initiator{false};
+  };
+
+  struct Options {
+    /// Bound on the bytes of frames waiting for room in the outbound ring.
+    /// Once more than `writeHighWaterMark` bytes are queued, the connection
+    /// reports itself unwritable until the queue drains to
+    /// `writeLowWaterMark`.  Zero means no bound.
+    size_t writeHighWaterMark{0};
+    size_t writeLowWaterMark{0};
+
+    /// Throws std::invalid_argument if the low water mark is above the high
+    /// one.
+    void validate() const;
+  };
+
+  /// Create the shared memory and eventfds of a new channel, with
+  /// `ringCapacity` bytes (a power of two) in each direction, and return its
+  /// two endpoints.
+  static std::pair<Endpoint, Endpoint> createChannel(
+      size_t ringCapacity = 1 << 20);
+
+  /// Pass an endpoint's descriptors over a connected Unix domain socket.
+  /// Blocks until they have been sent.
+  static void sendEndpoint(int unixSocket, const Endpoint&);
+
+  /// Receive an endpoint sent with sendEndpoint().  Blocks until it arrives.
+  static Endpoint receiveEndpoint(int unixSocket);
+
+  ShmDuplexConnection(
+      Endpoint,
+      folly::EventBase&,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+  ShmDuplexConnection(
+      Endpoint,
+      folly::EventBase&,
+      std::shared_ptr<RSocketStats> stats,
+      Options options);
+  ~ShmDuplexConnection();
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  void setWritabilityCallback(std::function<void(bool)>) override;
+
+  bool isFramed() const override {
+    return true;
+  }
+
+ private:
+  boost::intrusive_ptr<ShmReaderWriter> shmReaderWriter_;
+  std::shared_ptr<RSocketStats> stats_;
+};
+} // namespace rsocket
@@ -0,0 +1,215 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/shm/ShmRingBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+namespace rsocket {
+
+static_assert(
+    ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+    "Rings shared across processes need lock-free atomics");
+
+namespace {
+
+constexpr uint64_t kMagic = 0x72736f636b72696eULL; // "rsockrin"
+constexpr size_t kCacheLine = 64;
+constexpr size_t kLengthBytes = sizeof(uint32_t);
+constexpr size_t kAlignment = 8;
+
+size_t recordSize(size_t length) {
+  return (kLengthBytes + length + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace
+
+/// Lives at the start of the ring's memory.  The producer and consumer cursors
+/// sit on separate cache lines so the two sides don't false-share.
+struct ShmRingBuffer::Header {
+  uint64_t magic;
+  uint64_t capacity;
+
+  /// Total bytes ever written.  Only the producer stores it.
+  alignas(kCacheLine) std::atomic<uint64_t> head;
+  std::atomic<uint32_t> producerWaiting;
+  std::atomic<uint32_t> closed;
+
+  /// Total bytes ever read.  Only the consumer stores it.
+  alignas(kCacheLine) std::atomic<uint64_t> tail;
+  std::atomic<uint32_t> consumerWaiting;
+};
+
+size_t ShmRingBuffer::headerSize() {
+  return (sizeof(Header) + kCacheLine - 1) & ~(kCacheLine - 1);
+}
+
+size_t ShmRingBuffer::regionSize(size_t capacity) {
+  return headerSize() + capacity;
+}
+
+ShmRingBuffer ShmRingBuffer::create(void* region, size_t capacity) {
+  CHECK_GE(capacity, kCacheLine);
+  CHECK_EQ(capacity & (capacity - 1), 0u) << "capacity must be a power of 2";
+
+  auto header = new (region) Header;
+  header->magic = kMagic;
+  header->capacity = capacity;
+  header->head.store(0, std::memory_order_relaxed);
+  header->producerWaiting.store(0, std::memory_order_relaxed);
+  header->closed.store(0, std::memory_order_relaxed);
+  header->tail.store(0, std::memory_order_relaxed);
+  header->consumerWaiting.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  return attach(region);
+}
+
+ShmRingBuffer ShmRingBuffer::attach(void* region) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  auto header = static_cast<Header*>(region);
+  if (header->magic != kMagic) {
+    throw std::runtime_error("Memory does not hold a ShmRingBuffer");
+  }
+  return ShmRingBuffer{header, static_cast<uint8_t*>(region) + headerSize()};
+}
+
+ShmRingBuffer::ShmRingBuffer(Header* header, uint8_t* data)
+    : header_{header}, data_{data} {}
+
+size_t ShmRingBuffer::capacity() const {
+  return header_->capacity;
+}
+
+size_t ShmRingBuffer::maxFrameLength() const {
+  return capacity() - kLengthBytes;
+}
+
+size_t ShmRingBuffer::freeSpace() const {
+  const auto head = header_->head.load(std::memory_order_relaxed);
+  const auto tail = header_->tail.load(std::memory_order_seq_cst);
+  return capacity() - (head - tail);
+}
+
+bool ShmRingBuffer::tryWrite(const folly::IOBuf& frame) {
+  const size_t length = frame.computeChainDataLength();
+  DCHECK_LE(length, maxFrameLength());
+
+  const size_t size = recordSize(length);
+  if (size > freeSpace()) {
+    return false;
+  }
+
+  const auto head = header_->head.load(std::memory_order_relaxed);
+  const auto length32 = static_cast<uint32_t>(length);
+  copyIn(head, &length32, kLengthBytes);
+
+  auto position = head + kLengthBytes;
+  for (const auto range : frame) {
+    copyIn(position, range.data(), range.size());
+    position += range.size();
+  }
+
+  // Sequentially consistent so that it is ordered against the load of
+  // consumerWaiting in consumerNeedsWakeup().
+  header_->head.store(head + size, std::memory_order_seq_cst);
+  return true;
+}
+
+bool ShmRingBuffer::waitForSpace(size_t length) {
+  header_->producerWaiting.store(1, std::memory_order_seq_cst);
+  if (recordSize(length) <= freeSpace()) {
+    header_->producerWaiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRingBuffer::consumerNeedsWakeup() {
+  return header_->consumerWaiting.load(std::memory_order_seq_cst) != 0 &&
+      header_->consumerWaiting.exchange(0, std::memory_order_seq_cst) != 0;
+}
+
+void ShmRingBuffer::close() {
+  header_->closed.store(1, std::memory_order_seq_cst);
+}
+
+std::unique_ptr<folly::IOBuf> ShmRingBuffer::tryRead() {
+  const auto tail = header_->tail.load(std::memory_order_relaxed);
+  const auto head = header_->head.load(std::memory_order_acquire);
+  if (head == tail) {
+    return nullptr;
+  }
+
+  uint32_t length;
+  copyOut(tail, &length, kLengthBytes);
+  const size_t size = recordSize(length);
+  if (length > maxFrameLength() || size > head - tail) {
+    throw std::runtime_error("Corrupt frame length in ShmRingBuffer");
+  }
+
+  auto frame = folly::IOBuf::create(length);
+  copyOut(tail + kLengthBytes, frame->writableData(), length);
+  frame->append(length);
+
+  // Sequentially consistent so that it is ordered against the load of
+  // producerWaiting in producerNeedsWakeup().
+  header_->tail.store(tail + size, std::memory_order_seq_cst);
+  return frame;
+}
+
+bool ShmRingBuffer::waitForData() {
+  header_->consumerWaiting.store(1, std::memory_order_seq_cst);
+  if (header_->head.load(std::memory_order_seq_cst) !=
+          header_->tail.load(std::memory_order_relaxed) ||
+      header_->closed.load(std::memory_order_seq_cst) != 0) {
+    header_->consumerWaiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRingBuffer::producerNeedsWakeup() {
+  return header_->producerWaiting.load(std::memory_order_seq_cst) != 0 &&
+      header_->producerWaiting.exchange(0, std::memory_order_seq_cst) != 0;
+}
+
+bool ShmRingBuffer::isClosed() const {
+  return header_->closed.load(std::memory_order_acquire) != 0 &&
+      header_->head.load(std::memory_order_acquire) ==
+      header_->tail.load(std::memory_order_relaxed);
+}
+
+void ShmRingBuffer::copyIn(uint64_t position, const void* src, size_t length) {
+  const size_t offset = position & (capacity() - 1);
+  const size_t first = std::min(length, capacity() - offset);
+  std::memcpy(data_ + offset, src, first);
+  std::memcpy(data_, static_cast<const uint8_t*>(src) + first, length - first);
+}
+
+void ShmRingBuffer::copyOut(uint64_t position, void* dst, size_t length)
+    const {
+  const size_t offset = position & (capacity() - 1);
+  const size_t first = std::min(length, capacity() - offset);
+  std::memcpy(dst, data_ + offset, first);
+  std::memcpy(static_cast<uint8_t*>(dst) + first, data_, length - first);
+}
+
+} // namespace rsocket
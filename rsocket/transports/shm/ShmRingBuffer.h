@@ -0,0 +1,101 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <folly/io/IOBuf.h>
+
+namespace rsocket {
+
+/// Single-producer/single-consumer ring of frames laid out in caller-provided
+/// memory, typically a shared mapping visible to two processes.
+///
+/// Each frame is stored as a 32-bit length followed by its bytes, padded to 8
+/// bytes, so frame boundaries survive the trip.  The producer and the consumer
+/// each own one cursor and publish it with atomic stores, so neither side takes
+/// a lock or makes a syscall.  Waking a sleeping peer is left to the caller;
+/// the ring only records whether either side is about to sleep.
+class ShmRingBuffer {
+ public:
+  /// Bytes of memory needed by a ring holding `capacity` bytes of frames.
+  /// `capacity` must be a power of two, at least 64.
+  static size_t regionSize(size_t capacity);
+
+  /// Lay out an empty ring in `region`, which must be regionSize(capacity)
+  /// bytes long and 64-byte aligned.
+  static ShmRingBuffer create(void* region, size_t capacity);
+
+  /// Use a ring previously laid out by create(), possibly by another process.
+  static ShmRingBuffer attach(void* region);
+
+  /// Largest frame the ring can ever hold.
+  size_t maxFrameLength() const;
+
+  // Producer side.
+
+  /// Copy `frame` into the ring.  Returns false, copying nothing, if there is
+  /// not enough free space right now.
+  bool tryWrite(const folly::IOBuf& frame);
+
+  /// Record that the producer is waiting for space.  Returns false if room for
+  /// a `length` byte frame has freed up meanwhile and it should retry instead
+  /// of sleeping.
+  bool waitForSpace(size_t length);
+
+  /// Whether the consumer went to sleep and must be woken after a write.
+  /// Clears the flag.
+  bool consumerNeedsWakeup();
+
+  /// Mark the ring closed.  The consumer sees it once it has drained the ring.
+  void close();
+
+  // Consumer side.
+
+  /// Remove the oldest frame from the ring, or return nullptr if it is empty.
+  /// Throws if the ring holds a corrupt length.
+  std::unique_ptr<folly::IOBuf> tryRead();
+
+  /// Record that the consumer is going to sleep.  Returns false if a frame
+  /// arrived or the ring was closed meanwhile, and it should keep reading.
+  bool waitForData();
+
+  /// Whether the producer is waiting for space and must be woken after a read.
+  /// Clears the flag.
+  bool producerNeedsWakeup();
+
+  /// Whether the producer closed the ring and every frame has been read.
+  bool isClosed() const;
+
+ private:
+  struct Header;
+
+  ShmRingBuffer(Header* header, uint8_t* data);
+
+  static size_t headerSize();
+
+  size_t capacity() const;
+  size_t freeSpace() const;
+
+  void copyIn(uint64_t position, const void* src, size_t length);
+  void copyOut(uint64_t position, void* dst, size_t length) const;
+
+  Header* header_;
+  uint8_t* data_;
+};
+
+} // namespace rsocket
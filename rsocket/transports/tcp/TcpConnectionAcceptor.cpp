@@ -15,19 +15,85 @@
 #include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
 
 #include <folly/Format.h>
+#include <folly/String.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/EventBaseManager.h>
 
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 #include "rsocket/transports/tcp/TcpDuplexConnection.h"
 
 namespace rsocket {
 
+namespace {
+
+void pinToCpu(folly::EventBase& eventBase, int cpu) {
+#ifdef __linux__
+  eventBase.runInEventBaseThreadAndWait([cpu] {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (auto const err =
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+      LOG(WARNING) << "Could not pin TCP worker to CPU " << cpu << ": "
+                   << folly::errnoStr(err);
+    }
+  });
+#else
+  LOG(WARNING) << "Cannot pin TCP worker to CPU " << cpu
+               << " on this platform";
+#endif
+}
+
+} // namespace
+
 class TcpConnectionAcceptor::SocketCallback
     : public folly::AsyncServerSocket::AcceptCallback {
  public:
-  explicit SocketCallback(OnDuplexConnectionAccept& onAccept)
-      : thread_{folly::sformat("rstcp-acceptor")}, onAccept_{onAccept} {}
+  SocketCallback(
+      OnDuplexConnectionAccept& onAccept,
+      const Options& options,
+      folly::Optional<int> cpu)
+      : thread_{folly::sformat("rstcp-acceptor")},
+        onAccept_{onAccept},
+        options_{options} {
+    if (cpu) {
+      pinToCpu(*eventBase(), *cpu);
+    }
+  }
+
+  ~SocketCallback() {
+    stopListening();
+  }
+
+  /// Bind a SO_REUSEPORT socket of this worker's own to `address`, and accept
+  /// its connections directly on this worker's thread.  Returns the address
+  /// the socket is bound to.
+  folly::SocketAddress listen(const folly::SocketAddress& address) {
+    return folly::via(
+               eventBase(),
+               [this, address] {
+                 serverSocket_.reset(new folly::AsyncServerSocket(eventBase()));
+                 serverSocket_->setReusePortEnabled(true);
+                 serverSocket_->bind(address);
+                 // No EventBase, so connections are accepted inline rather
+                 // than queued to another thread.
+                 serverSocket_->addAcceptCallback(this, nullptr);
+                 serverSocket_->listen(options_.backlog);
+                 serverSocket_->startAccepting();
+                 return serverSocket_->getAddress();
+               })
+        .get();
+  }
+
+  void stopListening() {
+    eventBase()->runInEventBaseThreadAndWait(
+        [serverSocket = std::move(serverSocket_)]() {});
+  }
 
   void connectionAccepted(
       int fd,
@@ -37,7 +103,8 @@ class TcpConnectionAcceptor::SocketCallback
     folly::AsyncTransportWrapper::UniquePtr socket(
         new folly::AsyncSocket(eventBase(), fd));
 
-    auto connection = std::make_unique<TcpDuplexConnection>(std::move(socket));
+    auto connection = std::make_unique<TcpDuplexConnection>(
+        std::move(socket), options_.stats, options_.connection);
     onAccept_(std::move(connection), *eventBase());
   }
 
@@ -55,13 +122,21 @@ class TcpConnectionAcceptor::SocketCallback
 
   /// Reference to the ConnectionAcceptor's callback.
   OnDuplexConnectionAccept& onAccept_;
+
+  /// Reference to the ConnectionAcceptor's options.
+  const Options& options_;
+
+  /// This worker's own listening socket, with `reusePort`.
+  folly::AsyncServerSocket::UniquePtr serverSocket_;
 };
 
 TcpConnectionAcceptor::TcpConnectionAcceptor(Options options)
-    : options_(std::move(options)) {}
+    : options_(std::move(options)) {
+  options_.connection.validate();
+}
 
 TcpConnectionAcceptor::~TcpConnectionAcceptor() {
-  if (serverThread_) {
+  if (serverThread_ || reusePortListeningPort_) {
     stop();
     serverThread_.reset();
   }
@@ -73,16 +148,35 @@ void TcpConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
   }
 
   onAccept_ = std::move(onAccept);
-  serverThread_ =
-      std::make_unique<folly::ScopedEventBaseThread>("rstcp-listener");
 
   callbacks_.reserve(options_.threads);
   for (size_t i = 0; i < options_.threads; ++i) {
-    callbacks_.push_back(std::make_unique<SocketCallback>(onAccept_));
+    folly::Optional<int> cpu;
+    if (!options_.workerCpus.empty()) {
+      cpu = options_.workerCpus[i % options_.workerCpus.size()];
+    }
+    callbacks_.push_back(
+        std::make_unique<SocketCallback>(onAccept_, options_, cpu));
   }
 
   VLOG(1) << "Starting TCP listener on port " << options_.address.getPort()
-          << " with " << options_.threads << " request threads";
+          << " with " << options_.threads << " request threads"
+          << (options_.reusePort ? " accepting on their own sockets" : "");
+
+  if (options_.reusePort) {
+    // Bind the first socket alone, so that the rest reuse the port it picked
+    // if none was given.
+    auto address = options_.address;
+    for (auto const& callback : callbacks_) {
+      address = callback->listen(address);
+      VLOG(1) << "Listening on " << address.describe();
+    }
+    reusePortListeningPort_ = address.getPort();
+    return;
+  }
+
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rstcp-listener");
 
   serverSocket_.reset(
       new folly::AsyncServerSocket(serverThread_->getEventBase()));
@@ -112,11 +206,22 @@ void TcpConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
 void TcpConnectionAcceptor::stop() {
   VLOG(1) << "Shutting down TCP listener";
 
+  if (options_.reusePort) {
+    for (auto const& callback : callbacks_) {
+      callback->stopListening();
+    }
+    reusePortListeningPort_ = folly::none;
+    return;
+  }
+
   serverThread_->getEventBase()->runInEventBaseThreadAndWait(
       [serverSocket = std::move(serverSocket_)]() {});
 }
 
 folly::Optional<uint16_t> TcpConnectionAcceptor::listeningPort() const {
+  if (options_.reusePort) {
+    return reusePortListeningPort_;
+  }
   if (!serverSocket_) {
     return folly::none;
   }
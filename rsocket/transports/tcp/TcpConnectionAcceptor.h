@@ -18,6 +18,7 @@
 #include <folly/io/async/ScopedEventBaseThread.h>
 
 #include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
 
 namespace rsocket {
 
@@ -36,7 +37,24 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
     size_t threads{2};
 
     /// Number of connections to buffer before accept handlers process them.
-    int backlog{10};
+    /// With `reusePort`, every worker's socket has a backlog this long.
+    int backlog{1024};
+
+    /// Give every worker thread its own SO_REUSEPORT socket bound to
+    /// `address`.  The kernel then spreads new connections over the workers,
+    /// and each accepts its connections on its own thread, instead of one
+    /// listener thread accepting them all and handing them over.
+    bool reusePort{false};
+
+    /// CPUs to pin the worker threads to: worker i runs on
+    /// workerCpus[i % workerCpus.size()].  Empty leaves the workers unpinned.
+    std::vector<int> workerCpus;
+
+    /// Options applied to every accepted connection.
+    TcpDuplexConnection::Options connection;
+
+    /// Stats reported by every accepted connection.
+    std::shared_ptr<RSocketStats> stats{RSocketStats::noop()};
   };
 
   explicit TcpConnectionAcceptor(Options);
@@ -45,12 +63,13 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
   // ConnectionAcceptor overrides.
 
   /**
-   * Bind an AsyncServerSocket and start accepting TCP connections.
+   * Bind an AsyncServerSocket, or one per worker with `reusePort`, and start
+   * accepting TCP connections.
    */
   void start(OnDuplexConnectionAccept) override;
 
   /**
-   * Shutdown the AsyncServerSocket and associated listener thread.
+   * Shutdown the AsyncServerSockets and associated listener thread.
    */
   void stop() override;
 
@@ -65,7 +84,7 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
   /// Options this acceptor has been configured with.
   const Options options_;
 
-  /// The thread driving the AsyncServerSocket.
+  /// The thread driving the AsyncServerSocket.  Not used with `reusePort`.
   std::unique_ptr<folly::ScopedEventBaseThread> serverThread_;
 
   /// Function to run when a connection is accepted.
@@ -75,8 +94,11 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
   /// thread.
   std::vector<std::unique_ptr<SocketCallback>> callbacks_;
 
-  /// The socket listening for new connections.
+  /// The socket listening for new connections.  Not used with `reusePort`.
   folly::AsyncServerSocket::UniquePtr serverSocket_;
+
+  /// The port the workers' own sockets are bound to, with `reusePort`.
+  folly::Optional<uint16_t> reusePortListeningPort_;
 };
 
 } // namespace rsocket
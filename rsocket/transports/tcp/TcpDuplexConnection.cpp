@@ -14,10 +14,19 @@
 
 #include "rsocket/transports/tcp/TcpDuplexConnection.h"
 
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
 #include <folly/ExceptionWrapper.h>
+#include <folly/Format.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBase.h>
 
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/IOBufPool.h"
+#include "rsocket/internal/ReadBufferSizer.h"
 #include "yarpl/flowable/Subscription.h"
 
 namespace rsocket {
@@ -25,15 +34,25 @@ namespace rsocket {
 using namespace yarpl::flowable;
 
 class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
-                        public folly::AsyncTransportWrapper::ReadCallback {
+                        public folly::AsyncTransportWrapper::ReadCallback,
+                        public folly::EventBase::LoopCallback {
   friend void intrusive_ptr_add_ref(TcpReaderWriter* x);
   friend void intrusive_ptr_release(TcpReaderWriter* x);
 
  public:
-  explicit TcpReaderWriter(
+  TcpReaderWriter(
       folly::AsyncTransportWrapper::UniquePtr&& socket,
-      std::shared_ptr<RSocketStats> stats)
-      : socket_(std::move(socket)), stats_(std::move(stats)) {}
+      std::shared_ptr<RSocketStats> stats,
+      TcpDuplexConnection::Options options)
+      : socket_(std::move(socket)),
+        stats_(std::move(stats)),
+        options_(std::move(options)),
+        readSizer_(
+            options_.minReadSize,
+            options_.maxReadSize,
+            options_.frameSizedReads) {
+    options_.validate();
+  }
 
   ~TcpReaderWriter() {
     CHECK(isClosed());
@@ -66,21 +85,48 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
     }
   }
 
+  void setWritabilityCallback(std::function<void(bool)> callback) {
+    writabilityCallback_ = std::move(callback);
+  }
+
   void send(std::unique_ptr<folly::IOBuf> element) {
     if (isClosed()) {
       return;
     }
 
-    if (stats_) {
-      stats_->bytesWritten(element->computeChainDataLength());
+    const auto length = element->computeChainDataLength();
+    bufferedBytesChanged(static_cast<int64_t>(length));
+
+    if (!options_.batchWrites) {
+      write(std::move(element), length);
+      updateWritability();
+      return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (pendingWrites_.empty()) {
+      batchStarted_ = now;
+    }
+    pendingWrites_.append(std::move(element));
+
+    if (pendingWrites_.chainLength() >= options_.maxBatchBytes ||
+        now - batchStarted_ >= options_.maxBatchDelay) {
+      flushPendingWrites();
+      updateWritability();
+      return;
+    }
+    updateWritability();
+
+    if (!isLoopCallbackScheduled()) {
+      // The EventBase will hold a reference to this instance until it calls
+      // runLoopCallback.
+      intrusive_ptr_add_ref(this);
+      socket_->getEventBase()->runInLoop(this);
     }
-    // now AsyncSocket will hold a reference to this instance as a writer until
-    // they call writeComplete or writeErr
-    intrusive_ptr_add_ref(this);
-    socket_->writeChain(this, std::move(element));
   }
 
   void close() {
+    flushPendingWrites();
     if (auto socket = std::move(socket_)) {
       socket->close();
     }
@@ -90,6 +136,10 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
   }
 
   void closeErr(folly::exception_wrapper ew) {
+    if (!pendingWrites_.empty()) {
+      bufferedBytesChanged(-static_cast<int64_t>(pendingWrites_.chainLength()));
+      pendingWrites_.move();
+    }
     if (auto socket = std::move(socket_)) {
       socket->close();
     }
@@ -103,19 +153,158 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
     return !socket_;
   }
 
+  void write(std::unique_ptr<folly::IOBuf> buf, size_t length) {
+    if (stats_) {
+      stats_->bytesWritten(length);
+    }
+    writeLengths_.push_back(length);
+    // now AsyncSocket will hold a reference to this instance as a writer until
+    // they call writeComplete or writeErr
+    intrusive_ptr_add_ref(this);
+    socket_->writeChain(this, std::move(buf));
+  }
+
+  void flushPendingWrites() {
+    if (isClosed() || pendingWrites_.empty()) {
+      return;
+    }
+    const auto length = pendingWrites_.chainLength();
+    write(pendingWrites_.move(), length);
+  }
+
+  /// Accounts for bytes queued by send() or written out of the socket.
+  void bufferedBytesChanged(int64_t delta) {
+    bufferedBytes_ += delta;
+    if (stats_) {
+      stats_->writeBufferChanged(delta);
+    }
+  }
+
+  /// Completes the oldest write handed to the socket.  Writes complete in the
+  /// order they were made.
+  void writeDone() {
+    DCHECK(!writeLengths_.empty());
+    bufferedBytesChanged(-static_cast<int64_t>(writeLengths_.front()));
+    writeLengths_.pop_front();
+  }
+
+  void updateWritability() {
+    if (options_.writeHighWaterMark == 0) {
+      return;
+    }
+    if (writable_ && bufferedBytes_ > options_.writeHighWaterMark) {
+      writable_ = false;
+    } else if (!writable_ && bufferedBytes_ <= options_.writeLowWaterMark) {
+      writable_ = true;
+    } else {
+      return;
+    }
+    // Tell the callback from the loop rather than from inside send() or a
+    // write completion, which may be running on behalf of the callback's owner.
+    if (writabilityNotificationScheduled_ || isClosed()) {
+      return;
+    }
+    writabilityNotificationScheduled_ = true;
+    socket_->getEventBase()->runInLoop(
+        [self = boost::intrusive_ptr<TcpReaderWriter>(this)] {
+          self->notifyWritability();
+        });
+  }
+
+  void notifyWritability() {
+    writabilityNotificationScheduled_ = false;
+    // The state may have flipped back before the loop got here.
+    if (isClosed() || writable_ == notifiedWritable_) {
+      return;
+    }
+    notifiedWritable_ = writable_;
+    // Copy in case the callback replaces itself.
+    if (auto callback = writabilityCallback_) {
+      callback(writable_);
+    }
+  }
+
+  void runLoopCallback() noexcept override {
+    flushPendingWrites();
+    intrusive_ptr_release(this);
+  }
+
   void writeSuccess() noexcept override {
+    writeDone();
+    updateWritability();
     intrusive_ptr_release(this);
   }
 
   void writeErr(
       size_t,
       const folly::AsyncSocketException& exn) noexcept override {
+    writeDone();
     closeErr(folly::exception_wrapper{std::make_exception_ptr(exn), exn});
     intrusive_ptr_release(this);
   }
 
   void getReadBuffer(void** bufReturn, size_t* lenReturn) noexcept override {
-    std::tie(*bufReturn, *lenReturn) = readBuffer_.preallocate(4096, 4096);
+    auto const size = readSizer_.nextReadSize();
+    auto const minSize =
+        options_.frameSizedReads ? reserveFrameBuffer(size) : size;
+    if (options_.pooledReadBuffers && !canReadInPlace(minSize)) {
+      readBuffer_.append(createReadBuffer(std::max(size, minSize)));
+    }
+    std::tie(*bufReturn, *lenReturn) = readBuffer_.preallocate(minSize, size);
+    readData_ = static_cast<const uint8_t*>(*bufReturn);
+    readOffered_ = *lenReturn;
+  }
+
+  /// Makes sure the rest of a partially read frame can be read into the
+  /// buffer holding its start, moving the start into a new buffer if needed.
+  /// Returns the fewest bytes the next read must be offered.
+  ///
+  /// Nothing is reserved for more than maxReadSize bytes: the length prefix
+  /// alone must not make the connection allocate up to 16MB.  A larger frame
+  /// is read into buffers of the usual size until its rest fits in one read.
+  size_t reserveFrameBuffer(size_t readSize) {
+    auto const held = readSizer_.incompleteFrameBytes();
+    auto const frameSize = readSizer_.incompleteFrameSize();
+    if (held == 0 || frameSize == 0 || readBuffer_.chainLength() != held) {
+      return readSize;
+    }
+    auto const missing = frameSize - held;
+    if (missing > options_.maxReadSize) {
+      return readSize;
+    }
+
+    // The start of the frame usually shares its buffer with the frames before
+    // it, which have been passed on, so its tailroom can't be read into.
+    auto const front = readBuffer_.front();
+    if (!front->isChained() && !front->isSharedOne() &&
+        front->tailroom() >= missing) {
+      return missing;
+    }
+
+    auto frame = createReadBuffer(held + readSize);
+    folly::io::Cursor(front).pull(frame->writableData(), held);
+    frame->append(held);
+    readBuffer_.move();
+    readBuffer_.append(std::move(frame));
+    return missing;
+  }
+
+  /// Whether the last read buffer can take `size` more bytes, so preallocating
+  /// them won't allocate.
+  bool canReadInPlace(size_t size) const {
+    auto const front = readBuffer_.front();
+    if (!front) {
+      return false;
+    }
+    auto const tail = front->prev();
+    return !tail->isSharedOne() && tail->tailroom() >= size;
+  }
+
+  std::unique_ptr<folly::IOBuf> createReadBuffer(size_t size) {
+    if (options_.pooledReadBuffers) {
+      return IOBufPool::get().allocate(size, stats_.get());
+    }
+    return folly::IOBuf::create(size);
   }
 
   void readDataAvailable(size_t len) noexcept override {
@@ -123,9 +312,22 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
     if (stats_) {
       stats_->bytesRead(len);
     }
+    readSizer_.onRead(readData_, len, readOffered_);
 
-    if (inputSubscriber_) {
+    if (!inputSubscriber_) {
+      return;
+    }
+    if (!options_.frameSizedReads) {
       readBufferAvailable(readBuffer_.split(len));
+      return;
+    }
+
+    // Hold on to the incomplete frame at the end until the rest of it is
+    // read.
+    auto const complete =
+        readBuffer_.chainLength() - readSizer_.incompleteFrameBytes();
+    if (complete > 0) {
+      readBufferAvailable(readBuffer_.split(complete));
     }
   }
 
@@ -152,6 +354,31 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
   folly::IOBufQueue readBuffer_{folly::IOBufQueue::cacheChainLength()};
   folly::AsyncTransportWrapper::UniquePtr socket_;
   const std::shared_ptr<RSocketStats> stats_;
+  const TcpDuplexConnection::Options options_;
+
+  ReadBufferSizer readSizer_;
+  /// The buffer handed to the read in progress, and its size.
+  const uint8_t* readData_{nullptr};
+  size_t readOffered_{0};
+
+  /// Frames queued by send() while write batching is enabled, flushed at the
+  /// end of the current loop iteration.
+  folly::IOBufQueue pendingWrites_{folly::IOBufQueue::cacheChainLength()};
+  std::chrono::steady_clock::time_point batchStarted_;
+
+  /// Bytes handed to send() that have not been written out of the socket,
+  /// and the length of every write the socket has not completed yet.
+  size_t bufferedBytes_{0};
+  std::deque<size_t> writeLengths_;
+
+  /// Whether the buffered bytes have stayed below the high-water mark since
+  /// they last drained to the low-water mark.
+  bool writable_{true};
+  /// The state last passed to the writability callback, and whether a loop
+  /// callback is on its way to pass on a change.
+  bool notifiedWritable_{true};
+  bool writabilityNotificationScheduled_{false};
+  std::function<void(bool)> writabilityCallback_;
 
   std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
   int refCount_{0};
@@ -196,19 +423,37 @@ class TcpInputSubscription : public Subscription {
 
 } // namespace
 
+void TcpDuplexConnection::Options::validate() const {
+  if (writeLowWaterMark > writeHighWaterMark) {
+    throw std::invalid_argument(folly::sformat(
+        "writeLowWaterMark ({}) is above writeHighWaterMark ({})",
+        writeLowWaterMark,
+        writeHighWaterMark));
+  }
+}
+
 TcpDuplexConnection::TcpDuplexConnection(
     folly::AsyncTransportWrapper::UniquePtr&& socket,
     std::shared_ptr<RSocketStats> stats)
-    : tcpReaderWriter_(new TcpReaderWriter(std::move(socket), stats)),
-      stats_(stats) {
+    : TcpDuplexConnection(std::move(socket), std::move(stats), Options()) {}
+
+TcpDuplexConnection::TcpDuplexConnection(
+    folly::AsyncTransportWrapper::UniquePtr&& socket,
+    std::shared_ptr<RSocketStats> stats,
+    Options options,
+    std::string transport)
+    : tcpReaderWriter_(
+          new TcpReaderWriter(std::move(socket), stats, std::move(options))),
+      stats_(stats),
+      transport_(std::move(transport)) {
   if (stats_) {
-    stats_->duplexConnectionCreated("tcp", this);
+    stats_->duplexConnectionCreated(transport_, this);
   }
 }
 
 TcpDuplexConnection::~TcpDuplexConnection() {
   if (stats_) {
-    stats_->duplexConnectionClosed("tcp", this);
+    stats_->duplexConnectionClosed(transport_, this);
   }
   tcpReaderWriter_->close();
 }
@@ -230,4 +475,9 @@ void TcpDuplexConnection::setInput(
       std::make_shared<TcpInputSubscription>(tcpReaderWriter_));
   tcpReaderWriter_->setInput(std::move(inputSubscriber));
 }
+
+void TcpDuplexConnection::setWritabilityCallback(
+    std::function<void(bool)> callback) {
+  tcpReaderWriter_->setWritabilityCallback(std::move(callback));
+}
 } // namespace rsocket
@@ -15,6 +15,8 @@
 #pragma once
 
 #include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <chrono>
+
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTransport.h>
 
@@ -28,20 +30,70 @@ class TcpReaderWriter;
 
 class TcpDuplexConnection : public DuplexConnection {
  public:
+  struct Options {
+    /// Coalesce all frames sent during one EventBase loop iteration into a
+    /// single write on the socket.
+    bool batchWrites{false};
+
+    /// Flush a pending batch as soon as it holds at least this many bytes.
+    size_t maxBatchBytes{64 * 1024};
+
+    /// Flush a pending batch as soon as its oldest frame has waited this long,
+    /// even if the current loop iteration has not finished yet.
+    std::chrono::microseconds maxBatchDelay{1000};
+
+    /// Bounds of the buffer offered to each socket read.  Reads start at the
+    /// minimum, grow while they keep filling their buffer and shrink again
+    /// once they don't.  Bulk transfers do well with up to 1MB.
+    size_t minReadSize{4096};
+    size_t maxReadSize{64 * 1024};
+
+    /// Follow the length prefixes of the RSocket frames being read, and read
+    /// each frame into a single buffer large enough for all of it.  Frames
+    /// are passed on whole, so the framing layer never copies one that spans
+    /// several reads.
+    bool frameSizedReads{false};
+
+    /// Take read buffers from the thread's IOBufPool instead of allocating
+    /// each one, recycling them once the frames read into them are freed.
+    bool pooledReadBuffers{false};
+
+    /// Bound on the bytes waiting to be written.  Once more than
+    /// `writeHighWaterMark` bytes are queued, the connection reports itself
+    /// unwritable and streams stop asking their publishers for more, until
+    /// the queue drains to `writeLowWaterMark`.  Zero means no bound.
+    size_t writeHighWaterMark{0};
+    size_t writeLowWaterMark{0};
+
+    /// Throws std::invalid_argument if the options contradict each other,
+    /// e.g. a low water mark above the high one.
+    void validate() const;
+  };
+
   explicit TcpDuplexConnection(
       folly::AsyncTransportWrapper::UniquePtr&& socket,
       std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+  TcpDuplexConnection(
+      folly::AsyncTransportWrapper::UniquePtr&& socket,
+      std::shared_ptr<RSocketStats> stats,
+      Options options,
+      std::string transport = "tcp");
   ~TcpDuplexConnection();
 
   void send(std::unique_ptr<folly::IOBuf>) override;
 
   void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
 
+  void setWritabilityCallback(std::function<void(bool)>) override;
+
   // Only to be used for observation purposes.
   folly::AsyncTransportWrapper* getTransport();
 
  private:
   boost::intrusive_ptr<TcpReaderWriter> tcpReaderWriter_;
   std::shared_ptr<RSocketStats> stats_;
+
+  /// Transport name reported to RSocketStats, e.g. "tcp" or "unix".
+  const std::string transport_;
 };
 } // namespace rsocket
@@ -0,0 +1,190 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/unix/UnixConnectionAcceptor.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/AsyncSocket.h>
+
+namespace rsocket {
+
+namespace {
+
+/// Whether nothing is listening on the socket at `path`, i.e. connecting to
+/// it is refused.  The probe does not block, so a live server with a full
+/// backlog counts as alive.
+bool isSocketDead(const std::string& path) {
+  struct sockaddr_un addr;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.data(), path.size());
+
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  ::fcntl(fd, F_SETFL, O_NONBLOCK);
+  const int rv =
+      ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+  const bool refused = rv != 0 && errno == ECONNREFUSED;
+  ::close(fd);
+  return refused;
+}
+
+/// Remove a socket left behind at `path` by a server that did not shut down
+/// cleanly.  Anything that is not a socket, or a socket some other server is
+/// still listening on, is left alone so that bind() fails loudly instead of
+/// stealing the path.
+void removeStaleSocket(const std::string& path) {
+  struct stat st;
+  if (::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode) &&
+      isSocketDead(path)) {
+    VLOG(1) << "Removing stale Unix socket " << path;
+    ::unlink(path.c_str());
+  }
+}
+
+} // namespace
+
+class UnixConnectionAcceptor::SocketCallback
+    : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  SocketCallback(OnDuplexConnectionAccept& onAccept, const Options& options)
+      : thread_{folly::sformat("rsunix-acceptor")},
+        onAccept_{onAccept},
+        options_{options} {}
+
+  void connectionAccepted(
+      int fd,
+      const folly::SocketAddress&) noexcept override {
+    VLOG(2) << "Accepting Unix connection on " << options_.path << " on FD "
+            << fd;
+
+    folly::AsyncTransportWrapper::UniquePtr socket(
+        new folly::AsyncSocket(eventBase(), fd));
+
+    auto connection = std::make_unique<TcpDuplexConnection>(
+        std::move(socket), options_.stats, options_.connection, "unix");
+    onAccept_(std::move(connection), *eventBase());
+  }
+
+  void acceptError(const std::exception& ex) noexcept override {
+    VLOG(2) << "Unix socket error: " << ex.what();
+  }
+
+  folly::EventBase* eventBase() const {
+    return thread_.getEventBase();
+  }
+
+ private:
+  /// The thread running this callback.
+  folly::ScopedEventBaseThread thread_;
+
+  /// Reference to the ConnectionAcceptor's callback.
+  OnDuplexConnectionAccept& onAccept_;
+
+  /// Reference to the ConnectionAcceptor's options.
+  const Options& options_;
+};
+
+UnixConnectionAcceptor::UnixConnectionAcceptor(Options options)
+    : options_(std::move(options)) {
+  options_.connection.validate();
+}
+
+UnixConnectionAcceptor::~UnixConnectionAcceptor() {
+  if (serverThread_) {
+    stop();
+    serverThread_.reset();
+  }
+}
+
+void UnixConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  if (onAccept_ != nullptr) {
+    throw std::runtime_error("UnixConnectionAcceptor::start() already called");
+  }
+
+  onAccept_ = std::move(onAccept);
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rsunix-listener");
+
+  callbacks_.reserve(options_.threads);
+  for (size_t i = 0; i < options_.threads; ++i) {
+    callbacks_.push_back(
+        std::make_unique<SocketCallback>(onAccept_, options_));
+  }
+
+  VLOG(1) << "Starting Unix listener on " << options_.path << " with "
+          << options_.threads << " request threads";
+
+  serverSocket_.reset(
+      new folly::AsyncServerSocket(serverThread_->getEventBase()));
+
+  // The AsyncServerSocket needs to be accessed from the listener thread only.
+  // This will propagate out any exceptions the listener throws.
+  folly::via(
+      serverThread_->getEventBase(),
+      [this] {
+        removeStaleSocket(options_.path);
+        serverSocket_->bind(folly::SocketAddress::makeFromPath(options_.path));
+
+        for (auto const& callback : callbacks_) {
+          serverSocket_->addAcceptCallback(
+              callback.get(), callback->eventBase());
+        }
+
+        serverSocket_->listen(options_.backlog);
+        serverSocket_->startAccepting();
+        started_ = true;
+
+        VLOG(1) << "Listening on " << options_.path;
+      })
+      .get();
+}
+
+void UnixConnectionAcceptor::stop() {
+  if (!serverThread_) {
+    return;
+  }
+
+  VLOG(1) << "Shutting down Unix listener";
+
+  serverThread_->getEventBase()->runInEventBaseThreadAndWait(
+      [serverSocket = std::move(serverSocket_)]() {});
+
+  // Only unlink the path if this acceptor bound it, and only once.
+  if (started_) {
+    started_ = false;
+    removeStaleSocket(options_.path);
+  }
+}
+
+folly::Optional<uint16_t> UnixConnectionAcceptor::listeningPort() const {
+  return folly::none;
+}
+
+} // namespace rsocket
@@ -0,0 +1,101 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+
+#include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
+
+namespace rsocket {
+
+/**
+ * Unix domain socket implementation of ConnectionAcceptor for use with
+ * RSocket::createServer.
+ *
+ * Accepted sockets are driven by the same DuplexConnection as TCP, but skip the
+ * loopback network stack, which makes this the cheaper choice for peers on the
+ * same host.
+ *
+ * Construction of this does nothing.  The `start` method kicks off work.
+ */
+class UnixConnectionAcceptor : public ConnectionAcceptor {
+ public:
+  struct Options {
+    /// Filesystem path of the socket to listen on.  A stale socket left at
+    /// this path by a previous server is removed before binding.
+    std::string path;
+
+    /// Number of worker threads processing requests.
+    size_t threads{2};
+
+    /// Number of connections to buffer before accept handlers process them.
+    int backlog{10};
+
+    /// Options applied to every accepted connection.
+    TcpDuplexConnection::Options connection;
+
+    /// Stats reported by every accepted connection.
+    std::shared_ptr<RSocketStats> stats{RSocketStats::noop()};
+  };
+
+  explicit UnixConnectionAcceptor(Options);
+  ~UnixConnectionAcceptor();
+
+  // ConnectionAcceptor overrides.
+
+  /**
+   * Bind an AsyncServerSocket to the socket path and start accepting
+   * connections.
+   */
+  void start(OnDuplexConnectionAccept) override;
+
+  /**
+   * Shutdown the AsyncServerSocket and associated listener thread, and remove
+   * the socket path.  Safe to call more than once.
+   */
+  void stop() override;
+
+  /**
+   * Unix domain sockets have no port, so this always returns folly::none.
+   */
+  folly::Optional<uint16_t> listeningPort() const override;
+
+ private:
+  class SocketCallback;
+
+  /// Options this acceptor has been configured with.
+  const Options options_;
+
+  /// The thread driving the AsyncServerSocket.
+  std::unique_ptr<folly::ScopedEventBaseThread> serverThread_;
+
+  /// Function to run when a connection is accepted.
+  OnDuplexConnectionAccept onAccept_;
+
+  /// The callbacks handling accepted connections.  Each has its own worker
+  /// thread.
+  std::vector<std::unique_ptr<SocketCallback>> callbacks_;
+
+  /// The socket listening for new connections.
+  folly::AsyncServerSocket::UniquePtr serverSocket_;
+
+  /// Whether serverSocket_ bound the socket path.  Written on the listener
+  /// thread during start(), read by stop() after start() has returned.
+  bool started_{false};
+};
+
+} // namespace rsocket
@@ -0,0 +1,106 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/unix/UnixConnectionFactory.h"
+
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <glog/logging.h>
+
+namespace rsocket {
+
+namespace {
+
+class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
+ public:
+  ConnectCallback(
+      folly::SocketAddress address,
+      TcpDuplexConnection::Options connectionOptions,
+      folly::Promise<ConnectionFactory::ConnectedDuplexConnection>
+          connectPromise)
+      : address_(std::move(address)),
+        connectionOptions_(std::move(connectionOptions)),
+        connectPromise_(std::move(connectPromise)) {
+    VLOG(2) << "Constructing ConnectCallback";
+
+    // Set up by ScopedEventBaseThread.
+    auto evb = folly::EventBaseManager::get()->getExistingEventBase();
+    DCHECK(evb);
+
+    socket_.reset(new folly::AsyncSocket(evb));
+
+    VLOG(3) << "Attempting connection to " << address_;
+
+    socket_->connect(this, address_);
+  }
+
+  ~ConnectCallback() {
+    VLOG(2) << "Destroying ConnectCallback";
+  }
+
+  void connectSuccess() noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectSuccess() on " << address_;
+
+    auto connection = std::make_unique<TcpDuplexConnection>(
+        std::move(socket_),
+        RSocketStats::noop(),
+        connectionOptions_,
+        "unix");
+    auto evb = folly::EventBaseManager::get()->getExistingEventBase();
+    CHECK(evb);
+    connectPromise_.setValue(ConnectionFactory::ConnectedDuplexConnection{
+        std::move(connection), *evb});
+  }
+
+  void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectErr(" << ex.what() << ") on " << address_;
+    connectPromise_.setException(ex);
+  }
+
+ private:
+  const folly::SocketAddress address_;
+  const TcpDuplexConnection::Options connectionOptions_;
+  folly::AsyncSocket::UniquePtr socket_;
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise_;
+};
+
+} // namespace
+
+UnixConnectionFactory::UnixConnectionFactory(
+    folly::EventBase& eventBase,
+    std::string path,
+    TcpDuplexConnection::Options connectionOptions)
+    : eventBase_(&eventBase),
+      address_(folly::SocketAddress::makeFromPath(path)),
+      connectionOptions_(std::move(connectionOptions)) {
+  connectionOptions_.validate();
+}
+
+UnixConnectionFactory::~UnixConnectionFactory() = default;
+
+folly::Future<ConnectionFactory::ConnectedDuplexConnection>
+UnixConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise;
+  auto connectFuture = connectPromise.getFuture();
+
+  eventBase_->runInEventBaseThread(
+      [this, promise = std::move(connectPromise)]() mutable {
+        new ConnectCallback(address_, connectionOptions_, std::move(promise));
+      });
+  return connectFuture;
+}
+
+} // namespace rsocket
@@ -0,0 +1,54 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/SocketAddress.h>
+
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
+
+namespace rsocket {
+
+/**
+ * Unix domain socket implementation of ConnectionFactory for use with
+ * RSocket::createClient().
+ *
+ * Creation of this does nothing.  The `connect` method kicks off work.
+ */
+class UnixConnectionFactory : public ConnectionFactory {
+ public:
+  UnixConnectionFactory(
+      folly::EventBase& eventBase,
+      std::string path,
+      TcpDuplexConnection::Options connectionOptions =
+          TcpDuplexConnection::Options());
+  virtual ~UnixConnectionFactory();
+
+  /**
+   * Connect to the socket path defined in constructor.
+   *
+   * Each call to connect() creates a new AsyncSocket.
+   */
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion,
+      ResumeStatus resume) override;
+
+ private:
+  folly::EventBase* eventBase_;
+  const folly::SocketAddress address_;
+  const TcpDuplexConnection::Options connectionOptions_;
+};
+} // namespace rsocket
@@ -14,35 +14,68 @@
 
 #pragma once
 
-#include <folly/Synchronized.h>
 #include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace yarpl {
 
+/// A shared_ptr that can be loaded and replaced concurrently.
+///
+/// Loads and exchanges are serialized by a mutex.  The pointer is also
+/// published as a raw atomic pointer, which `get()` reads without locking or
+/// writing any shared state.  An exchange swaps the raw pointer straight from
+/// the old value to the new one, so `get()` never sees a transient null.
 template <typename T>
-struct AtomicReference {
-  folly::Synchronized<std::shared_ptr<T>, std::mutex> ref;
-
+class AtomicReference {
+ public:
   AtomicReference() = default;
 
-  AtomicReference(std::shared_ptr<T>&& r) {
-    *(ref.lock()) = std::move(r);
+  AtomicReference(std::shared_ptr<T>&& r)
+      : ref_(std::move(r)), raw_(ref_.get()) {}
+
+  AtomicReference(const AtomicReference&) = delete;
+  AtomicReference& operator=(const AtomicReference&) = delete;
+
+  AtomicReference& operator=(std::shared_ptr<T> r) {
+    exchange(std::move(r));
+    return *this;
+  }
+
+  std::shared_ptr<T> load() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ref_;
   }
+
+  /// The current pointer, without taking a reference to it.  Only use it to
+  /// test for null, or when something else keeps the pointee alive.
+  T* get() const {
+    return raw_.load(std::memory_order_acquire);
+  }
+
+  std::shared_ptr<T> exchange(std::shared_ptr<T> r) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(ref_, r);
+    raw_.store(ref_.get(), std::memory_order_release);
+    return r;
+  }
+
+ private:
+  std::shared_ptr<T> ref_;
+  std::atomic<T*> raw_{nullptr};
+  mutable std::mutex mutex_;
 };
 
 template <typename T>
 std::shared_ptr<T> atomic_load(AtomicReference<T>* ar) {
-  return *(ar->ref.lock());
+  return ar->load();
 }
 
 template <typename T>
 std::shared_ptr<T> atomic_exchange(
     AtomicReference<T>* ar,
     std::shared_ptr<T> r) {
-  auto refptr = ar->ref.lock();
-  auto old = std::move(*refptr);
-  *refptr = std::move(r);
-  return std::move(old);
+  return ar->exchange(std::move(r));
 }
 
 template <typename T>
@@ -52,7 +85,7 @@ std::shared_ptr<T> atomic_exchange(AtomicReference<T>* ar, std::nullptr_t) {
 
 template <typename T>
 void atomic_store(AtomicReference<T>* ar, std::shared_ptr<T> r) {
-  *ar->ref.lock() = std::move(r);
+  ar->exchange(std::move(r));
 }
 
 class enable_get_ref : public std::enable_shared_from_this<enable_get_ref> {
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <atomic>
+
+#include <folly/Optional.h>
+#include <folly/concurrency/UnboundedQueue.h>
+
 namespace yarpl {
 namespace flowable {
 namespace detail {
@@ -38,6 +43,12 @@ class ObserveOnOperatorSubscription : public yarpl::flowable::Subscription,
   std::shared_ptr<Subscription> subscription_;
 };
 
+/// Hands upstream signals over to `executor_`.
+///
+/// Upstream signals are serialized, so elements go through a single-producer
+/// single-consumer lock-free queue.  A counter of pending signals makes sure at
+/// most one drain task is queued on the executor at a time; that task delivers
+/// every element available, and picks up any that arrive while it runs.
 template <typename T>
 class ObserveOnOperatorSubscriber : public yarpl::flowable::Subscriber<T>,
                                     public yarpl::enable_get_ref {
@@ -57,34 +68,75 @@ class ObserveOnOperatorSubscriber : public yarpl::flowable::Subscriber<T>,
     });
   }
   void onNext(T next) override {
-    executor_->add(
-        [self = this->ref_from_this(this), n = std::move(next)]() mutable {
-          if (auto& inner = self->inner_) {
-            inner->onNext(std::move(n));
-          }
-        });
+    queue_.enqueue(folly::Optional<T>(std::move(next)));
+    scheduleDrain();
   }
   void onComplete() override {
-    executor_->add([self = this->ref_from_this(this)]() mutable {
-      if (auto inner = std::exchange(self->inner_, nullptr)) {
-        inner->onComplete();
-      }
-    });
+    done_.store(true, std::memory_order_release);
+    scheduleDrain();
   }
   void onError(folly::exception_wrapper err) override {
-    executor_->add(
-        [self = this->ref_from_this(this), e = std::move(err)]() mutable {
-          if (auto inner = std::exchange(self->inner_, nullptr)) {
-            inner->onError(std::move(e));
-          }
-        });
+    error_ = std::move(err);
+    done_.store(true, std::memory_order_release);
+    scheduleDrain();
   }
 
  private:
   friend class ObserveOnOperatorSubscription<T>;
 
+  void scheduleDrain() {
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+      executor_->add([self = this->ref_from_this(this)] { self->drain(); });
+    }
+  }
+
+  // called from 'executor_'
+  void drain() {
+    uint64_t missed = 1;
+    do {
+      deliverAvailable();
+      missed = pending_.fetch_sub(missed, std::memory_order_acq_rel) - missed;
+    } while (missed != 0);
+  }
+
+  void deliverAvailable() {
+    // Read before draining the queue: once upstream is done, every element it
+    // sent is already in the queue.
+    const bool done = done_.load(std::memory_order_acquire);
+
+    folly::Optional<T> next;
+    while (queue_.try_dequeue(next)) {
+      // Elements that arrive after a cancel are dropped.
+      if (auto& inner = inner_) {
+        inner->onNext(std::move(*next));
+      }
+    }
+
+    if (done) {
+      if (auto inner = std::exchange(inner_, nullptr)) {
+        if (error_) {
+          inner->onError(std::move(error_));
+        } else {
+          inner->onComplete();
+        }
+      }
+    }
+  }
+
   std::shared_ptr<Subscriber<T>> inner_;
   folly::Executor::KeepAlive<> executor_;
+
+  /// Elements received from upstream and not yet delivered.  Aligned to no
+  /// more than malloc() guarantees, as make_shared allocates this subscriber.
+  folly::USPSCQueue<folly::Optional<T>, false, 8, 4> queue_;
+
+  /// Signals received since the drain task last caught up.  The signal that
+  /// moves it off zero schedules the drain task.
+  std::atomic<uint64_t> pending_{0};
+
+  /// Set by upstream's terminal signal, after `error_`.
+  std::atomic<bool> done_{false};
+  folly::exception_wrapper error_;
 };
 
 template <typename T>
@@ -103,7 +103,7 @@ class BaseSubscriber : public Subscriber<T>, public yarpl::enable_get_ref {
   // methods SHOULD ensure that these are invoked as well.
   void onSubscribe(std::shared_ptr<Subscription> subscription) final override {
     CHECK(subscription);
-    CHECK(!yarpl::atomic_load(&subscription_));
+    CHECK(!subscription_.get());
 
 #ifndef NDEBUG
     DCHECK(!gotOnSubscribe_.exchange(true))
@@ -155,7 +155,9 @@ class BaseSubscriber : public Subscriber<T>, public yarpl::enable_get_ref {
     }
 #endif
 
-    if (auto sub = yarpl::atomic_load(&subscription_)) {
+    // onNext is the hot path and never touches the subscription, so only check
+    // that we are still subscribed rather than copying the shared_ptr.
+    if (subscription_.get()) {
       KEEP_REF_TO_THIS();
       onNextImpl(std::move(t));
     }
@@ -176,6 +178,9 @@ class BaseSubscriber : public Subscriber<T>, public yarpl::enable_get_ref {
   }
 
   void request(int64_t n) {
+    // Unlike onNext, this calls into the subscription, so it needs a strong
+    // reference: with only get(), a concurrent cancel() could drop the last
+    // one while request() is still running on it.
     if (auto sub = yarpl::atomic_load(&subscription_)) {
       KEEP_REF_TO_THIS();
       sub->request(n);
@@ -0,0 +1,63 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+#include "yarpl/Flowable.h"
+
+using namespace yarpl::flowable;
+
+/*
+ * Cost of the subscription reference that every BaseSubscriber touches on
+ * each signal, and of the per-element path through a subscriber.
+ */
+
+static void AtomicReference_Load(benchmark::State& state) {
+  yarpl::AtomicReference<int> ref{std::make_shared<int>(1)};
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(yarpl::atomic_load(&ref));
+  }
+}
+BENCHMARK(AtomicReference_Load)->ThreadRange(1, 8);
+
+// The lock-free check BaseSubscriber::onNext makes instead of a load.
+static void AtomicReference_Get(benchmark::State& state) {
+  static yarpl::AtomicReference<int> ref{std::make_shared<int>(1)};
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(ref.get());
+  }
+}
+BENCHMARK(AtomicReference_Get)->ThreadRange(1, 8);
+
+static void BaseSubscriber_OnNext(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    Flowable<>::range(1, state.range(0))->subscribe([](int64_t value) {
+      benchmark::DoNotOptimize(value);
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BaseSubscriber_OnNext)->Arg(100)->Arg(10000);
+
+static void BaseSubscriber_OnNextRequestOne(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    Flowable<>::range(1, state.range(0))
+        ->subscribe(
+            [](int64_t value) { benchmark::DoNotOptimize(value); },
+            1 /* batch */);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BaseSubscriber_OnNextRequestOne)->Arg(100)->Arg(10000);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,60 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include "yarpl/Flowable.h"
+
+using namespace yarpl::flowable;
+
+/*
+ * Throughput of a stream that hops from a producer thread to a consumer
+ * thread through observeOn, against the same stream consumed in place.
+ */
+
+static void runRange(
+    benchmark::State& state,
+    folly::EventBase& producer,
+    folly::EventBase* consumer) {
+  while (state.KeepRunning()) {
+    folly::Baton<> done;
+    auto flowable =
+        Flowable<>::range(1, state.range(0))->subscribeOn(producer);
+    if (consumer) {
+      flowable = flowable->observeOn(*consumer);
+    }
+    flowable->subscribe(
+        [](int64_t value) { benchmark::DoNotOptimize(value); },
+        [&](folly::exception_wrapper) { done.post(); },
+        [&] { done.post(); });
+    done.wait();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void Flowable_Range_SameThread(benchmark::State& state) {
+  folly::ScopedEventBaseThread producer;
+  runRange(state, *producer.getEventBase(), nullptr);
+}
+BENCHMARK(Flowable_Range_SameThread)->Arg(100)->Arg(10000)->Arg(1000000);
+
+static void Flowable_Range_ObserveOn(benchmark::State& state) {
+  folly::ScopedEventBaseThread producer;
+  folly::ScopedEventBaseThread consumer;
+  runRange(state, *producer.getEventBase(), consumer.getEventBase());
+}
+BENCHMARK(Flowable_Range_ObserveOn)->Arg(100)->Arg(10000)->Arg(1000000);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,122 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "yarpl/Refcounted.h"
+
+using namespace yarpl;
+
+TEST(AtomicReference, LoadStoreExchange) {
+  AtomicReference<int> ref;
+  EXPECT_EQ(nullptr, atomic_load(&ref));
+  EXPECT_EQ(nullptr, ref.get());
+
+  atomic_store(&ref, std::make_shared<int>(1));
+  EXPECT_EQ(1, *atomic_load(&ref));
+  EXPECT_EQ(1, *ref.get());
+
+  auto old = atomic_exchange(&ref, std::make_shared<int>(2));
+  EXPECT_EQ(1, *old);
+  EXPECT_EQ(2, *atomic_load(&ref));
+
+  old = atomic_exchange(&ref, nullptr);
+  EXPECT_EQ(2, *old);
+  EXPECT_EQ(nullptr, atomic_load(&ref));
+  EXPECT_EQ(nullptr, atomic_exchange(&ref, nullptr));
+}
+
+TEST(AtomicReference, AssignFromSharedPtr) {
+  auto value = std::make_shared<int>(7);
+  AtomicReference<int> ref{nullptr};
+  ref = value;
+  EXPECT_EQ(value, atomic_load(&ref));
+  EXPECT_EQ(2, value.use_count());
+}
+
+TEST(AtomicReference, ConcurrentLoadsSeeLiveValues) {
+  struct Value {
+    explicit Value(int n) : n(n) {}
+    ~Value() {
+      n = -1;
+    }
+    int n;
+  };
+
+  AtomicReference<Value> ref{std::make_shared<Value>(0)};
+  std::atomic<bool> stop{false};
+  std::atomic<int> badReads{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        if (auto value = atomic_load(&ref)) {
+          if (value->n < 0) {
+            ++badReads;
+          }
+        }
+      }
+    });
+  }
+
+  for (int i = 1; i <= 20000; ++i) {
+    if (i % 3 == 0) {
+      atomic_exchange(&ref, nullptr);
+    } else {
+      atomic_store(&ref, std::make_shared<Value>(i));
+    }
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(0, badReads.load());
+}
+
+TEST(AtomicReference, ExchangeNeverExposesNull) {
+  AtomicReference<int> ref{std::make_shared<int>(0)};
+  std::atomic<bool> stop{false};
+  std::atomic<int> nullReads{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        if (!ref.get()) {
+          ++nullReads;
+        }
+        if (!atomic_load(&ref)) {
+          ++nullReads;
+        }
+      }
+    });
+  }
+
+  // Writers keep up with readers hammering load() and get().
+  for (int i = 1; i <= 20000; ++i) {
+    atomic_store(&ref, std::make_shared<int>(i));
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(0, nullReads.load());
+  EXPECT_EQ(20000, *atomic_load(&ref));
+}
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <folly/executors/ManualExecutor.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
@@ -217,3 +218,40 @@ TEST(FlowableTests, EarlyCancelObserveOn) {
 
   subscriber_complete.timed_wait(timeout);
 }
+
+TEST(FlowableTests, ObserveOnDeliversEveryElementInOrder) {
+  constexpr int64_t kElements = 100000;
+  folly::ScopedEventBaseThread producer_eb;
+  folly::ScopedEventBaseThread subscriber_eb;
+
+  auto subscriber = std::make_shared<TestSubscriber<int64_t>>();
+  Flowable<>::range(1, kElements)
+      ->subscribeOn(*producer_eb.getEventBase())
+      ->observeOn(*subscriber_eb.getEventBase())
+      ->subscribe(subscriber);
+
+  subscriber->awaitTerminalEvent(std::chrono::seconds{5});
+  EXPECT_TRUE(subscriber->isComplete());
+  ASSERT_EQ(kElements, subscriber->getValueCount());
+  for (int64_t i = 0; i < kElements; ++i) {
+    ASSERT_EQ(i + 1, subscriber->values()[i]);
+  }
+}
+
+TEST(FlowableTests, ObserveOnDrainsBurstInOneTask) {
+  folly::ManualExecutor executor;
+
+  auto subscriber = std::make_shared<TestSubscriber<int64_t>>();
+  Flowable<>::range(1, 100)->observeOn(executor)->subscribe(subscriber);
+
+  size_t tasks = 0;
+  while (auto ran = executor.run()) {
+    tasks += ran;
+  }
+
+  // One task for onSubscribe, and a single drain for all 100 elements and the
+  // completion that range() emits synchronously once requested.
+  EXPECT_EQ(2u, tasks);
+  EXPECT_EQ(100, subscriber->getValueCount());
+  EXPECT_TRUE(subscriber->isComplete());
+}